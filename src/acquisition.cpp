@@ -0,0 +1,142 @@
+#include "acquisition.h"
+#include "nodeConfig.h"
+#include "metrics.h"
+#include "heatIndex.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+void readSensorData(const SensorHal& hal, uint64_t timestamp, JsonDocument& doc, SampleRecord& rec) {
+  METRIC_SCOPE(M_READ_SENSORS);
+  beginSample(timestamp, doc, rec);
+  if (hal.baro) readBME280(*hal.baro, doc, rec);
+  if (hal.dht) readDHT11(*hal.dht, doc, rec);
+  if (hal.soilTemp) readSoilTemperature(*hal.soilTemp, hal.clock(), doc, rec);
+  if (hal.soilMoisture) readSoilMoisture(*hal.soilMoisture, hal.moistureCal, doc, rec);
+}
+
+void beginSample(uint64_t timestamp, JsonDocument& doc, SampleRecord& rec) {
+  memset(&rec, 0, sizeof(rec));
+  rec.timestamp = timestamp;
+  doc["timestamp"] = timestamp;
+}
+
+void markUnsynced(JsonDocument& doc, SampleRecord& rec) {
+  rec.flags |= SAMPLE_UNSYNCED;
+  doc["unsynced"] = true;
+}
+
+// Read BME280 sensor: one burst read, compensation and altitude computed once
+void readBME280(BaroInput& bme, JsonDocument& doc, SampleRecord& rec) {
+  METRIC_SCOPE(M_READ_BME280);
+  Bme280Reading r;
+  storeBME280(bme.read(r) ? &r : nullptr, doc, rec);
+}
+
+void storeBME280(const Bme280Reading* r, JsonDocument& doc, SampleRecord& rec) {
+  if (!r) {
+    doc["bme280"] = "error";
+    return;
+  }
+  rec.flags |= SAMPLE_HAS_BME280;
+  rec.bmeTemp = (int16_t)r->centiCelsius;
+  rec.bmeHumidity = (int16_t)((r->humidityQ10 * 100 + 512) >> 10);
+  rec.pressure = (r->pressureQ8 + 128) >> 8;
+
+  JsonObject bme280 = doc["bme280"].to<JsonObject>();
+  bme280["temperature"] = fromCenti(rec.bmeTemp);
+  bme280["pressure"] = fromCenti(rec.pressure);   // Pa = 0.01 hPa
+  bme280["humidity"] = fromCenti(rec.bmeHumidity);
+  bme280["altitude"] = round(r->altitude(SEALEVELPRESSURE_HPA) * 100) / 100.0;   // derived, not kept
+}
+
+// Read DHT11 sensor (temperature, humidity, heat index)
+void readDHT11(DhtInput& dht, JsonDocument& doc, SampleRecord& rec) {
+  METRIC_SCOPE(M_READ_DHT11);
+  int16_t t, h;
+  bool ok = dht.read(t, h);
+  storeDHT11(ok, t, h, doc, rec);
+}
+
+void storeDHT11(bool ok, int16_t centiCelsius, int16_t centiHumidity, JsonDocument& doc, SampleRecord& rec) {
+  if (!ok) {
+    doc["dht11"] = "error";
+    return;
+  }
+  rec.flags |= SAMPLE_HAS_DHT11;
+  rec.airTemp = centiCelsius;
+  rec.airHumidity = centiHumidity;
+  rec.heatIndex = heatIndexCenti(centiCelsius, centiHumidity);
+
+  JsonObject dht11 = doc["dht11"].to<JsonObject>();
+  dht11["temperature"] = fromCenti(rec.airTemp);
+  dht11["humidity"] = fromCenti(rec.airHumidity);
+  dht11["heatIndex"] = fromCenti(rec.heatIndex);
+}
+
+// Read DS18B20 soil temperature (collects the conversion started ahead of the sample)
+void readSoilTemperature(SoilTempInput& soilTemp, uint32_t now, JsonDocument& doc, SampleRecord& rec) {
+  METRIC_SCOPE(M_READ_SOIL_TEMP);
+  soilTemp.poll(now);
+  if (soilTemp.state() != SoilTempInput::READY) {
+    doc["soilTemperature"] = "pending";
+    return;
+  }
+  storeSoilTemperature(soilTemp, doc, rec);
+}
+
+void storeSoilTemperature(const SoilTempInput& soilTemp, JsonDocument& doc, SampleRecord& rec) {
+  if (!soilTemp.valid(0)) {
+    doc["soilTemperature"] = "error";
+    return;
+  }
+
+  rec.flags |= SAMPLE_HAS_SOIL_TEMP;
+  rec.soilTemp = soilTemp.centiCelsius(0);
+
+  // Top-level celsius/fahrenheit keep tracking the first probe for existing readers
+  JsonObject soilTempData = doc["soilTemperature"].to<JsonObject>();
+  soilTempData["celsius"] = fromCenti(rec.soilTemp);
+  soilTempData["fahrenheit"] = fromCenti(soilTemp.centiFahrenheit(0));
+
+  JsonArray probes = soilTempData["probes"].to<JsonArray>();
+  for (uint8_t i = 0; i < soilTemp.probeCount(); i++) {
+    JsonObject probe = probes.add<JsonObject>();
+    char rom[17];
+    const uint8_t* addr = soilTemp.address(i);
+    for (uint8_t b = 0; b < 8; b++) snprintf(rom + b * 2, 3, "%02x", addr[b]);
+    probe["rom"] = rom;
+    if (soilTemp.valid(i)) {
+      probe["celsius"] = fromCenti(soilTemp.centiCelsius(i));
+      probe["fahrenheit"] = fromCenti(soilTemp.centiFahrenheit(i));
+    } else {
+      probe["error"] = true;
+    }
+  }
+}
+
+// Read analog soil moisture sensor
+void readSoilMoisture(AnalogInput& soil, const MoistureCal* cal, JsonDocument& doc, SampleRecord& rec) {
+  METRIC_SCOPE(M_READ_SOIL_MOISTURE);
+  int raw = soil.read();
+  storeSoilMoisture(raw, raw < 0 ? -1 : soil.millivolts(), cal, doc, rec);
+}
+
+void storeSoilMoisture(int raw, int mv, const MoistureCal* cal, JsonDocument& doc, SampleRecord& rec) {
+  if (raw < 0) {
+    doc["soilMoisture"] = "error";
+    return;
+  }
+  rec.flags |= SAMPLE_HAS_SOIL_MOISTURE;
+  rec.soilRaw = (uint16_t)raw;
+  if (cal && mv >= 0) {
+    rec.soilMoisture = (int16_t)moistureCentiPercent(*cal, mv);
+  } else {
+    rec.soilMoisture = (int16_t)((long)raw * 100 / 4095 * 100);   // map(raw, 0, 4095, 0, 100)
+  }
+
+  JsonObject soilData = doc["soilMoisture"].to<JsonObject>();
+  soilData["raw"] = raw;
+  if (mv >= 0) soilData["mv"] = mv;
+  soilData["percentage"] = fromCenti(rec.soilMoisture);
+}
@@ -0,0 +1,30 @@
+#ifndef ACQUISITION_H
+#define ACQUISITION_H
+
+#include <ArduinoJson.h>
+#include "hal.h"
+#include "sampleRecord.h"
+
+// Read data from all sensors present in hal. rec gets the sample in fixed point, doc the
+// same values rounded to 0.01 for serialization plus the per-probe and diagnostic detail.
+void readSensorData(const SensorHal& hal, uint64_t timestamp, JsonDocument& doc, SampleRecord& rec);
+
+// Empty rec and stamp both; the read*/store* calls below then add their sections
+void beginSample(uint64_t timestamp, JsonDocument& doc, SampleRecord& rec);
+// The timestamp is a provisional key (sampleClock.h), not yet on the SNTP grid
+void markUnsynced(JsonDocument& doc, SampleRecord& rec);
+
+void readBME280(BaroInput& bme, JsonDocument& doc, SampleRecord& rec);
+void readDHT11(DhtInput& dht, JsonDocument& doc, SampleRecord& rec);
+void readSoilTemperature(SoilTempInput& soilTemp, uint32_t now, JsonDocument& doc, SampleRecord& rec);
+void readSoilMoisture(AnalogInput& soil, const MoistureCal* cal, JsonDocument& doc, SampleRecord& rec);
+
+// The sample sections from values already read, so the read* calls above and the sensor
+// registry (sensors.h), which reads each sensor on its own schedule, build the same document.
+// A failed read (null r, ok false, raw < 0) becomes "error".
+void storeBME280(const Bme280Reading* r, JsonDocument& doc, SampleRecord& rec);
+void storeDHT11(bool ok, int16_t centiCelsius, int16_t centiHumidity, JsonDocument& doc, SampleRecord& rec);
+void storeSoilTemperature(const SoilTempInput& soilTemp, JsonDocument& doc, SampleRecord& rec);
+void storeSoilMoisture(int raw, int mv, const MoistureCal* cal, JsonDocument& doc, SampleRecord& rec);
+
+#endif
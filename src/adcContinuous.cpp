@@ -0,0 +1,91 @@
+#ifdef ARDUINO
+#include "adcContinuous.h"
+#include "logger.h"
+#include <driver/adc.h>
+
+#define ADC_FRAME_BYTES 256       // Driver hand-off unit; conversions are 2 bytes each
+
+bool ContinuousAdc::begin() {
+  int8_t ch = digitalPinToAnalogChannel(pin_);
+  if (ch < 0 || ch >= 8) {
+    LOG_E("✗ GPIO%u is not an ADC1 pin, continuous ADC disabled\n", pin_);
+    return false;
+  }
+  channel_ = ch;
+
+  adc_digi_init_config_t init = {};
+  init.max_store_buf_size = 1024;
+  init.conv_num_each_intr = ADC_FRAME_BYTES;
+  init.adc1_chan_mask = BIT(channel_);
+  init.adc2_chan_mask = 0;
+  if (adc_digi_initialize(&init) != ESP_OK) return false;
+
+  adc_digi_pattern_config_t pattern = {};
+  pattern.atten = ADC_ATTEN_DB_11;          // full 0-3.1 V range of a 3.3 V probe
+  pattern.channel = channel_;
+  pattern.unit = 0;                         // ADC1
+  pattern.bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+
+  adc_digi_configuration_t cfg = {};
+  cfg.conv_limit_en = true;                 // required on the ESP32
+  cfg.conv_limit_num = 250;
+  cfg.pattern_num = 1;
+  cfg.adc_pattern = &pattern;
+  cfg.sample_freq_hz = ADC_SAMPLE_HZ;
+  cfg.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+  cfg.format = ADC_DIGI_OUTPUT_FORMAT_TYPE1;
+  if (adc_digi_controller_configure(&cfg) != ESP_OK) {
+    adc_digi_deinitialize();
+    return false;
+  }
+
+  calSource_ = esp_adc_cal_characterize(ADC_UNIT_1, ADC_ATTEN_DB_11, ADC_WIDTH_BIT_12, 1100, &chars_);
+  if (calSource_ == ESP_ADC_CAL_VAL_DEFAULT_VREF) LOG_W("⚠ No ADC calibration in eFuse, millivolts use the default Vref\n");
+  ready_ = true;
+  return true;
+}
+
+const char* ContinuousAdc::calibrationSource() const {
+  switch (calSource_) {
+    case ESP_ADC_CAL_VAL_EFUSE_TP: return "eFuse two-point";
+    case ESP_ADC_CAL_VAL_EFUSE_VREF: return "eFuse Vref";
+    default: return "default Vref";
+  }
+}
+
+int ContinuousAdc::read() {
+  if (!ready_) return -1;
+  uint8_t frame[ADC_FRAME_BYTES];
+  uint32_t got = 0;
+
+  // Whatever is left from the last burst is stale
+  while (adc_digi_read_bytes(frame, sizeof(frame), &got, 0) == ESP_OK && got > 0) {}
+
+  adc_digi_start();
+  size_t n = 0;
+  uint32_t skip = ADC_DISCARD;
+  uint32_t start = millis();
+  while (n < ADC_OVERSAMPLE && millis() - start < 50) {
+    if (adc_digi_read_bytes(frame, sizeof(frame), &got, 20) != ESP_OK) continue;
+    for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= got && n < ADC_OVERSAMPLE; i += SOC_ADC_DIGI_RESULT_BYTES) {
+      const adc_digi_output_data_t* d = (const adc_digi_output_data_t*)&frame[i];
+      if (d->type1.channel != (uint32_t)channel_) continue;
+      if (skip) {
+        skip--;
+        continue;
+      }
+      samples_[n++] = d->type1.data;
+    }
+  }
+  adc_digi_stop();
+  if (n == 0) return -1;
+
+  lastRaw_ = trimmedMean(samples_, n, ADC_TRIM_PERCENT);
+  return lastRaw_;
+}
+
+int ContinuousAdc::millivolts() {
+  if (!ready_) return -1;
+  return (int)esp_adc_cal_raw_to_voltage(lastRaw_, &chars_);
+}
+#endif
@@ -0,0 +1,36 @@
+#ifndef ADC_CONTINUOUS_H
+#define ADC_CONTINUOUS_H
+
+#include <Arduino.h>
+#include <esp_adc_cal.h>
+#include "hal.h"
+#include "adcFilter.h"
+
+#define ADC_SAMPLE_HZ 20000       // Lowest rate the ESP32 digital controller runs at
+#define ADC_DISCARD 8             // Conversions dropped after each start while the input settles
+
+// Soil-moisture input on an ADC1 pin (GPIO32-39; ADC2 is taken by WiFi). Each read() runs
+// the digital controller in continuous mode for one burst: DMA fills the driver's ring
+// buffer with ADC_OVERSAMPLE conversions (~4 ms at 20 kHz, no CPU per conversion), which are
+// then trimmed and averaged. millivolts() maps the result through the eFuse
+// characterization (two-point or Vref, whichever this chip was trimmed with).
+class ContinuousAdc final : public AnalogInput {
+public:
+  explicit ContinuousAdc(uint8_t pin) : pin_(pin), channel_(-1), ready_(false), lastRaw_(0) {}
+
+  bool begin();               // false if the pin is not on ADC1 or the driver refused
+  int read() override;        // 12-bit counts, filtered; -1 on failure
+  int millivolts() override;  // the last read(), characterized
+  const char* calibrationSource() const;
+
+private:
+  uint8_t pin_;
+  int8_t channel_;
+  bool ready_;
+  uint16_t lastRaw_;
+  esp_adc_cal_value_t calSource_;
+  esp_adc_cal_characteristics_t chars_;
+  uint16_t samples_[ADC_OVERSAMPLE];
+};
+
+#endif
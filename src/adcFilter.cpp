@@ -0,0 +1,38 @@
+#include "adcFilter.h"
+
+uint16_t trimmedMean(uint16_t* buf, size_t n, uint8_t trimPercent) {
+  if (n == 0) return 0;
+  // Insertion sort: n is a few dozen, and mostly ordered runs from a slow signal
+  for (size_t i = 1; i < n; i++) {
+    uint16_t v = buf[i];
+    size_t j = i;
+    while (j > 0 && buf[j - 1] > v) {
+      buf[j] = buf[j - 1];
+      j--;
+    }
+    buf[j] = v;
+  }
+  if (trimPercent >= 50) {
+    return n & 1 ? buf[n / 2] : (uint16_t)((buf[n / 2 - 1] + buf[n / 2] + 1) / 2);
+  }
+  size_t drop = n * trimPercent / 100;
+  uint32_t sum = 0;
+  for (size_t i = drop; i < n - drop; i++) sum += buf[i];
+  size_t kept = n - 2 * drop;
+  return (uint16_t)((sum + kept / 2) / kept);
+}
+
+int32_t moistureCentiPercent(const MoistureCal& cal, int32_t mv) {
+  const MoistureCalPoint* p = cal.points;
+  if (cal.count == 0) return 0;
+  if (mv <= p[0].mv) return p[0].centiPercent;
+  if (mv >= p[cal.count - 1].mv) return p[cal.count - 1].centiPercent;
+  uint8_t i = 1;
+  while (mv > p[i].mv) i++;
+  int32_t x0 = p[i - 1].mv, x1 = p[i].mv;
+  int32_t y0 = p[i - 1].centiPercent, y1 = p[i].centiPercent;
+  // Rounded to nearest; works for falling (capacitive) and rising (resistive) curves alike
+  int32_t num = (y1 - y0) * (mv - x0);
+  int32_t den = x1 - x0;
+  return y0 + (num >= 0 ? (num + den / 2) / den : (num - den / 2) / den);
+}
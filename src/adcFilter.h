@@ -0,0 +1,33 @@
+#ifndef ADC_FILTER_H
+#define ADC_FILTER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Host-testable half of the soil-moisture path: robust averaging of an oversampled ADC
+// burst and the per-probe calibration from millivolts to volumetric moisture.
+
+#define ADC_OVERSAMPLE 64         // Conversions per reading
+#define ADC_TRIM_PERCENT 25       // Dropped from each end before averaging; 50 = median
+
+// Mean of the middle of buf after discarding trimPercent of the samples at each end.
+// Spikes from WiFi bursts or a noisy supply land in the tails. Sorts buf in place.
+uint16_t trimmedMean(uint16_t* buf, size_t n, uint8_t trimPercent);
+
+// One calibration point: probe output at a known moisture
+struct MoistureCalPoint {
+  uint16_t mv;
+  uint16_t centiPercent;  // 0.01 %
+};
+
+// Points sorted by mv, at least two: typically dry soil and saturated soil, plus any
+// intermediate gravimetric measurements to straighten out the probe's curve
+struct MoistureCal {
+  const MoistureCalPoint* points;
+  uint8_t count;
+};
+
+// Piecewise-linear interpolation between the calibration points, clamped to the table
+int32_t moistureCentiPercent(const MoistureCal& cal, int32_t mv);
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef ARENA_ALLOCATOR_H
+#define ARENA_ALLOCATOR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <ArduinoJson.h>
+
+// Bump allocator over a caller-owned buffer for ArduinoJson documents that are rebuilt
+// every cycle. deallocate() is a no-op; reset() reclaims everything once the documents
+// using it are gone. Exhaustion returns nullptr, which ArduinoJson reports as overflowed().
+class ArenaAllocator : public ArduinoJson::Allocator {
+public:
+  ArenaAllocator(void* buf, size_t size) : buf_((uint8_t*)buf), size_(size), used_(0), peak_(0), last_(nullptr) {}
+
+  void* allocate(size_t n) override {
+    size_t need = align(n) + sizeof(Header);
+    if (used_ + need > size_) return nullptr;
+    Header* h = (Header*)(buf_ + used_);
+    h->size = n;
+    used_ += need;
+    if (used_ > peak_) peak_ = used_;
+    last_ = h + 1;
+    return last_;
+  }
+
+  void deallocate(void*) override {}
+
+  void* reallocate(void* ptr, size_t n) override {
+    if (!ptr) return allocate(n);
+    Header* h = (Header*)ptr - 1;
+    // The most recent block can grow or shrink in place
+    if (ptr == last_) {
+      size_t start = (uint8_t*)ptr - buf_;
+      if (start + align(n) > size_) return nullptr;
+      used_ = start + align(n);
+      if (used_ > peak_) peak_ = used_;
+      h->size = n;
+      return ptr;
+    }
+    if (n <= h->size) return ptr;
+    void* p = allocate(n);
+    if (p) memcpy(p, ptr, h->size);
+    return p;
+  }
+
+  void reset() { used_ = 0; last_ = nullptr; }
+  size_t used() const { return used_; }
+  size_t peak() const { return peak_; }
+  size_t capacity() const { return size_; }
+
+private:
+  struct Header {
+    size_t size;
+    size_t pad;   // keeps payloads 8-byte aligned on 32-bit targets
+  };
+
+  static size_t align(size_t n) { return (n + 7) & ~(size_t)7; }
+
+  uint8_t* buf_;
+  size_t size_;
+  size_t used_;
+  size_t peak_;
+  void* last_;
+};
+
+#endif
@@ -0,0 +1,93 @@
+#ifdef ARDUINO
+#include "authSession.h"
+#include <Preferences.h>
+#include <esp_sleep.h>
+#include <esp_attr.h>
+#include <time.h>
+
+#define AUTH_NVS_NAMESPACE "fbauth"
+#define AUTH_EPOCH_VALID 1600000000   // Anything earlier means the clock was never set
+
+static String storedId;
+static String storedRefresh;
+static uint32_t storedKeyHash = 0;
+static uint32_t storedAt = 0;
+static uint32_t keyHash = 0;
+// Copy of storedAt that only survives deep sleep: proves the NVS timestamp was taken on
+// this power-up, when the RTC counts from boot rather than from a real epoch
+RTC_DATA_ATTR static uint32_t rtcStoredAt = 0;
+
+static uint32_t hashOf(const char* s) {
+  uint32_t h = 2166136261UL;      // FNV-1a
+  while (*s) h = (h ^ (uint8_t)*s++) * 16777619UL;
+  return h;
+}
+
+// Can now - storedAt be believed?
+static bool clockTrusted(uint32_t now) {
+  if (now > AUTH_EPOCH_VALID && storedAt > AUTH_EPOCH_VALID) return true;
+  return esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_UNDEFINED && rtcStoredAt == storedAt;
+}
+
+bool authSessionLoad(const char* apiKey) {
+  keyHash = hashOf(apiKey);
+  Preferences prefs;
+  if (!prefs.begin(AUTH_NVS_NAMESPACE, true)) return false;
+  storedKeyHash = prefs.getUInt("key", 0);
+  storedAt = prefs.getUInt("at", 0);
+  storedRefresh = prefs.getString("refresh", "");
+  storedId = prefs.getString("id", "");
+  prefs.end();
+  // Sessions belong to one project
+  return storedKeyHash == keyHash && storedRefresh.length() > 0;
+}
+
+void authSessionApply(FirebaseConfig& config) {
+  uint32_t now = time(nullptr);
+  size_t remaining = 0;
+  if (clockTrusted(now) && storedId.length() > 0 && now >= storedAt && now - storedAt < AUTH_ID_TOKEN_TTL) {
+    remaining = AUTH_ID_TOKEN_TTL - (now - storedAt);
+  }
+  // With no life left the library goes straight to the refresh exchange, still no sign-up
+  Firebase.setIdToken(&config, remaining > 0 ? storedId.c_str() : "", remaining, storedRefresh.c_str());
+}
+
+void authSessionSave() {
+  String id = Firebase.getToken();
+  String refresh = Firebase.getRefreshToken();
+  if (refresh.length() == 0) return;
+  if (id == storedId && refresh == storedRefresh && storedKeyHash == keyHash) return;
+
+  Preferences prefs;
+  if (!prefs.begin(AUTH_NVS_NAMESPACE, false)) return;
+  storedAt = time(nullptr);
+  rtcStoredAt = storedAt;
+  prefs.putUInt("key", keyHash);
+  prefs.putUInt("at", storedAt);
+  prefs.putString("refresh", refresh);
+  prefs.putString("id", id);
+  prefs.end();
+  storedId = id;
+  storedRefresh = refresh;
+  storedKeyHash = keyHash;
+}
+
+void authSessionClear() {
+  Preferences prefs;
+  if (prefs.begin(AUTH_NVS_NAMESPACE, false)) {
+    prefs.clear();
+    prefs.end();
+  }
+  storedId = "";
+  storedRefresh = "";
+  storedKeyHash = 0;
+}
+
+bool authSessionRejected(const TokenInfo& info) {
+  if (info.status != token_status_error) return false;
+  const char* msg = info.error.message.c_str();
+  return strstr(msg, "INVALID_REFRESH_TOKEN") || strstr(msg, "TOKEN_EXPIRED") ||
+         strstr(msg, "USER_NOT_FOUND") || strstr(msg, "USER_DISABLED") ||
+         strstr(msg, "PROJECT_NUMBER_MISMATCH");
+}
+#endif
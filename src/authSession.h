@@ -0,0 +1,26 @@
+#ifndef AUTH_SESSION_H
+#define AUTH_SESSION_H
+
+#include <Arduino.h>
+#include <Firebase_ESP_Client.h>
+
+#define AUTH_ID_TOKEN_TTL 3600    // Lifetime of a Firebase ID token, seconds
+#define AUTH_PRE_REFRESH 300      // Refresh this long before the ID token expires
+
+// Anonymous Firebase session kept in NVS, so reboots and re-inits reuse one user
+// instead of signing up a new one each time. The refresh token is always reused;
+// the ID token only while the clock is trustworthy (NTP time, or a deep-sleep wake,
+// where the RTC keeps counting) and it has life left, otherwise it is refreshed.
+
+// Reads the stored session for this API key; false if there is none
+bool authSessionLoad(const char* apiKey);
+// After Firebase.begin(): hand the loaded tokens to the library
+void authSessionApply(FirebaseConfig& config);
+// Persist the library's current tokens; NVS is written only when they changed
+void authSessionSave();
+// Drop the stored session, e.g. once the refresh token has been revoked
+void authSessionClear();
+// True for token errors that mean the stored session is dead rather than unreachable
+bool authSessionRejected(const TokenInfo& info);
+
+#endif
@@ -0,0 +1,271 @@
+#include "select.h"
+#if defined(RTDB_BENCH) && !defined(ARDUINO)
+// Host benchmark for env:bench: runs the acquisition/upload pipeline against MockRtdb over
+// loopback and reports per-stage latency percentiles, wire bytes, requests per cycle and
+// peak JSON heap. Limits given on the command line turn it into a regression check: the
+// exit code is 1 when any of them is exceeded.
+//
+//   program cycles=500 latency=40 jitter=20 errors=5 drops=1 max-requests=1.2 max-p99=400
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include <ArduinoJson.h>
+#include "nodeConfig.h"
+#include "scheduler.h"
+#include "halSim.h"
+#include "acquisition.h"
+#include "upload.h"
+#include "sampleLog.h"
+#include "posixBlockStore.h"
+#include "mockRtdb.h"
+#include "httpUplink.h"
+
+#define SOIL_TEMP_MARGIN 20
+
+typedef std::chrono::steady_clock HostClock;
+
+static double elapsedUs(HostClock::time_point start) {
+  return std::chrono::duration<double, std::micro>(HostClock::now() - start).count();
+}
+
+// malloc-backed allocator that tracks live and peak bytes of the documents using it
+class CountingAllocator : public ArduinoJson::Allocator {
+public:
+  void* allocate(size_t n) override {
+    size_t* p = (size_t*)malloc(n + sizeof(size_t));
+    if (!p) return nullptr;
+    *p = n;
+    grow(n);
+    return p + 1;
+  }
+  void deallocate(void* ptr) override {
+    if (!ptr) return;
+    size_t* p = (size_t*)ptr - 1;
+    live -= *p;
+    free(p);
+  }
+  void* reallocate(void* ptr, size_t n) override {
+    if (!ptr) return allocate(n);
+    size_t* p = (size_t*)ptr - 1;
+    size_t old = *p;
+    p = (size_t*)realloc(p, n + sizeof(size_t));
+    if (!p) return nullptr;
+    *p = n;
+    live -= old;
+    grow(n);
+    return p + 1;
+  }
+
+  size_t live = 0;
+  size_t peak = 0;
+
+private:
+  void grow(size_t n) {
+    live += n;
+    if (live > peak) peak = live;
+  }
+};
+
+// Times every update() of one cycle, including backlog replays
+class TimedUplink : public Uplink {
+public:
+  explicit TimedUplink(HttpUplink& inner) : inner_(inner) {}
+  UplinkStatus update(const char* path, JsonDocument& doc) override {
+    HostClock::time_point start = HostClock::now();
+    UplinkStatus s = inner_.update(path, doc);
+    updateUs += elapsedUs(start);
+    sendUs += inner_.sendUs;
+    waitUs += inner_.waitUs;
+    return s;
+  }
+  const char* errorReason() const override { return inner_.errorReason(); }
+  void reset() { updateUs = sendUs = waitUs = 0; }
+
+  double updateUs = 0, sendUs = 0, waitUs = 0;
+
+private:
+  HttpUplink& inner_;
+};
+
+struct Stage {
+  const char* name;
+  std::vector<double> us;
+
+  double pct(double p) const {
+    if (us.empty()) return 0;
+    std::vector<double> s(us);
+    std::sort(s.begin(), s.end());
+    size_t i = (size_t)(p * s.size());
+    return s[i < s.size() ? i : s.size() - 1];
+  }
+};
+
+enum { ST_SAMPLE, ST_BUILD, ST_SERIALIZE, ST_WAIT, ST_LOCAL, ST_CYCLE, ST_COUNT };
+static Stage stages[ST_COUNT] = {
+  { "sample", {} },       // readSensorData
+  { "build", {} },        // fan-out/backlog documents, log append/replay
+  { "serialize", {} },    // serializeJson into the socket, headers, chunk framing
+  { "response", {} },     // server latency plus status/header parsing
+  { "local", {} },        // sample + build + serialize: CPU time on the node's side
+  { "cycle", {} },
+};
+
+static SimDht dht(0);
+static SimSoilTemp soilTemp(2);
+static SimBaro baro;
+static SimAnalog moisture;
+static SensorHal hal = { &dht, &soilTemp, &baro, &moisture, nullptr, FakeClock::read };
+
+static CountingAllocator sampleHeap;
+static JsonDocument sampleDoc(&sampleHeap);
+static SampleRecord sampleRec;
+static TimedUplink* uplink = nullptr;
+static SampleLog* offlineLog = nullptr;
+static bool sampleUploaded = true;
+static uint32_t samples = 0;
+static uint32_t delivered = 0;
+static double sampleUs = 0;
+
+static void soilConvTask() {
+  soilTemp.start(FakeClock::read());
+}
+
+static void sampleTask() {
+  HostClock::time_point start = HostClock::now();
+  sampleDoc.clear();
+  readSensorData(hal, FakeClock::read(), sampleDoc, sampleRec);
+  sampleUs = elapsedUs(start);
+  samples++;
+  sampleUploaded = false;
+}
+
+static void uploadTask() {
+  uplink->reset();
+  HostClock::time_point start = HostClock::now();
+  if (uploadCycle(uplink, offlineLog, sampleDoc, !sampleUploaded, FakeClock::read())) delivered++;
+  double uploadUs = elapsedUs(start);
+  sampleUploaded = true;
+
+  double build = uploadUs - uplink->updateUs;
+  stages[ST_SAMPLE].us.push_back(sampleUs);
+  stages[ST_BUILD].us.push_back(build);
+  stages[ST_SERIALIZE].us.push_back(uplink->sendUs);
+  stages[ST_WAIT].us.push_back(uplink->waitUs);
+  stages[ST_LOCAL].us.push_back(sampleUs + build + uplink->sendUs);
+  stages[ST_CYCLE].us.push_back(sampleUs + uploadUs);
+}
+
+static bool argValue(const char* arg, const char* key, double& out) {
+  size_t n = strlen(key);
+  if (strncmp(arg, key, n) != 0 || arg[n] != '=') return false;
+  out = atof(arg + n + 1);
+  return true;
+}
+
+static bool check(const char* metric, double value, double limit) {
+  if (limit <= 0 || value <= limit) return true;
+  printf("REGRESSION %s %.2f > %.2f\n", metric, value, limit);
+  return false;
+}
+
+int main(int argc, char** argv) {
+  double cycles = 500, latency = 0, jitter = 0, errors = 0, code = 503, drops = 0, seed = 1, log = 1;
+  double maxRequests = 0, maxBytes = 0, maxHeap = 0, maxP99 = 0;
+  for (int i = 1; i < argc; i++) {
+    const char* a = argv[i];
+    if (!(argValue(a, "cycles", cycles) || argValue(a, "latency", latency) ||
+          argValue(a, "jitter", jitter) || argValue(a, "errors", errors) ||
+          argValue(a, "code", code) || argValue(a, "drops", drops) || argValue(a, "seed", seed) ||
+          argValue(a, "log", log) || argValue(a, "max-requests", maxRequests) ||
+          argValue(a, "max-bytes", maxBytes) || argValue(a, "max-heap", maxHeap) ||
+          argValue(a, "max-p99", maxP99))) {
+      fprintf(stderr, "unknown argument: %s\n", a);
+      return 2;
+    }
+  }
+  simLogEnabled = false;
+
+  MockRtdbConfig cfg;
+  cfg.latencyMs = (uint32_t)latency;
+  cfg.jitterMs = (uint32_t)jitter;
+  cfg.errorPercent = (uint8_t)errors;
+  cfg.errorCode = (uint16_t)code;
+  cfg.dropPercent = (uint8_t)drops;
+  cfg.seed = (uint32_t)seed;
+  MockRtdb server(cfg);
+  if (!server.start()) {
+    fprintf(stderr, "mock RTDB could not listen\n");
+    return 2;
+  }
+  HttpUplink http("127.0.0.1", server.port(), "bench-token");
+  TimedUplink timed(http);
+  uplink = &timed;
+
+  // Failed uploads go to a scratch flash log and are replayed, as with ENABLE_OFFLINE_LOG
+  char dir[] = "/tmp/rtdbBench.XXXXXX";
+  PosixBlockStore* store = nullptr;
+  if (log && mkdtemp(dir)) {
+    store = new PosixBlockStore(dir);
+    offlineLog = new SampleLog(*store);
+    if (!offlineLog->begin()) offlineLog = nullptr;
+  }
+
+  Scheduler<4> scheduler(FakeClock::read);
+  scheduler.addTask("sample", sampleTask, SAMPLE_INTERVAL);
+  scheduler.addTask("upload", uploadTask, UPLOAD_INTERVAL, 20);
+  scheduler.addTask("soilConv", soilConvTask, SAMPLE_INTERVAL,
+                    SAMPLE_INTERVAL - soilTemp.conversionMs() - SOIL_TEMP_MARGIN);
+
+  while (stages[ST_CYCLE].us.size() < (size_t)cycles) {
+    uint32_t wait = scheduler.tick();
+    FakeClock::advance(wait ? wait : 1);
+  }
+  server.stop();
+
+  uint32_t n = (uint32_t)stages[ST_CYCLE].us.size();
+  printf("cycles %u, latency %u+%u ms, errors %u%% (HTTP %u), drops %u%%\n", (unsigned)n,
+         (unsigned)cfg.latencyMs, (unsigned)cfg.jitterMs, (unsigned)cfg.errorPercent,
+         (unsigned)cfg.errorCode, (unsigned)cfg.dropPercent);
+  printf("%-10s %10s %10s %10s %10s  (us)\n", "stage", "p50", "p90", "p99", "max");
+  for (int i = 0; i < ST_COUNT; i++) {
+    const Stage& s = stages[i];
+    printf("%-10s %10.1f %10.1f %10.1f %10.1f\n", s.name, s.pct(0.5), s.pct(0.9), s.pct(0.99), s.pct(1.0));
+  }
+
+  double requestsPerCycle = (double)http.requests / n;
+  double bytesPerCycle = (double)(http.bytesOut + http.bytesIn) / n;
+  size_t peakHeap = sampleHeap.peak + uploadArena.peak();
+  rusage ru;
+  getrusage(RUSAGE_SELF, &ru);
+  printf("requests %u (%.2f/cycle), connects %u, server saw %u, injected errors %u, drops %u\n",
+         (unsigned)http.requests, requestsPerCycle, (unsigned)http.connects,
+         (unsigned)server.requests.load(), (unsigned)server.errors.load(), (unsigned)server.drops.load());
+  printf("wire out %llu B, in %llu B, JSON body %llu B, %.0f B/cycle\n",
+         (unsigned long long)http.bytesOut, (unsigned long long)http.bytesIn,
+         (unsigned long long)http.bodyBytes, bytesPerCycle);
+  printf("samples %u, delivered live %u, pending in log %u, dropped from log %u\n", (unsigned)samples,
+         (unsigned)delivered, offlineLog ? (unsigned)offlineLog->pending() : 0,
+         offlineLog ? (unsigned)offlineLog->dropped() : 0);
+  printf("peak heap: sample doc %u B + upload arena %u B = %u B (process max RSS %ld KB)\n",
+         (unsigned)sampleHeap.peak, (unsigned)uploadArena.peak(), (unsigned)peakHeap, ru.ru_maxrss);
+
+  if (store) {
+    for (uint8_t i = 0; i < SAMPLE_LOG_SEGMENTS; i++) store->erase(i);
+    unlink((std::string(dir) + "/meta").c_str());
+    rmdir(dir);
+  }
+
+  bool ok = check("requests/cycle", requestsPerCycle, maxRequests);
+  ok = check("bytes/cycle", bytesPerCycle, maxBytes) && ok;
+  ok = check("peak-heap", (double)peakHeap, maxHeap) && ok;
+  ok = check("local-p99-us", stages[ST_LOCAL].pct(0.99), maxP99) && ok;
+  printf("%s\n", ok ? "OK" : "FAILED");
+  return ok ? 0 : 1;
+}
+#endif
@@ -0,0 +1,75 @@
+#ifdef ARDUINO
+#include "blockStore.h"
+#include <stdio.h>
+
+bool FsBlockStore::begin() {
+  if (!fs_.exists(dir_)) return fs_.mkdir(dir_);
+  return true;
+}
+
+void FsBlockStore::segPath(uint8_t seg, char* out, size_t len) const {
+  snprintf(out, len, "%s/%u.bin", dir_, (unsigned)seg);
+}
+
+int32_t FsBlockStore::size(uint8_t seg) {
+  char path[32];
+  segPath(seg, path, sizeof(path));
+  if (!fs_.exists(path)) return -1;
+  File f = fs_.open(path, "r");
+  if (!f) return -1;
+  int32_t n = (int32_t)f.size();
+  f.close();
+  return n;
+}
+
+bool FsBlockStore::read(uint8_t seg, uint32_t off, void* buf, size_t len) {
+  char path[32];
+  segPath(seg, path, sizeof(path));
+  File f = fs_.open(path, "r");
+  if (!f) return false;
+  bool ok = f.seek(off) && f.read((uint8_t*)buf, len) == len;
+  f.close();
+  return ok;
+}
+
+bool FsBlockStore::append(uint8_t seg, const void* buf, size_t len) {
+  char path[32];
+  segPath(seg, path, sizeof(path));
+  File f = fs_.open(path, "a");
+  if (!f) return false;
+  bool ok = f.write((const uint8_t*)buf, len) == len;
+  f.close();   // close commits the LittleFS metadata for the new tail
+  return ok;
+}
+
+bool FsBlockStore::erase(uint8_t seg) {
+  char path[32];
+  segPath(seg, path, sizeof(path));
+  return !fs_.exists(path) || fs_.remove(path);
+}
+
+bool FsBlockStore::readMeta(void* buf, size_t len) {
+  char path[32];
+  snprintf(path, sizeof(path), "%s/meta", dir_);
+  File f = fs_.open(path, "r");
+  if (!f) return false;
+  bool ok = f.read((uint8_t*)buf, len) == len;
+  f.close();
+  return ok;
+}
+
+// Write a temp file and rename it into place. A crash between remove and rename only
+// loses the cursor; the log then replays from its oldest segment onto the same keys.
+bool FsBlockStore::writeMeta(const void* buf, size_t len) {
+  char path[32], tmp[32];
+  snprintf(path, sizeof(path), "%s/meta", dir_);
+  snprintf(tmp, sizeof(tmp), "%s/meta.tmp", dir_);
+  File f = fs_.open(tmp, "w");
+  if (!f) return false;
+  bool ok = f.write((const uint8_t*)buf, len) == len;
+  f.close();
+  if (!ok) return false;
+  fs_.remove(path);
+  return fs_.rename(tmp, path);
+}
+#endif
@@ -0,0 +1,44 @@
+#ifndef BLOCK_STORE_H
+#define BLOCK_STORE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Storage behind the sample log: a fixed set of append-only segment files plus one small
+// metadata blob that is replaced atomically. FsBlockStore maps it onto LittleFS/SPIFFS on
+// the device; PosixBlockStore (posixBlockStore.h) maps it onto plain files on a host.
+class BlockStore {
+public:
+  virtual ~BlockStore() {}
+  virtual int32_t size(uint8_t seg) = 0;                                   // -1 if missing
+  virtual bool read(uint8_t seg, uint32_t off, void* buf, size_t len) = 0;
+  virtual bool append(uint8_t seg, const void* buf, size_t len) = 0;       // durable on return
+  virtual bool erase(uint8_t seg) = 0;
+  virtual bool readMeta(void* buf, size_t len) = 0;
+  virtual bool writeMeta(const void* buf, size_t len) = 0;                 // all-or-nothing
+};
+
+#ifdef ARDUINO
+#include <FS.h>
+
+class FsBlockStore : public BlockStore {
+public:
+  FsBlockStore(fs::FS& fs, const char* dir) : fs_(fs), dir_(dir) {}
+  bool begin();
+
+  int32_t size(uint8_t seg) override;
+  bool read(uint8_t seg, uint32_t off, void* buf, size_t len) override;
+  bool append(uint8_t seg, const void* buf, size_t len) override;
+  bool erase(uint8_t seg) override;
+  bool readMeta(void* buf, size_t len) override;
+  bool writeMeta(const void* buf, size_t len) override;
+
+private:
+  void segPath(uint8_t seg, char* out, size_t len) const;
+
+  fs::FS& fs_;
+  const char* dir_;
+};
+#endif
+
+#endif
@@ -0,0 +1,81 @@
+#include <Arduino.h>
+#include "bme280Burst.h"
+
+#define BME280_REG_CALIB_TP 0x88
+#define BME280_REG_CHIP_ID 0xD0
+#define BME280_REG_RESET 0xE0
+#define BME280_REG_CALIB_H 0xE1
+#define BME280_REG_CTRL_HUM 0xF2
+#define BME280_REG_STATUS 0xF3
+#define BME280_REG_CTRL_MEAS 0xF4
+#define BME280_REG_CONFIG 0xF5
+#define BME280_REG_DATA 0xF7
+
+#define BME280_CHIP_ID 0x60
+#define BME280_CTRL_MEAS_FORCED 0x25   // osrs_t x1, osrs_p x1, forced mode
+#define BME280_STATUS_MEASURING 0x08
+
+bool Bme280Burst::begin(uint8_t addr, TwoWire& wire) {
+  wire.begin();
+  wire_ = &wire;
+  addr_ = addr;
+
+  uint8_t id = 0;
+  if (!readRegs(BME280_REG_CHIP_ID, &id, 1) || id != BME280_CHIP_ID) return false;
+
+  writeReg(BME280_REG_RESET, 0xB6);
+  delay(3);   // NVM copy after reset
+
+  uint8_t tp[BME280_CALIB_TP_LEN];
+  uint8_t h[BME280_CALIB_H_LEN];
+  if (!readRegs(BME280_REG_CALIB_TP, tp, sizeof(tp))) return false;
+  if (!readRegs(BME280_REG_CALIB_H, h, sizeof(h))) return false;
+  bme280ParseCalib(tp, h, calib_);
+
+  // ctrl_hum only takes effect after the next ctrl_meas write
+  writeReg(BME280_REG_CTRL_HUM, 0x01);   // osrs_h x1
+  writeReg(BME280_REG_CONFIG, 0x00);     // filter off
+  return writeReg(BME280_REG_CTRL_MEAS, BME280_CTRL_MEAS_FORCED & ~0x03);  // sleep until triggered
+}
+
+void Bme280Burst::resume(const Bme280Calib& calib, uint8_t addr, TwoWire& wire) {
+  wire.begin();
+  wire_ = &wire;
+  addr_ = addr;
+  calib_ = calib;
+}
+
+bool Bme280Burst::trigger() {
+  return writeReg(BME280_REG_CTRL_MEAS, BME280_CTRL_MEAS_FORCED);
+}
+
+bool Bme280Burst::read(Bme280Reading& out) {
+  uint8_t status = 0;
+  if (!readRegs(BME280_REG_STATUS, &status, 1) || (status & BME280_STATUS_MEASURING)) return false;
+
+  uint8_t data[BME280_DATA_LEN];
+  if (!readRegs(BME280_REG_DATA, data, sizeof(data))) return false;
+
+  Bme280Raw raw;
+  bme280ParseRaw(data, raw);
+  if (raw.temp == 0x80000) return false;   // measurement skipped, never triggered
+
+  bme280Compensate(calib_, raw, out);
+  return true;
+}
+
+bool Bme280Burst::readRegs(uint8_t reg, uint8_t* buf, uint8_t len) {
+  wire_->beginTransmission(addr_);
+  wire_->write(reg);
+  if (wire_->endTransmission(false) != 0) return false;
+  if (wire_->requestFrom(addr_, len) != len) return false;
+  for (uint8_t i = 0; i < len; i++) buf[i] = wire_->read();
+  return true;
+}
+
+bool Bme280Burst::writeReg(uint8_t reg, uint8_t value) {
+  wire_->beginTransmission(addr_);
+  wire_->write(reg);
+  wire_->write(value);
+  return wire_->endTransmission() == 0;
+}
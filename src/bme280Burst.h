@@ -0,0 +1,34 @@
+#ifndef BME280_BURST_H
+#define BME280_BURST_H
+
+#include <Wire.h>
+#include "bme280Compensation.h"
+#include "hal.h"
+
+#define BME280_MEAS_MS 10   // Forced mode, x1 oversampling on all channels: 9.3 ms max
+
+// Minimal BME280 driver: forced-mode trigger, then one 8-byte burst read of 0xF7..0xFE
+// and a single compensation pass. Replaces the ~7 transactions the Adafruit getters
+// make for temperature, pressure, humidity and altitude.
+class Bme280Burst final : public BaroInput {
+public:
+  bool begin(uint8_t addr = 0x76, TwoWire& wire = Wire);
+  // Warm start after deep sleep: the chip kept its configuration in sleep mode,
+  // so only the calibration read by begin() is needed again
+  void resume(const Bme280Calib& calib, uint8_t addr = 0x76, TwoWire& wire = Wire);
+  bool trigger() override;                     // start one forced-mode measurement
+  uint16_t measurementMs() const { return BME280_MEAS_MS; }
+  bool read(Bme280Reading& out) override;      // false while measuring or on bus error
+
+  const Bme280Calib& calib() const { return calib_; }
+
+private:
+  bool readRegs(uint8_t reg, uint8_t* buf, uint8_t len);
+  bool writeReg(uint8_t reg, uint8_t value);
+
+  TwoWire* wire_ = nullptr;
+  uint8_t addr_ = 0x76;
+  Bme280Calib calib_;
+};
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef BME280_COMPENSATION_H
+#define BME280_COMPENSATION_H
+
+#include <stdint.h>
+#include <math.h>
+
+// BME280 compensation, integer formulas from the Bosch datasheet (rev 1.6, section 4.2.3/8.2).
+// Kept free of Wire/Arduino so it can be checked on a host against known raw/calibration vectors.
+
+#define BME280_CALIB_TP_LEN 26    // 0x88..0xA1
+#define BME280_CALIB_H_LEN 7      // 0xE1..0xE7
+#define BME280_DATA_LEN 8         // 0xF7..0xFE: press[3], temp[3], hum[2]
+
+struct Bme280Calib {
+  uint16_t T1; int16_t T2, T3;
+  uint16_t P1; int16_t P2, P3, P4, P5, P6, P7, P8, P9;
+  uint8_t H1; int16_t H2; uint8_t H3; int16_t H4, H5; int8_t H6;
+};
+
+struct Bme280Raw {
+  int32_t temp;
+  int32_t press;
+  int32_t hum;
+};
+
+struct Bme280Reading {
+  int32_t centiCelsius;   // 0.01 degC
+  uint32_t pressureQ8;    // Pa in Q24.8
+  uint32_t humidityQ10;   // %RH in Q22.10
+
+  float temperature() const { return centiCelsius / 100.0f; }
+  float pressurePa() const { return pressureQ8 / 256.0f; }
+  float humidity() const { return humidityQ10 / 1024.0f; }
+  // Derived from the already compensated pressure, no extra bus traffic
+  float altitude(float seaLevelHpa) const {
+    return 44330.0f * (1.0f - powf(pressurePa() / 100.0f / seaLevelHpa, 0.1903f));
+  }
+};
+
+// tp: registers 0x88..0xA1, h: registers 0xE1..0xE7
+inline void bme280ParseCalib(const uint8_t* tp, const uint8_t* h, Bme280Calib& c) {
+  c.T1 = (uint16_t)(tp[0] | tp[1] << 8);
+  c.T2 = (int16_t)(tp[2] | tp[3] << 8);
+  c.T3 = (int16_t)(tp[4] | tp[5] << 8);
+  c.P1 = (uint16_t)(tp[6] | tp[7] << 8);
+  c.P2 = (int16_t)(tp[8] | tp[9] << 8);
+  c.P3 = (int16_t)(tp[10] | tp[11] << 8);
+  c.P4 = (int16_t)(tp[12] | tp[13] << 8);
+  c.P5 = (int16_t)(tp[14] | tp[15] << 8);
+  c.P6 = (int16_t)(tp[16] | tp[17] << 8);
+  c.P7 = (int16_t)(tp[18] | tp[19] << 8);
+  c.P8 = (int16_t)(tp[20] | tp[21] << 8);
+  c.P9 = (int16_t)(tp[22] | tp[23] << 8);
+  c.H1 = tp[25];
+  c.H2 = (int16_t)(h[0] | h[1] << 8);
+  c.H3 = h[2];
+  c.H4 = (int16_t)((int8_t)h[3] * 16 | (h[4] & 0x0F));
+  c.H5 = (int16_t)((int8_t)h[5] * 16 | (h[4] >> 4));
+  c.H6 = (int8_t)h[6];
+}
+
+// d: registers 0xF7..0xFE from a single burst read
+inline void bme280ParseRaw(const uint8_t* d, Bme280Raw& r) {
+  r.press = (int32_t)((uint32_t)d[0] << 12 | (uint32_t)d[1] << 4 | d[2] >> 4);
+  r.temp = (int32_t)((uint32_t)d[3] << 12 | (uint32_t)d[4] << 4 | d[5] >> 4);
+  r.hum = (int32_t)((uint32_t)d[6] << 8 | d[7]);
+}
+
+inline int32_t bme280TFine(const Bme280Calib& c, int32_t adcT) {
+  int32_t var1 = ((((adcT >> 3) - ((int32_t)c.T1 << 1))) * ((int32_t)c.T2)) >> 11;
+  int32_t var2 = (((((adcT >> 4) - ((int32_t)c.T1)) * ((adcT >> 4) - ((int32_t)c.T1))) >> 12) *
+                  ((int32_t)c.T3)) >> 14;
+  return var1 + var2;
+}
+
+inline uint32_t bme280CompensateP(const Bme280Calib& c, int32_t tFine, int32_t adcP) {
+  int64_t var1 = ((int64_t)tFine) - 128000;
+  int64_t var2 = var1 * var1 * (int64_t)c.P6;
+  var2 = var2 + ((var1 * (int64_t)c.P5) * 131072);
+  var2 = var2 + (((int64_t)c.P4) * 34359738368LL);
+  var1 = ((var1 * var1 * (int64_t)c.P3) >> 8) + ((var1 * (int64_t)c.P2) * 4096);
+  var1 = ((((int64_t)1) << 47) + var1) * ((int64_t)c.P1) >> 33;
+  if (var1 == 0) return 0;  // avoid division by zero
+  int64_t p = 1048576 - adcP;
+  p = (((p << 31) - var2) * 3125) / var1;
+  var1 = (((int64_t)c.P9) * (p >> 13) * (p >> 13)) >> 25;
+  var2 = (((int64_t)c.P8) * p) >> 19;
+  p = ((p + var1 + var2) >> 8) + (((int64_t)c.P7) << 4);
+  return (uint32_t)p;
+}
+
+inline uint32_t bme280CompensateH(const Bme280Calib& c, int32_t tFine, int32_t adcH) {
+  int32_t v = tFine - ((int32_t)76800);
+  v = (((((adcH << 14) - (((int32_t)c.H4) << 20) - (((int32_t)c.H5) * v)) + ((int32_t)16384)) >> 15) *
+       (((((((v * ((int32_t)c.H6)) >> 10) * (((v * ((int32_t)c.H3)) >> 11) + ((int32_t)32768))) >> 10) +
+          ((int32_t)2097152)) * ((int32_t)c.H2) + 8192) >> 14));
+  v = (v - (((((v >> 15) * (v >> 15)) >> 7) * ((int32_t)c.H1)) >> 4));
+  v = (v < 0 ? 0 : v);
+  v = (v > 419430400 ? 419430400 : v);
+  return (uint32_t)(v >> 12);
+}
+
+// t_fine is computed once and shared by the pressure and humidity compensation
+inline void bme280Compensate(const Bme280Calib& c, const Bme280Raw& r, Bme280Reading& out) {
+  int32_t tFine = bme280TFine(c, r.temp);
+  out.centiCelsius = (tFine * 5 + 128) >> 8;
+  out.pressureQ8 = bme280CompensateP(c, tFine, r.press);
+  out.humidityQ10 = bme280CompensateH(c, tFine, r.hum);
+}
+
+#endif
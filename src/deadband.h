@@ -0,0 +1,72 @@
+#ifndef DEADBAND_H
+#define DEADBAND_H
+
+#include <stdint.h>
+#include <math.h>
+
+// Per-field change detection for periodic writes. offer() says whether a value is worth
+// writing: the first one, one that moved by more than the field's deadband since the last
+// write, or any value once the field's heartbeat has expired. Offers are staged and only
+// become the new reference on commit(), so a failed upload leaves the field due.
+template <uint8_t N>
+class DeadbandFilter {
+public:
+  struct Rule {
+    float deadband;
+    uint32_t heartbeatMs;
+  };
+
+  explicit DeadbandFilter(const Rule (&rules)[N]) {
+    for (uint8_t i = 0; i < N; i++) {
+      rules_[i] = rules[i];
+      sentValid_[i] = false;
+      staged_[i] = false;
+      sent[i] = 0;
+      suppressed[i] = 0;
+    }
+  }
+
+  bool offer(uint8_t field, float value, uint32_t now) {
+    bool due = !sentValid_[field] || fabsf(value - sentValue_[field]) > rules_[field].deadband ||
+               (uint32_t)(now - sentAt_[field]) >= rules_[field].heartbeatMs;
+    if (!due) {
+      suppressed[field]++;
+      return false;
+    }
+    staged_[field] = true;
+    stagedValue_[field] = value;
+    stagedAt_[field] = now;
+    return true;
+  }
+
+  // The staged values reached the cloud
+  void commit() {
+    for (uint8_t i = 0; i < N; i++) {
+      if (!staged_[i]) continue;
+      sentValid_[i] = true;
+      sentValue_[i] = stagedValue_[i];
+      sentAt_[i] = stagedAt_[i];
+      staged_[i] = false;
+      sent[i]++;
+    }
+  }
+
+  // They did not; the fields stay due
+  void abandon() {
+    for (uint8_t i = 0; i < N; i++) staged_[i] = false;
+  }
+
+  uint32_t sent[N];         // writes that went out
+  uint32_t suppressed[N];   // writes skipped inside the deadband
+
+private:
+  Rule rules_[N];
+  bool sentValid_[N];
+  float sentValue_[N];
+  uint32_t sentAt_[N];
+  bool staged_[N];
+  float stagedValue_[N];
+  uint32_t stagedAt_[N];
+};
+
+#endif
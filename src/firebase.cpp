@@ -218,8 +218,7 @@ int readSoilMoisture() {
 
 // Read soil temperature
 float readSoilTemperature() {
-  soilTempSensor.requestTemperatures();
-  delay(100); // Give sensor time to read
+  soilTempSensor.requestTemperatures(); // Blocks until the conversion is done
   float soilTemp = soilTempSensor.getTempCByIndex(0);
   if (soilTemp == DEVICE_DISCONNECTED_C) {
     Serial.println("Error reading soil temperature!");
@@ -0,0 +1,82 @@
+#ifndef HAL_H
+#define HAL_H
+
+#include <stdint.h>
+#include <ArduinoJson.h>
+#include "scheduler.h"
+#include "bme280Compensation.h"
+#include "adcFilter.h"
+
+// Hardware abstraction for the acquisition and upload pipeline.
+// ESP32 implementations live in halArduino.h, simulated ones in halSim.h, so
+// acquisition.cpp and upload.cpp build unchanged for env:esp32 and env:native.
+
+class DhtInput {
+public:
+  virtual ~DhtInput() {}
+  // 0.01 degC and 0.01 %RH; false on a failed read
+  virtual bool read(int16_t& centiCelsius, int16_t& centiHumidity) = 0;
+};
+
+class SoilTempInput {
+public:
+  enum State { IDLE, CONVERTING, READY };
+
+  virtual ~SoilTempInput() {}
+  virtual bool start(uint32_t now) = 0;    // begin a conversion on every probe
+  virtual bool poll(uint32_t now) = 0;     // true when a fresh reading was collected
+  virtual State state() const = 0;
+  virtual uint16_t conversionMs() const = 0;
+  virtual uint8_t probeCount() const = 0;
+  virtual bool valid(uint8_t probe) const = 0;
+  virtual int16_t centiCelsius(uint8_t probe) const = 0;     // 0.01 degC
+  virtual const uint8_t* address(uint8_t probe) const = 0;   // 8-byte ROM id
+
+  int16_t centiFahrenheit(uint8_t probe) const {
+    int32_t f9 = centiCelsius(probe) * 9;
+    return (int16_t)((f9 >= 0 ? f9 + 2 : f9 - 2) / 5 + 3200);
+  }
+};
+
+class BaroInput {
+public:
+  virtual ~BaroInput() {}
+  virtual bool trigger() = 0;                      // start a measurement ahead of read()
+  virtual bool read(Bme280Reading& out) = 0;
+};
+
+class AnalogInput {
+public:
+  virtual ~AnalogInput() {}
+  virtual int read() = 0;                          // 12-bit counts
+  virtual int millivolts() { return -1; }          // the last read() as characterized input voltage, -1 if unknown
+};
+
+enum UplinkStatus {
+  UPLINK_OK,
+  UPLINK_TOO_LARGE,   // payload does not fit the uplink's buffers, retry with less
+  UPLINK_FAILED,
+};
+
+class Uplink {
+public:
+  virtual ~Uplink() {}
+  // Multi-location update: keys of doc are paths relative to path
+  virtual UplinkStatus update(const char* path, JsonDocument& doc) = 0;
+  virtual const char* errorReason() const = 0;
+};
+
+// Sensors wired into this node; nullptr for a disabled sensor
+struct SensorHal {
+  DhtInput* dht;
+  SoilTempInput* soilTemp;
+  BaroInput* baro;
+  AnalogInput* soilMoisture;
+  const MoistureCal* moistureCal;   // per-probe calibration; nullptr maps raw counts linearly
+  ClockFn clock;
+};
+
+// printf-style diagnostics: Serial on the device, stdout on a host
+void halLog(const char* fmt, ...);
+
+#endif
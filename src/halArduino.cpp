@@ -0,0 +1,137 @@
+#ifdef ARDUINO
+#include "halArduino.h"
+#include "metrics.h"
+#include "sampleRecord.h"
+#include "logRing.h"
+#include <stdarg.h>
+#include <math.h>
+
+// Log lines wait here for the drain task; at 115200 baud 4 KB is ~350 ms of output
+static LogRing<LOG_RING_BYTES> logRing;
+static TaskHandle_t logDrainHandle = nullptr;
+
+void halLog(const char* fmt, ...) {
+  char buf[160];
+  va_list args;
+  va_start(args, fmt);
+  int n = vsnprintf(buf, sizeof(buf), fmt, args);
+  va_end(args);
+  if (n > 0) logRing.push(buf, (size_t)n < sizeof(buf) ? n : sizeof(buf) - 1);
+}
+
+void halLogWrite(const char* text, size_t len) {
+  logRing.push(text, len);
+}
+
+// Reader side of the ring: the drain task, or the caller of halLogFlush() before it exists
+static void logDrain() {
+  static uint32_t reported = 0;
+  char line[LOG_LINE_MAX];
+  size_t n;
+  while ((n = logRing.pop(line, sizeof(line))) > 0) Serial.write((const uint8_t*)line, n);
+  if (logRing.dropped() != reported) {
+    reported = logRing.dropped();
+    Serial.printf("⚠ Log ring full: %u lines dropped\n", (unsigned)reported);
+  }
+}
+
+static void logDrainTask(void*) {
+  for (;;) {
+    logDrain();
+    vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_MS));
+  }
+}
+
+void halLogBegin() {
+  if (logDrainHandle) return;
+  xTaskCreate(logDrainTask, "logDrain", LOG_DRAIN_STACK, nullptr, LOG_DRAIN_PRIORITY, &logDrainHandle);
+}
+
+void halLogFlush() {
+  if (!logDrainHandle) {
+    logDrain();
+  } else {
+    uint32_t start = millis();
+    while (!logRing.empty() && millis() - start < 1000) delay(LOG_DRAIN_MS);
+  }
+  Serial.flush();
+}
+
+uint32_t halLogDropped() {
+  return logRing.dropped();
+}
+
+// The driver only hands out floats; this is the one conversion to fixed point
+bool DhtArduino::read(int16_t& centiCelsius, int16_t& centiHumidity) {
+  float h = dht_.readHumidity();
+  float t = dht_.readTemperature();
+  if (isnan(h) || isnan(t)) return false;
+  centiCelsius = toCenti(t);
+  centiHumidity = toCenti(h);
+  return true;
+}
+
+bool AdafruitBaro::begin() {
+  Wire.begin();
+  return bme_.begin(addr_, &Wire);
+}
+
+bool AdafruitBaro::read(Bme280Reading& out) {
+  float t = bme_.readTemperature();
+  float p = bme_.readPressure();
+  float h = bme_.readHumidity();
+  if (isnan(t) || isnan(p) || isnan(h)) return false;
+  out.centiCelsius = (int32_t)lroundf(t * 100.0f);
+  out.pressureQ8 = (uint32_t)lroundf(p * 256.0f);
+  out.humidityQ10 = (uint32_t)lroundf(h * 1024.0f);
+  return true;
+}
+
+bool FirebaseUplink::serialize(JsonVariantConst value) {
+  METRIC_SCOPE(M_SERIALIZE);
+  size_t len = serializeJson(value, buf_, size_);
+  return len > 0 && len < size_ - 1;
+}
+
+UplinkStatus FirebaseUplink::update(const char* path, JsonDocument& doc) {
+  if (!serialize(doc.as<JsonVariantConst>())) return UPLINK_TOO_LARGE;
+  // setJsonData keeps the slash-separated keys literal; FirebaseJson::set would nest them
+  FirebaseJson fbJson;
+  fbJson.setJsonData(buf_);
+  if (Firebase.RTDB.updateNode(&fbdo_, path, &fbJson)) return UPLINK_OK;
+  strlcpy(error_, fbdo_.errorReason().c_str(), sizeof(error_));
+  return UPLINK_FAILED;
+}
+
+UplinkStatus PerNodeUplink::update(const char* path, JsonDocument& doc) {
+  char nodePath[128];
+  bool overallSuccess = true;
+  for (JsonPairConst kv : doc.as<JsonObjectConst>()) {
+    snprintf(nodePath, sizeof(nodePath), "%s/%s", path, kv.key().c_str());
+    bool ok;
+    if (kv.value().is<JsonObjectConst>()) {
+      if (!serialize(kv.value())) return UPLINK_TOO_LARGE;
+      FirebaseJson fbJson;
+      fbJson.setJsonData(buf_);
+      METRIC_SCOPE(M_RTDB_NODE);
+      ok = Firebase.RTDB.setJSON(&fbdo_, nodePath, &fbJson);
+    } else {
+      METRIC_SCOPE(M_RTDB_NODE);
+      ok = Firebase.RTDB.setFloat(&fbdo_, nodePath, kv.value().as<float>());
+    }
+    if (ok) {
+      LOG_D("✓ %s uploaded\n", kv.key().c_str());
+    } else {
+      LOG_E("✗ %s upload failed: %s\n", kv.key().c_str(), fbdo_.errorReason().c_str());
+      strlcpy(error_, fbdo_.errorReason().c_str(), sizeof(error_));
+      overallSuccess = false;
+    }
+  }
+  return overallSuccess ? UPLINK_OK : UPLINK_FAILED;
+}
+
+UplinkStatus StreamUplink::update(const char* path, JsonDocument& doc) {
+  // The token is owned by the Firebase client, which keeps refreshing it
+  return stream_.update(path, doc, Firebase.getToken()) ? UPLINK_OK : UPLINK_FAILED;
+}
+#endif
@@ -0,0 +1,99 @@
+#ifndef HAL_ARDUINO_H
+#define HAL_ARDUINO_H
+
+#include <Arduino.h>
+#include <DHT.h>
+#include <Adafruit_BME280.h>
+#include <Firebase_ESP_Client.h>
+#include "hal.h"
+#include "logger.h"
+#include "rtdbStream.h"
+
+#define LOG_RING_BYTES 4096       // Queued log output; lines that do not fit are dropped and counted
+#define LOG_DRAIN_MS 20           // Drain task poll period while the ring is empty
+#define LOG_DRAIN_STACK 3072      // Line buffer plus Serial.printf
+#define LOG_DRAIN_PRIORITY 0      // Idle priority: the UART gets whatever time sampling and upload leave
+
+// Starts the task that writes queued log lines to Serial; until then they wait in the ring
+void halLogBegin();
+// Everything queued so far is on the wire, e.g. before deep sleep
+void halLogFlush();
+uint32_t halLogDropped();
+
+// ESP32 implementations of the HAL interfaces.
+// SoilTempReader and Bme280Burst implement their interfaces directly.
+
+class DhtArduino final : public DhtInput {
+public:
+  explicit DhtArduino(DHT& dht) : dht_(dht) {}
+  bool begin() {
+    dht_.begin();
+    return true;   // the DHT protocol has no presence check; a missing sensor fails its reads
+  }
+  bool read(int16_t& centiCelsius, int16_t& centiHumidity) override;
+
+private:
+  DHT& dht_;
+};
+
+class AnalogPin : public AnalogInput {
+public:
+  explicit AnalogPin(uint8_t pin) : pin_(pin) {}
+  int read() override { return analogRead(pin_); }
+
+private:
+  uint8_t pin_;
+};
+
+// Adafruit driver behind BaroInput; the getters re-read the chip for every value
+class AdafruitBaro final : public BaroInput {
+public:
+  explicit AdafruitBaro(Adafruit_BME280& bme, uint8_t addr = 0x76) : bme_(bme), addr_(addr) {}
+  bool begin();
+  // No warm start in the Adafruit driver: resume() is a full begin(), calib() a placeholder
+  void resume(const Bme280Calib&) { begin(); }
+  Bme280Calib calib() const { return Bme280Calib(); }
+  uint16_t measurementMs() const { return 0; }   // normal mode, always has a result
+  bool trigger() override { return true; }
+  bool read(Bme280Reading& out) override;
+
+private:
+  Adafruit_BME280& bme_;
+  uint8_t addr_;
+};
+
+// FirebaseJson copy of the serialized document, sent with one updateNode()
+class FirebaseUplink : public Uplink {
+public:
+  FirebaseUplink(FirebaseData& fbdo, char* buf, size_t size) : fbdo_(fbdo), buf_(buf), size_(size) {}
+  UplinkStatus update(const char* path, JsonDocument& doc) override;
+  const char* errorReason() const override { return error_; }
+
+protected:
+  bool serialize(JsonVariantConst value);
+
+  FirebaseData& fbdo_;
+  char* buf_;
+  size_t size_;
+  char error_[64] = "";
+};
+
+// One setJSON/setFloat request per top-level key, for backends without multi-path updates
+class PerNodeUplink : public FirebaseUplink {
+public:
+  PerNodeUplink(FirebaseData& fbdo, char* buf, size_t size) : FirebaseUplink(fbdo, buf, size) {}
+  UplinkStatus update(const char* path, JsonDocument& doc) override;
+};
+
+// One serializer pass straight into the TLS socket, authenticated with the Firebase client's token
+class StreamUplink : public Uplink {
+public:
+  explicit StreamUplink(RtdbStream& stream) : stream_(stream) {}
+  UplinkStatus update(const char* path, JsonDocument& doc) override;
+  const char* errorReason() const override { return stream_.errorReason(); }
+
+private:
+  RtdbStream& stream_;
+};
+
+#endif
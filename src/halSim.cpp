@@ -0,0 +1,97 @@
+#include "halSim.h"
+#include "logger.h"
+#include "sampleRecord.h"
+#include "scheduler.h"
+#include <stdarg.h>
+#include <stdio.h>
+
+#ifndef ARDUINO
+bool simLogEnabled = true;
+
+void halLog(const char* fmt, ...) {
+  if (!simLogEnabled) return;
+  va_list args;
+  va_start(args, fmt);
+  vprintf(fmt, args);
+  va_end(args);
+}
+
+void halLogWrite(const char* text, size_t len) {
+  if (simLogEnabled) fwrite(text, 1, len, stdout);
+}
+#endif
+
+float SimSignal::next() {
+  state_ ^= state_ << 13;
+  state_ ^= state_ >> 17;
+  state_ ^= state_ << 5;
+  float r = (state_ & 0xFFFF) / 32767.5f - 1.0f;   // -1..1
+  value_ += r * step_;
+  if (value_ < lo_) value_ = lo_;
+  if (value_ > hi_) value_ = hi_;
+  return value_;
+}
+
+bool SimDht::read(int16_t& centiCelsius, int16_t& centiHumidity) {
+  reads_++;
+  centiCelsius = toCenti(temp_.next());
+  centiHumidity = toCenti(hum_.next());
+  return !(failEvery_ && reads_ % failEvery_ == 0);
+}
+
+SimSoilTemp::SimSoilTemp(uint8_t probes, uint8_t resolution)
+  : probes_(probes > MAX_PROBES ? MAX_PROBES : probes), resolution_(resolution), state_(IDLE),
+    startedAt_(0), signal_(19.0f, 0.02f, -5.0f, 40.0f, 41) {
+  for (uint8_t i = 0; i < MAX_PROBES; i++) {
+    static const uint8_t base[8] = { 0x28, 0xff, 0x64, 0x1e, 0x00, 0x00, 0x00, 0x00 };
+    for (uint8_t b = 0; b < 8; b++) rom_[i][b] = base[b];
+    rom_[i][6] = i;
+    centi_[i] = -12700;
+  }
+}
+
+bool SimSoilTemp::start(uint32_t now) {
+  if (state_ == CONVERTING) return false;
+  startedAt_ = now;
+  state_ = CONVERTING;
+  return true;
+}
+
+bool SimSoilTemp::poll(uint32_t now) {
+  if (state_ != CONVERTING || now - startedAt_ < conversionMs()) return false;
+  // Deeper probes lag the surface signal and swing less
+  int16_t surface = toCenti(signal_.next());
+  for (uint8_t i = 0; i < probes_; i++) centi_[i] = surface - 50 * i;
+  state_ = READY;
+  return true;
+}
+
+bool SimBaro::read(Bme280Reading& out) {
+  out.centiCelsius = (int32_t)(temp_.next() * 100.0f);
+  out.pressureQ8 = (uint32_t)(press_.next() * 256.0f);
+  out.humidityQ10 = (uint32_t)(hum_.next() * 1024.0f);
+  return true;
+}
+
+UplinkStatus SimUplink::update(const char*, JsonDocument& doc) {
+  requests++;
+  if (!online) {
+    failures++;
+    FakeClock::advance(failDelayMs);
+    return UPLINK_FAILED;
+  }
+  bytes += measureJson(doc);
+  return UPLINK_OK;
+}
+
+UplinkStatus CaptureUplink::update(const char*, JsonDocument& doc) {
+  if (!online) return UPLINK_FAILED;
+  if (maxNodes && doc.size() > maxNodes) {
+    tooLarge++;
+    return UPLINK_TOO_LARGE;
+  }
+  nodes.clear();
+  for (JsonPair kv : doc.as<JsonObject>()) serializeJson(kv.value(), nodes[kv.key().c_str()]);
+  for (const auto& node : nodes) written[node.first] = node.second;
+  return UPLINK_OK;
+}
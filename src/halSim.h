@@ -0,0 +1,117 @@
+#ifndef HAL_SIM_H
+#define HAL_SIM_H
+
+#include <map>
+#include <string>
+#include "hal.h"
+
+// Simulated HAL for host builds: deterministic sensor signals and an in-memory uplink,
+// so the acquisition and upload pipeline can be profiled without hardware.
+
+// Bounded random walk (xorshift32), repeatable for a given seed
+class SimSignal {
+public:
+  SimSignal(float start, float step, float lo, float hi, uint32_t seed)
+    : value_(start), step_(step), lo_(lo), hi_(hi), state_(seed ? seed : 1) {}
+  float next();
+
+private:
+  float value_, step_, lo_, hi_;
+  uint32_t state_;
+};
+
+class SimDht : public DhtInput {
+public:
+  explicit SimDht(uint32_t failEvery = 0) : temp_(24.0f, 0.1f, 5.0f, 45.0f, 11),
+    hum_(60.0f, 0.5f, 20.0f, 95.0f, 12), failEvery_(failEvery), reads_(0) {}
+  bool begin() { return true; }
+  bool read(int16_t& centiCelsius, int16_t& centiHumidity) override;
+
+private:
+  SimSignal temp_, hum_;
+  uint32_t failEvery_;   // every Nth read fails like a missed DHT handshake, 0 = never
+  uint32_t reads_;
+};
+
+class SimSoilTemp : public SoilTempInput {
+public:
+  explicit SimSoilTemp(uint8_t probes = 1, uint8_t resolution = 12);
+  bool begin(uint8_t resolution) {
+    resolution_ = resolution;
+    return probes_ > 0;
+  }
+  bool start(uint32_t now) override;
+  bool poll(uint32_t now) override;
+  State state() const override { return state_; }
+  uint16_t conversionMs() const override { return 750 >> (12 - resolution_); }
+  uint8_t probeCount() const override { return probes_; }
+  bool valid(uint8_t probe) const override { return probe < probes_; }
+  int16_t centiCelsius(uint8_t probe) const override { return probe < probes_ ? centi_[probe] : -12700; }
+  const uint8_t* address(uint8_t probe) const override { return rom_[probe]; }
+
+private:
+  static const uint8_t MAX_PROBES = 4;
+  uint8_t probes_;
+  uint8_t resolution_;
+  State state_;
+  uint32_t startedAt_;
+  uint8_t rom_[MAX_PROBES][8];
+  int16_t centi_[MAX_PROBES];
+  SimSignal signal_;
+};
+
+class SimBaro : public BaroInput {
+public:
+  SimBaro() : temp_(22.0f, 0.05f, 0.0f, 40.0f, 21), press_(101325.0f, 5.0f, 95000.0f, 105000.0f, 22),
+    hum_(55.0f, 0.3f, 10.0f, 95.0f, 23) {}
+  bool begin() { return true; }
+  uint16_t measurementMs() const { return 10; }   // forced mode, like Bme280Burst
+  bool trigger() override { return true; }
+  bool read(Bme280Reading& out) override;
+
+private:
+  SimSignal temp_, press_, hum_;
+};
+
+class SimAnalog : public AnalogInput {
+public:
+  SimAnalog() : signal_(1800.0f, 15.0f, 0.0f, 4095.0f, 31), last_(0) {}
+  bool begin() { return true; }
+  int read() override { return last_ = (int)signal_.next(); }
+  int millivolts() override { return last_ * 3100 / 4095; }   // 11 dB attenuation, ideal
+
+private:
+  SimSignal signal_;
+  int last_;
+};
+
+// Accepts updates in memory and accounts requests and payload bytes
+class SimUplink : public Uplink {
+public:
+  UplinkStatus update(const char* path, JsonDocument& doc) override;
+  const char* errorReason() const override { return online ? "" : reason; }
+
+  bool online = true;
+  const char* reason = "simulated outage";   // errorReason() while offline
+  uint32_t failDelayMs = 0;   // FakeClock time a failed request costs, e.g. a connect timeout
+  uint32_t requests = 0;
+  uint32_t failures = 0;
+  uint64_t bytes = 0;
+};
+
+// Keeps every node of the last update, serialized, for checks on what went up
+class CaptureUplink : public Uplink {
+public:
+  UplinkStatus update(const char* path, JsonDocument& doc) override;
+  const char* errorReason() const override { return online ? "" : "simulated outage"; }
+
+  bool online = true;
+  size_t maxNodes = 0;        // an update with more nodes is UPLINK_TOO_LARGE; 0 for no limit
+  uint32_t tooLarge = 0;
+  std::map<std::string, std::string> nodes;
+  std::map<std::string, std::string> written;   // every node any update wrote, newest value
+};
+
+extern bool simLogEnabled;   // halLog output on the host, off for benchmark runs
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef HEAP_AUDIT_H
+#define HEAP_AUDIT_H
+
+#include <stdint.h>
+#include <esp_heap_caps.h>
+
+// Snapshot of the 8-bit capable heap, used to check that a steady-state cycle
+// leaves no net allocations and does not fragment the heap.
+struct HeapSnapshot {
+  uint32_t freeBytes;
+  uint32_t blocks;
+  uint32_t largestFree;
+
+  static HeapSnapshot take() {
+    multi_heap_info_t info;
+    heap_caps_get_info(&info, MALLOC_CAP_8BIT);
+    HeapSnapshot s = { (uint32_t)info.total_free_bytes, (uint32_t)info.allocated_blocks,
+                       (uint32_t)info.largest_free_block };
+    return s;
+  }
+};
+
+#endif
@@ -0,0 +1,84 @@
+#include "heatIndex.h"
+
+// The table is generated by the compiler from the same regression as heatIndexRothfusz(),
+// in double precision, and lands in flash; nothing of it runs on the device. C++11
+// constexpr functions are single expressions, hence the index packs.
+//
+// The NWS formula is piecewise: the simple formula below 79 degF, the regression above,
+// and two corrections that switch on at 80 degF. Interpolating across those steps would
+// smear them over a whole cell, so the table holds the smooth regression only and the
+// branches are taken at runtime: the simple formula and the humid correction in integers,
+// the dry correction (below 13 %RH, under the DHT11's range) through the float formula.
+
+namespace {
+
+constexpr double hiRegressionF(double t, double h) {
+  return -42.379 + 2.04901523 * t + 10.14333127 * h +
+         -0.22475541 * t * h +
+         -0.00683783 * t * t +
+         -0.05481717 * h * h +
+         0.00122874 * t * t * h +
+         0.00085282 * t * h * h +
+         -0.00000199 * t * t * h * h;
+}
+
+constexpr int16_t hiRound(double centi) { return (int16_t)(centi < 0 ? centi - 0.5 : centi + 0.5); }
+
+constexpr int16_t hiCell(int rh, int t) {
+  return hiRound((hiRegressionF((HEAT_INDEX_T_MIN + t * HEAT_INDEX_T_STEP) * 1.8 + 32.0,
+                               rh * HEAT_INDEX_RH_STEP) - 32.0) / 1.8 * 100.0);
+}
+
+template <int... I> struct Seq {};
+template <int N, int... I> struct MakeSeq : MakeSeq<N - 1, N - 1, I...> {};
+template <int... I> struct MakeSeq<0, I...> { typedef Seq<I...> type; };
+
+struct Row { int16_t t[HEAT_INDEX_T_POINTS]; };
+struct Table { Row rh[HEAT_INDEX_RH_POINTS]; };
+
+template <int... T>
+constexpr Row makeRow(int rh, Seq<T...>) { return Row{ { hiCell(rh, T)... } }; }
+
+template <int... RH>
+constexpr Table makeTable(Seq<RH...>) {
+  return Table{ { makeRow(RH, MakeSeq<HEAT_INDEX_T_POINTS>::type())... } };
+}
+
+constexpr Table table = makeTable(MakeSeq<HEAT_INDEX_RH_POINTS>::type());
+
+}  // namespace
+
+int16_t heatIndexCenti(int16_t centiCelsius, int16_t centiHumidity) {
+  const int32_t tSpan = HEAT_INDEX_T_STEP * 100, hSpan = HEAT_INDEX_RH_STEP * 100;
+  int32_t t = centiCelsius - HEAT_INDEX_T_MIN * 100;
+  int32_t h = centiHumidity;
+  if (t < 0 || t > (HEAT_INDEX_T_POINTS - 1) * tSpan || h < 0 || h > 10000) {
+    return (int16_t)lroundf(heatIndexRothfusz(centiCelsius / 100.0f, centiHumidity / 100.0f) * 100.0f);
+  }
+
+  // Simple formula, scaled so that n / 5000 is the heat index in 0.01 degF
+  int32_t n = 9900 * (int32_t)centiCelsius + 235 * (int32_t)centiHumidity + 12450000;
+  if (n <= 7900 * 5000) return (int16_t)((n - 16000000 + (n >= 16000000 ? 4500 : -4500)) / 9000);
+
+  // 80..112 degF in 9 x 0.01 degC
+  int32_t c9 = 9 * (int32_t)centiCelsius;
+  if (h < 1300 && c9 >= 24000 && c9 <= 40400) {
+    return (int16_t)lroundf(heatIndexRothfusz(centiCelsius / 100.0f, centiHumidity / 100.0f) * 100.0f);
+  }
+  int32_t humid = 0;
+  if (h > 8500 && c9 >= 24000 && c9 <= 27500) humid = (h - 8500) * (27500 - c9) / 45000;
+
+  // The last row and column interpolate from the cell before them
+  int32_t col = t / tSpan, row = h / hSpan;
+  if (col == HEAT_INDEX_T_POINTS - 1) col--;
+  if (row == HEAT_INDEX_RH_POINTS - 1) row--;
+  int32_t tf = t - col * tSpan, hf = h - row * hSpan;
+
+  const Row& lo = table.rh[row];
+  const Row& up = table.rh[row + 1];
+  int32_t a = lo.t[col] * (tSpan - tf) + lo.t[col + 1] * tf;
+  int32_t b = up.t[col] * (tSpan - tf) + up.t[col + 1] * tf;
+  int32_t v = a * (hSpan - hf) + b * hf;
+  const int32_t scale = tSpan * hSpan;
+  return (int16_t)((v >= 0 ? (v + scale / 2) / scale : (v - scale / 2) / scale) + humid);
+}
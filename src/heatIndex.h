@@ -0,0 +1,42 @@
+#ifndef HEAT_INDEX_H
+#define HEAT_INDEX_H
+
+#include <stdint.h>
+#include <math.h>
+
+// NWS heat index (Rothfusz regression with the low-humidity and high-humidity adjustments),
+// the same formula DHT::computeHeatIndex uses. Celsius in, Celsius out.
+inline float heatIndexRothfusz(float celsius, float humidity) {
+  float t = celsius * 1.8f + 32.0f;
+  float hi = 0.5f * (t + 61.0f + ((t - 68.0f) * 1.2f) + (humidity * 0.094f));
+  if (hi > 79.0f) {
+    hi = -42.379f + 2.04901523f * t + 10.14333127f * humidity +
+         -0.22475541f * t * humidity +
+         -0.00683783f * t * t +
+         -0.05481717f * humidity * humidity +
+         0.00122874f * t * t * humidity +
+         0.00085282f * t * humidity * humidity +
+         -0.00000199f * t * t * humidity * humidity;
+    if (humidity < 13.0f && t >= 80.0f && t <= 112.0f) {
+      hi -= ((13.0f - humidity) * 0.25f) * sqrtf((17.0f - fabsf(t - 95.0f)) * 0.05882f);
+    } else if (humidity > 85.0f && t >= 80.0f && t <= 87.0f) {
+      hi += ((humidity - 85.0f) * 0.1f) * ((87.0f - t) * 0.2f);
+    }
+  }
+  return (hi - 32.0f) / 1.8f;
+}
+
+// Grid of the compile-time table behind heatIndexCenti(): the DHT11's whole range,
+// 0..50 degC in 1 degC steps (its resolution) by 0..100 %RH in 5 % steps (its accuracy)
+#define HEAT_INDEX_T_MIN 0
+#define HEAT_INDEX_T_MAX 50
+#define HEAT_INDEX_T_STEP 1
+#define HEAT_INDEX_RH_STEP 5
+#define HEAT_INDEX_T_POINTS ((HEAT_INDEX_T_MAX - HEAT_INDEX_T_MIN) / HEAT_INDEX_T_STEP + 1)
+#define HEAT_INDEX_RH_POINTS (100 / HEAT_INDEX_RH_STEP + 1)
+
+// Heat index in 0.01 degC from 0.01 degC and 0.01 %RH: bilinear interpolation in the table,
+// integer only. Inputs outside the grid fall back to heatIndexRothfusz().
+int16_t heatIndexCenti(int16_t centiCelsius, int16_t centiHumidity);
+
+#endif
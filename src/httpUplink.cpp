@@ -0,0 +1,178 @@
+#ifndef ARDUINO
+#include "httpUplink.h"
+#include "socketIo.h"
+#include "metrics.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <strings.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <chrono>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/time.h>
+
+typedef std::chrono::steady_clock HostClock;
+
+static double elapsedUs(HostClock::time_point start) {
+  return std::chrono::duration<double, std::micro>(HostClock::now() - start).count();
+}
+
+// ArduinoJson writer that emits HTTP/1.1 chunks, like ChunkedPrint on the device
+class SocketChunkWriter {
+public:
+  explicit SocketChunkWriter(int fd) : fd_(fd), len_(0), total_(0), wire_(0), failed_(false) {}
+
+  size_t write(uint8_t c) { return write(&c, 1); }
+
+  size_t write(const uint8_t* buf, size_t size) {
+    if (failed_) return 0;
+    size_t done = 0;
+    while (done < size) {
+      size_t n = size - done;
+      if (n > sizeof(buf_) - len_) n = sizeof(buf_) - len_;
+      memcpy(buf_ + len_, buf + done, n);
+      len_ += n;
+      done += n;
+      if (len_ == sizeof(buf_) && !flushChunk()) return 0;
+    }
+    total_ += size;
+    return size;
+  }
+
+  bool finish() {
+    if (!flushChunk()) return false;
+    wire_ += 5;
+    return sendAll(fd_, "0\r\n\r\n", 5);
+  }
+
+  size_t total() const { return total_; }
+  size_t wire() const { return wire_; }
+
+private:
+  bool flushChunk() {
+    if (len_ == 0) return true;
+    char head[8];
+    int h = snprintf(head, sizeof(head), "%x\r\n", (unsigned)len_);
+    failed_ = !sendAll(fd_, head, h) || !sendAll(fd_, buf_, len_) || !sendAll(fd_, "\r\n", 2);
+    wire_ += h + len_ + 2;
+    len_ = 0;
+    return !failed_;
+  }
+
+  int fd_;
+  uint8_t buf_[HTTP_UPLINK_CHUNK];
+  size_t len_;
+  size_t total_;
+  size_t wire_;
+  bool failed_;
+};
+
+bool HttpUplink::connect() {
+  if (fd_ >= 0) return true;
+  addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  char port[8];
+  snprintf(port, sizeof(port), "%u", (unsigned)port_);
+  addrinfo* res = nullptr;
+  if (getaddrinfo(host_, port, &hints, &res) != 0) return false;
+
+  fd_ = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+  bool ok = fd_ >= 0 && ::connect(fd_, res->ai_addr, res->ai_addrlen) == 0;
+  freeaddrinfo(res);
+  if (!ok) {
+    disconnect();
+    return false;
+  }
+  timeval tv = { HTTP_UPLINK_TIMEOUT / 1000, (HTTP_UPLINK_TIMEOUT % 1000) * 1000 };
+  setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  int one = 1;
+  setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  connects++;
+  return true;
+}
+
+void HttpUplink::disconnect() {
+  if (fd_ >= 0) close(fd_);
+  fd_ = -1;
+}
+
+UplinkStatus HttpUplink::fail(const char* reason) {
+  error_ = reason;
+  disconnect();
+  return UPLINK_FAILED;
+}
+
+UplinkStatus HttpUplink::update(const char* path, JsonDocument& doc) {
+  httpCode_ = 0;
+  error_ = "";
+  sendUs = 0;
+  waitUs = 0;
+  if (!connect()) return fail("connection refused");
+  requests++;
+
+  HostClock::time_point start = HostClock::now();
+  char head[256];
+  int n = snprintf(head, sizeof(head),
+                   "PATCH %s%s.json?print=silent&auth=%s HTTP/1.1\r\nHost: %s\r\n"
+                   "Content-Type: application/json\r\nTransfer-Encoding: chunked\r\n"
+                   "Connection: keep-alive\r\n\r\n",
+                   path[0] == '/' ? "" : "/", path, idToken_, host_);
+  if (n <= 0 || n >= (int)sizeof(head) || !sendAll(fd_, head, n)) return fail("send failed");
+
+  SocketChunkWriter body(fd_);
+  {
+    METRIC_SCOPE(M_SERIALIZE);
+    serializeJson(doc, body);
+  }
+  bool sent = body.finish();
+  bytesOut += n + body.wire();
+  bodyBytes += body.total();
+  sendUs = elapsedUs(start);
+  if (!sent) return fail("send failed");
+
+  start = HostClock::now();
+  bool ok = readResponse();
+  waitUs = elapsedUs(start);
+  return ok ? UPLINK_OK : UPLINK_FAILED;
+}
+
+// Mirrors RtdbStream::readResponse(): status, headers, drain any error body
+bool HttpUplink::readResponse() {
+  SocketReader in(fd_);
+  char line[128];
+  if (!in.readLine(line, sizeof(line))) {
+    bytesIn += in.total();
+    fail("response timeout");
+    return false;
+  }
+  if (strncmp(line, "HTTP/1.", 7) != 0) {
+    bytesIn += in.total();
+    fail("bad response");
+    return false;
+  }
+  httpCode_ = atoi(line + 9);
+
+  long contentLength = 0;
+  bool close = false;
+  while (in.readLine(line, sizeof(line)) && line[0] != '\0') {
+    if (strncasecmp(line, "Content-Length:", 15) == 0) contentLength = atol(line + 15);
+    if (strncasecmp(line, "Connection: close", 17) == 0) close = true;
+  }
+  if (contentLength > 0 && !in.skip((size_t)contentLength)) close = true;
+  bytesIn += in.total();
+  if (close) disconnect();
+
+  if (httpCode_ >= 200 && httpCode_ < 300) return true;
+  switch (httpCode_) {
+    case 401: error_ = "permission denied"; break;
+    case 400: error_ = "bad request"; break;
+    case 404: error_ = "not found"; break;
+    case 412: error_ = "precondition failed"; break;
+    default: error_ = httpCode_ >= 500 ? "server error" : "request failed"; break;
+  }
+  return false;
+}
+#endif
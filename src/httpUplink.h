@@ -0,0 +1,49 @@
+#ifndef HTTP_UPLINK_H
+#define HTTP_UPLINK_H
+
+#ifndef ARDUINO
+#include "hal.h"
+
+#define HTTP_UPLINK_CHUNK 1024     // Same chunking as RTDB_STREAM_CHUNK
+#define HTTP_UPLINK_TIMEOUT 5000
+
+// Host counterpart of StreamUplink: plain-TCP RTDB REST client that puts the same bytes
+// on the wire as RtdbStream (PATCH <path>.json?print=silent, chunked body, keep-alive),
+// for benchmarking the upload path against MockRtdb.
+class HttpUplink : public Uplink {
+public:
+  HttpUplink(const char* host, uint16_t port, const char* idToken = "")
+    : host_(host), port_(port), idToken_(idToken) {}
+  ~HttpUplink() { disconnect(); }
+
+  UplinkStatus update(const char* path, JsonDocument& doc) override;
+  const char* errorReason() const override { return error_; }
+  int httpCode() const { return httpCode_; }
+
+  // Per-request split of the last update(), host microseconds
+  double sendUs = 0;       // headers plus serializeJson into the socket
+  double waitUs = 0;       // until the status line and headers are read
+
+  // Totals
+  uint32_t requests = 0;
+  uint32_t connects = 0;
+  uint64_t bytesOut = 0;   // everything written: request line, headers, chunk framing, body
+  uint64_t bytesIn = 0;
+  uint64_t bodyBytes = 0;
+
+private:
+  bool connect();
+  void disconnect();
+  UplinkStatus fail(const char* reason);
+  bool readResponse();
+
+  const char* host_;
+  uint16_t port_;
+  const char* idToken_;
+  int fd_ = -1;
+  int httpCode_ = 0;
+  const char* error_ = "";
+};
+#endif
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef LIVE_SAMPLE_H
+#define LIVE_SAMPLE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <atomic>
+#include <ArduinoJson.h>
+
+// The newest sample documents, in full, from the acquisition task to the upload task.
+// SampleQueue carries SampleRecords, which leave out what only the live nodes show (each
+// probe's ROM and reading, BME280 altitude, soil millivolts, a sensor's "error"), so the
+// upload task takes 'latest' and its lastReadings/<ts> entry from here instead.
+//
+// The producer serializes each document into the older of two buffers, before pushing
+// its record, so the document of the newest record a consumer pops is still here unless
+// two more samples came in meanwhile. Each buffer has a sequence count that is odd while
+// it is being written; a reader that sees it change throws its copy away. Neither side
+// ever waits for the other.
+template <size_t SIZE>
+class LiveSampleSlot {
+public:
+  LiveSampleSlot() : next_(0), tooLarge_(0) {
+    for (uint8_t i = 0; i < 2; i++) {
+      seq_[i].store(0, std::memory_order_relaxed);
+      bufs_[i].timestamp = 0;
+      bufs_[i].text[0] = 0;
+    }
+  }
+
+  // Producer only. False if the document does not fit; the consumer falls back to the record.
+  bool publish(uint64_t timestamp, JsonDocument& doc) {
+    Buffer& b = bufs_[next_];
+    std::atomic<uint32_t>& seq = seq_[next_];
+    uint32_t s = seq.load(std::memory_order_relaxed);
+    seq.store(s + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    bool fits = measureJson(doc) < SIZE;
+    b.timestamp = fits ? timestamp : 0;
+    if (fits) serializeJson(doc, b.text, SIZE);
+    seq.store(s + 2, std::memory_order_release);
+    next_ ^= 1;
+    if (!fits) tooLarge_++;
+    return fits;
+  }
+
+  // Consumer only: the document published for timestamp into doc; false if it is no longer here
+  bool take(uint64_t timestamp, JsonDocument& doc) {
+    for (uint8_t i = 0; i < 2; i++) {
+      uint32_t s = seq_[i].load(std::memory_order_acquire);
+      if (s & 1) continue;
+      uint64_t ts = bufs_[i].timestamp;
+      if (ts == timestamp) memcpy(scratch_, bufs_[i].text, SIZE);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (ts != timestamp || seq_[i].load(std::memory_order_relaxed) != s) continue;
+      scratch_[SIZE - 1] = 0;
+      return !deserializeJson(doc, (const char*)scratch_);
+    }
+    return false;
+  }
+
+  uint32_t tooLarge() const { return tooLarge_; }   // producer side
+
+private:
+  struct Buffer {
+    uint64_t timestamp;
+    char text[SIZE];
+  };
+  Buffer bufs_[2];
+  std::atomic<uint32_t> seq_[2];
+  uint8_t next_;         // producer only
+  uint32_t tooLarge_;    // producer only
+  char scratch_[SIZE];   // consumer only: the copy being checked
+};
+
+#endif
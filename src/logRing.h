@@ -0,0 +1,113 @@
+#ifndef LOG_RING_H
+#define LOG_RING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <atomic>
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+
+// Fixed-size byte ring of log lines for any number of writer tasks and one reader. A writer
+// formats on its own stack and only copies the finished line in under a short lock (a
+// portMUX section on the ESP32, a spinlock on a host), so it never waits on the UART. The
+// reader drains without the lock: tail_ is written only by the reader and hands the space
+// back with release/acquire, as in SpscQueue. Each line is a 2-byte length and its text,
+// wrapping at the end of the buffer.
+//
+// Drop policy: a line that does not fit is rejected whole and counted, so the reader never
+// sees half a line and the lines already queued keep their order.
+template <size_t N>
+class LogRing {
+  static_assert(N >= 64 && N <= 65536 && (N & (N - 1)) == 0, "capacity must be a power of two");
+
+public:
+  LogRing() : head_(0), dropped_(0), highWater_(0), tail_(0) {
+#ifndef ARDUINO
+    lock_.clear();
+#endif
+  }
+
+  // Any task; a line longer than the ring is cut to fit
+  bool push(const char* text, size_t len) {
+    if (len == 0) return true;
+    if (len > N - 2) len = N - 2;
+    lock();
+    uint32_t head = head_.load(std::memory_order_relaxed);
+    uint32_t used = head - tail_.load(std::memory_order_acquire);
+    if (used + 2 + len > N) {
+      dropped_.store(dropped_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      unlock();
+      return false;
+    }
+    uint8_t hdr[2] = { (uint8_t)len, (uint8_t)(len >> 8) };
+    put(head, hdr, 2);
+    put(head + 2, text, len);
+    head_.store(head + 2 + len, std::memory_order_release);
+    used += 2 + len;
+    if (used > highWater_.load(std::memory_order_relaxed)) highWater_.store(used, std::memory_order_relaxed);
+    unlock();
+    return true;
+  }
+
+  // Reader only: the oldest line into out, cut to max; returns its length, 0 when empty
+  size_t pop(char* out, size_t max) {
+    uint32_t tail = tail_.load(std::memory_order_relaxed);
+    if (head_.load(std::memory_order_acquire) == tail) return 0;
+    uint8_t hdr[2];
+    get(tail, hdr, 2);
+    size_t len = hdr[0] | (size_t)hdr[1] << 8;
+    size_t n = len < max ? len : max;
+    get(tail + 2, out, n);
+    tail_.store(tail + 2 + len, std::memory_order_release);
+    return n;
+  }
+
+  // Either side; a snapshot that may be stale by the time it is used
+  size_t size() const {
+    uint32_t tail = tail_.load(std::memory_order_acquire);
+    return head_.load(std::memory_order_acquire) - tail;
+  }
+  bool empty() const { return size() == 0; }
+  static size_t capacity() { return N; }
+  uint32_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+  uint32_t highWater() const { return highWater_.load(std::memory_order_relaxed); }   // bytes
+
+private:
+#ifdef ARDUINO
+  void lock() { portENTER_CRITICAL(&mux_); }
+  void unlock() { portEXIT_CRITICAL(&mux_); }
+#else
+  void lock() { while (lock_.test_and_set(std::memory_order_acquire)) {} }
+  void unlock() { lock_.clear(std::memory_order_release); }
+#endif
+
+  void put(uint32_t at, const void* src, size_t n) {
+    size_t i = at & (N - 1);
+    size_t first = N - i < n ? N - i : n;
+    memcpy(buf_ + i, src, first);
+    memcpy(buf_, (const uint8_t*)src + first, n - first);
+  }
+
+  void get(uint32_t at, void* dst, size_t n) const {
+    size_t i = at & (N - 1);
+    size_t first = N - i < n ? N - i : n;
+    memcpy(dst, buf_ + i, first);
+    memcpy((uint8_t*)dst + first, buf_, n - first);
+  }
+
+  uint8_t buf_[N];
+#ifdef ARDUINO
+  portMUX_TYPE mux_ = portMUX_INITIALIZER_UNLOCKED;
+#else
+  std::atomic_flag lock_;
+#endif
+  // Writer-side and reader-side state on separate cache lines (ESP32 has none, hosts do)
+  alignas(64) std::atomic<uint32_t> head_;
+  std::atomic<uint32_t> dropped_;
+  std::atomic<uint32_t> highWater_;
+  alignas(64) std::atomic<uint32_t> tail_;
+};
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <stddef.h>
+#include "hal.h"
+
+// Leveled logging on top of halLog. The level is fixed at compile time: a call above
+// LOG_LEVEL expands to nothing, arguments included, so filtered lines cost neither flash
+// nor formatting. On the device halLog only queues the line (halArduino.cpp); a
+// low-priority task writes it to the UART, off the sampling and upload paths.
+//
+// -DLOG_LEVEL=LOG_LEVEL_INFO drops the per-sample JSON echo and the per-node upload lines;
+// LOG_LEVEL_WARN also drops every success line, for production builds.
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1         // ✗ something failed
+#define LOG_LEVEL_WARN 2          // ⚠ degraded, still running
+#define LOG_LEVEL_INFO 3          // ✓ state changes and one summary line per cycle
+#define LOG_LEVEL_DEBUG 4         // per-sample JSON echo, per-node and banner lines
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_DEBUG
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_E(...) halLog(__VA_ARGS__)
+#else
+#define LOG_E(...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_W(...) halLog(__VA_ARGS__)
+#else
+#define LOG_W(...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_I(...) halLog(__VA_ARGS__)
+#else
+#define LOG_I(...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_D(...) halLog(__VA_ARGS__)
+#else
+#define LOG_D(...) do {} while (0)
+#endif
+
+#define LOG_LINE_MAX 512          // Longest line the drain writes in one piece (the JSON echo)
+
+// A line that is already formatted; not filtered
+void halLogWrite(const char* text, size_t len);
+
+// A JSON document as one line, cut at LOG_LINE_MAX
+template <typename T>
+void halLogJson(const T& value) {
+  char line[LOG_LINE_MAX];
+  size_t n = serializeJson(value, line, sizeof(line) - 1);
+  line[n++] = '\n';
+  halLogWrite(line, n);
+}
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_D_JSON(value) halLogJson(value)
+#else
+#define LOG_D_JSON(value) do {} while (0)
+#endif
+
+#endif
@@ -7,161 +7,486 @@
 #include <Firebase_ESP_Client.h>
 #include <addons/TokenHelper.h>
 #include <addons/RTDBHelper.h>
-
-// Enable/disable sensors here
-// #define ENABLE_BME280      // BME280 temperature, pressure, humidity, altitude
-#define ENABLE_DHT11       // DHT11 temperature, humidity, heat index
-#define ENABLE_SOIL_MOISTURE  // Soil moisture sensor
-#define ENABLE_SOIL_TEMP      // DS18B20 soil temperature sensor
-
-// RTDB creds
-#define FARM_OWNER "Niranj"        // Farm owner name
-#define NODE_NAME "/Node1"          // Node name
-#define FARM_SIZE 12
-void connectToWiFi();
-void initializeFirebase();
-void uploadSensorData(JsonDocument&);
+#include "nodeConfig.h"
+#include "scheduler.h"
+#include "hal.h"
+#include "halArduino.h"
+#include "acquisition.h"
+#include "upload.h"
+#include "metrics.h"
+#include "wifiLink.h"
+#include "authSession.h"
+#include "uplinkHealth.h"
+#include "logger.h"
+
+// Sensors are chosen in the registry below
+#define BME280_BURST_READ     // BME280 via one forced-mode burst read instead of the Adafruit getters
+
+// Upload mode
+#define ENABLE_FANOUT_UPLOAD  // One atomic multi-path update per cycle instead of one request per node
+#define ENABLE_OFFLINE_LOG    // Keep samples on flash while offline and replay them in batches
+#define ENABLE_STREAM_UPLOAD  // Serialize fan-out documents straight into the TLS socket, no FirebaseJson copy
+#define ENABLE_DUAL_CORE      // Upload in its own task on core 0, fed by a lock-free queue from sampling
+#define ENABLE_AGGREGATION    // Upload one min/max/mean/sd summary per AGG_WINDOW_MS instead of every raw sample
+#define ENABLE_SAMPLE_CLOCK   // Sample on hardware-timer alarms at SNTP epoch boundaries; keys are epoch ms, not millis()
+// #define ENABLE_DEEP_SLEEP  // Battery mode: wake on a timer, batch samples in RTC memory, upload every few wakes
+// #define WIFI_REUSE_LEASE   // Reconnect with the last DHCP lease as a static IP (needs a reservation on the router)
+// #define UPLOAD_PATH_BENCH  // At boot, compare CPU time and heap of the FirebaseJson and streamed paths
+// #define UPLOAD_HEAP_ASSERT     // Report any net heap change across a steady-state upload cycle
+
+bool connectToWiFi();
+void initializeFirebase(bool wait = true);
 FirebaseData fbdo;
 FirebaseAuth auth;
 FirebaseConfig config;
-#define UPLOAD_INTERVAL 2000
+#define PRINT_PHASE 10            // Print runs just after the sample that shares its period
+#define UPLOAD_PHASE 20
+
+#define WIFI_CONNECT_TIMEOUT 10000
+WifiLink wifiLink;
 
 // Variables
-unsigned long lastUploadTime = 0;
 bool firebaseReady = false;
 bool signupOK = false;
+bool firebaseStarted = false;     // config, session and Firebase.begin done; retries only wait for ready()
+
+// Uplink the fan-out documents are committed through
+#define UPLOAD_JSON_SIZE 8192
+char uploadJson[UPLOAD_JSON_SIZE];    // Serialization buffer for the FirebaseJson uplinks
+#if !defined(ENABLE_FANOUT_UPLOAD)
+PerNodeUplink uplink(fbdo, uploadJson, sizeof(uploadJson));
+#elif defined(ENABLE_STREAM_UPLOAD)
+RtdbStream rtdbStream;
+StreamUplink uplink(rtdbStream);
+#else
+FirebaseUplink uplink(fbdo, uploadJson, sizeof(uploadJson));
+#endif
+
+#ifdef UPLOAD_PATH_BENCH
+void benchUploadPaths();
+#endif
+
+#ifdef UPLOAD_HEAP_ASSERT
+#include "heapAudit.h"
+#define HEAP_ASSERT_WARMUP 5      // First cycles set up TLS/auth state and are not checked
+uint32_t heapCycles = 0;
+uint32_t heapViolations = 0;
+void checkHeapDelta(const HeapSnapshot& before);
+#endif
+
+// Scheduler: sample, serial output and upload each run on their own deadline
+static uint32_t clockMillis() { return millis(); }
+Scheduler<8> scheduler(clockMillis);
+
+// Uplink health: backoff and circuit breaker in front of the uplink, so an outage costs
+// a probe now and then instead of a blocking re-init every cycle
+UplinkHealth uplinkHealth;
+GuardedUplink guardedUplink(uplink, uplinkHealth, clockMillis);
+Uplink* activeUplink(uint32_t now);
+JsonDocument sampleDoc;           // Most recent sample set
+SampleRecord sampleRec;           // The same, in fixed point
+bool sampleUploaded = true;
+void sampleTask();
+void uploadTask();
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+bool samplePrinted = true;
+void printTask();
+#endif
+
+#ifdef ENABLE_DUAL_CORE
+// loop() keeps sampling on core 1; TLS stalls in the upload task can no longer delay it
+#define UPLOAD_CORE 0             // PRO_CPU, alongside the WiFi/lwIP tasks
+#define UPLOAD_STACK 12288        // TLS handshake plus the fan-out serializer
+#define UPLOAD_PRIORITY 1
+SampleQueue sampleQueue;
+LiveSample liveSample;   // the queued samples' documents, for the live nodes
+TaskHandle_t uploadHandle = nullptr;
+uint32_t queueDropsReported = 0;
+void uploadLoop(void*);
+#endif
 
+#ifdef ENABLE_SAMPLE_CLOCK
+#include "sampleTimer.h"
+// Samples start on multiples of SAMPLE_INTERVAL in epoch time, woken by the timer alarm
+SampleClock sampleClock(SAMPLE_INTERVAL);
+SampleTimer sampleTimer(sampleClock);
+const SampleClock* reportedClock = &sampleClock;
+uint64_t sampleKey = 0;           // boundary the sensors are reading for ...
+bool samplePending = false;       // ... until sampleTask() publishes it
+void startSample();
+#else
+const SampleClock* reportedClock = nullptr;
+#endif
 
-// Sensor-specific includes
-#ifdef ENABLE_BME280
-#include <Wire.h>
-#include <Adafruit_Sensor.h>
-#include <Adafruit_BME280.h>
+#ifdef ENABLE_AGGREGATION
+WindowAggregator aggregator(AGG_WINDOW_MS);
+volatile bool rawUploads = false;   // Also send every raw sample; 'r' on the serial console toggles it
 #endif
 
-#ifdef ENABLE_DHT11
-#include <DHT.h>
+#ifdef ENABLE_OFFLINE_LOG
+#include <LittleFS.h>
+#include "sampleLog.h"
+FsBlockStore logStore(LittleFS, "/log");
+SampleLog sampleLog(logStore);
+SampleLog* offlineLog = &sampleLog;
+void initializeOfflineLog();
+#else
+SampleLog* offlineLog = nullptr;
+#endif
+#if defined(ENABLE_OFFLINE_LOG) && defined(ENABLE_AGGREGATION)
+FsBlockStore windowStore(LittleFS, "/windows");
+WindowLog windowLog(windowStore);
+WindowLog* offlineWindows = &windowLog;   // summaries that missed their upload
+#elif defined(ENABLE_AGGREGATION)
+WindowLog* offlineWindows = nullptr;
 #endif
 
-#ifdef ENABLE_SOIL_TEMP
+// Sensor drivers; each is wrapped by a sensor type from sensors.h
 #include <OneWire.h>
 #include <DallasTemperature.h>
+#include "soilTempReader.h"
+#include "adcContinuous.h"
+#include "sensors.h"
+#ifdef BME280_BURST_READ
+#include "bme280Burst.h"
 #endif
 
-// Pin definitions
-#ifdef ENABLE_DHT11
 #define DHTPIN 18
 #define DHTTYPE DHT11
 DHT dht(DHTPIN, DHTTYPE);
-#endif
-
-#ifdef ENABLE_SOIL_MOISTURE
-#define SOIL_MOISTURE_PIN 27
-#endif
+DhtArduino dhtInput(dht);
+DhtSensor<DhtArduino> dhtSensor(dhtInput);
 
-#ifdef ENABLE_SOIL_TEMP
 #define ONE_WIRE_BUS 26
+#define SOIL_TEMP_RESOLUTION 12   // 9-12 bit: 94/188/375/750 ms conversion
 OneWire oneWire(ONE_WIRE_BUS);
-DallasTemperature soilTempSensor(&oneWire);
-#endif
-
-#ifdef ENABLE_BME280
-#define SEALEVELPRESSURE_HPA (1013.25)
-Adafruit_BME280 bme;
+DallasTemperature soilTempBus(&oneWire);
+SoilTempReader soilTempReader(soilTempBus);
+SoilTempSensor<SoilTempReader> soilTempSensor(soilTempReader, SOIL_TEMP_RESOLUTION);
+
+#define SOIL_MOISTURE_PIN 34      // ADC1_CH6; the old GPIO27 is ADC2, unusable while WiFi is on
+ContinuousAdc soilMoistureInput(SOIL_MOISTURE_PIN);
+// This probe's output at known moisture, sorted by mV: air-dry soil, field capacity, saturated.
+// Re-measure for every probe; capacitive probes differ by a few hundred mV.
+const MoistureCalPoint soilCalPoints[] = {
+  { 1250, 10000 },
+  { 1700, 6000 },
+  { 2750, 0 },
+};
+const MoistureCal soilCal = { soilCalPoints, sizeof(soilCalPoints) / sizeof(soilCalPoints[0]) };
+SoilMoistureSensor<ContinuousAdc> soilMoistureSensor(soilMoistureInput, &soilCal);
+
+#ifdef BME280_BURST_READ
+Bme280Burst bme;
+#else
+Adafruit_BME280 bmeChip;
+AdafruitBaro bme(bmeChip);
 #endif
+BaroSensor<decltype(bme)> baroSensor(bme);
+
+// The sensors on this node, each sampled at its own rate (sensors.h). Setup, sampling,
+// the published sample and deep-sleep warm starts all follow this list; adding a sensor
+// is a driver, a sensor type and a line here.
+auto sensors = makeSensorRegistry(
+  // baroSensor,          // BME280 temperature, pressure, humidity, altitude
+  dhtSensor,              // DHT11 temperature, humidity, heat index
+  soilTempSensor,         // DS18B20 soil temperature probes
+  soilMoistureSensor      // Capacitive soil moisture on ADC1
+);
 
 // Function declarations
 void initializeSensors();
-void readSensorData(JsonDocument& doc);
-
-#ifdef ENABLE_BME280
-void readBME280(JsonDocument& doc);
-#endif
 
-#ifdef ENABLE_DHT11
-void readDHT11(JsonDocument& doc);
-#endif
-
-#ifdef ENABLE_SOIL_TEMP
-void readSoilTemperature(JsonDocument& doc);
-#endif
-
-#ifdef ENABLE_SOIL_MOISTURE
-void readSoilMoisture(JsonDocument& doc);
+#ifdef ENABLE_DEEP_SLEEP
+#include <esp_sleep.h>
+#include <esp_timer.h>
+#include <sys/time.h>
+#include "rtcBatch.h"
+#define SLEEP_INTERVAL_MS 60000   // One sample set per wake
+#define SLEEP_UPLOAD_EVERY 15     // Wakes per upload, unless a reading crosses an RTC_DELTA_* threshold
+// Supply current for the energy estimate; radio-on time dominates
+#define SLEEP_SUPPLY_V 3.3f
+#define SLEEP_CPU_MA 40.0f        // awake, radio off
+#define SLEEP_RADIO_MA 120.0f     // on top of the CPU while WiFi is up
+RTC_DATA_ATTR RtcBatch rtcBatch;
+uint64_t lightSleptUs = 0;
+void dutyCycle();
 #endif
 
 void setup() {
   Serial.begin(115200);
+  halLogBegin();                 // log lines queue from here on; a low-priority task writes them out
+
+  #ifdef ENABLE_DEEP_SLEEP
+  dutyCycle();   // never returns
+  #endif
+
   while(!Serial) delay(10);
   
-  Serial.println(F("Multi-Sensor JSON Reader"));
-  Serial.println(F("========================"));
+  LOG_I("Multi-Sensor JSON Reader\n");
+  LOG_I("========================\n");
   
   initializeSensors();
 
+  #ifdef ENABLE_OFFLINE_LOG
+  initializeOfflineLog();
+  #endif
+
   connectToWiFi();
   
   // Initialize Firebase
   initializeFirebase();
 
-  Serial.println();
-  delay(2000);
+  LOG_I("\n");
+
+  #ifdef UPLOAD_PATH_BENCH
+  benchUploadPaths();
+  #endif
+
+  uplinkHealth = UplinkHealth(esp_random());   // RF is up, so this is a true random seed for the jitter
+
+  // The first alarm is armed here, so the blocking setup above cannot make it late
+  #ifdef ENABLE_SAMPLE_CLOCK
+  sampleTimer.begin(xTaskGetCurrentTaskHandle());   // also saves the last key to NVS from a task of its own
+  sampleTimer.startSntp();       // keeps retrying on its own while the link is down
+  #else
+  scheduler.addTask("sample", sampleTask, SAMPLE_INTERVAL);
+  #endif
+  #if LOG_LEVEL >= LOG_LEVEL_DEBUG
+  scheduler.addTask("print", printTask, SAMPLE_INTERVAL, PRINT_PHASE);
+  #endif
+  #ifdef ENABLE_DUAL_CORE
+  xTaskCreatePinnedToCore(uploadLoop, "upload", UPLOAD_STACK, nullptr, UPLOAD_PRIORITY,
+                          &uploadHandle, UPLOAD_CORE);
+  #else
+  scheduler.addTask("upload", uploadTask, UPLOAD_INTERVAL, UPLOAD_PHASE);
+  #endif
 }
 
 void loop() {
-  JsonDocument doc;
-  doc["timestamp"] = millis();
-  
-  readSensorData(doc);
-    // The doc now contains the data, call your function here to process it
-    // yourFunction(doc);
-  
-  
-  serializeJson(doc, Serial);
-  Serial.println();
-  if (millis() - lastUploadTime > UPLOAD_INTERVAL || lastUploadTime == 0) {
-    if (firebaseReady) {
-      uploadSensorData(doc);
-      lastUploadTime = millis();
-    } else {
-      Serial.println("Firebase not ready. Retrying...");
-      initializeFirebase();
+  #ifdef ENABLE_SAMPLE_CLOCK
+  // Woken by the alarm: the sample goes first, so its reads start on the boundary
+  if (sampleTimer.due()) startSample();
+  #endif
+
+  #ifdef ENABLE_AGGREGATION
+  if (Serial.available() && Serial.read() == 'r') {
+    rawUploads = !rawUploads;
+    LOG_I("Raw sample uploads %s\n", rawUploads ? "on" : "off");
+  }
+  #endif
+
+  // Sensors first, so a sample due at the same time publishes their newest reads
+  sensors.poll(millis());
+  #ifdef ENABLE_SAMPLE_CLOCK
+  if (samplePending && !sensors.pending()) sampleTask();   // every read started on the boundary is in
+  #endif
+  uint32_t wait = scheduler.tick();
+
+  // Sleep until the earliest deadline of either instead of a fixed delay
+  uint32_t sensorWait = sensors.poll(millis());
+  if (sensorWait < wait) wait = sensorWait;
+  #ifdef ENABLE_SAMPLE_CLOCK
+  if (samplePending && !sensors.pending()) wait = 0;
+  #endif
+  if (wait > SAMPLE_INTERVAL) wait = SAMPLE_INTERVAL;
+  #ifdef ENABLE_SAMPLE_CLOCK
+  sampleTimer.wait(wait);        // the alarm cuts this short
+  #else
+  delay(wait);
+  #endif
+}
+
+#ifdef ENABLE_SAMPLE_CLOCK
+// The alarm fired: take the boundary's key and have the sensors read on it.
+// sampleTask() publishes once they are done, within the longest conversion.
+void startSample() {
+  if (samplePending) sampleTask();   // a read that never finished must not hold up the next key
+  sampleKey = sampleTimer.take();
+  sensors.align(millis());
+  samplePending = true;
+}
+#endif
+
+// Publish one sample set on the sampling grid from the sensors' newest reads
+void sampleTask() {
+  sampleDoc.clear();
+  #ifdef ENABLE_SAMPLE_CLOCK
+  sensors.publish(sampleKey, sampleDoc, sampleRec);
+  if (sampleClock.provisional(sampleKey)) markUnsynced(sampleDoc, sampleRec);
+  samplePending = false;
+  #else
+  sensors.publish(millis(), sampleDoc, sampleRec);
+  #endif
+  METRIC_HEAP();
+  #if LOG_LEVEL >= LOG_LEVEL_DEBUG
+  samplePrinted = false;
+  #endif
+  sampleUploaded = false;
+
+  #ifdef ENABLE_DUAL_CORE
+  liveSample.publish(sampleRec.timestamp, sampleDoc);   // before the record, so it is there when popped
+  if (sampleQueue.push(sampleRec)) {
+    xTaskNotifyGive(uploadHandle);
+  } else if (sampleQueue.dropped() != queueDropsReported) {
+    queueDropsReported = sampleQueue.dropped();
+    LOG_W("⚠ Upload stalled, sample queue full: %u samples dropped\n", (unsigned)queueDropsReported);
+  }
+  #endif
+}
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+// Console echo of each sample; compiled out below LOG_LEVEL_DEBUG
+void printTask() {
+  if (samplePrinted) return;
+  LOG_D_JSON(sampleDoc);
+  samplePrinted = true;
+}
+#endif
+
+// Uplink for this upload tick, or nullptr to keep samples on the log: no WiFi, no Firebase
+// session, or the health state says back off. Never blocks for longer than one attempt.
+Uplink* activeUplink(uint32_t now) {
+  if (!wifiLink.connected()) return nullptr;
+  if (!firebaseReady) {
+    // Session setup is retried on the same backoff as uploads
+    if (!uplinkHealth.allow(now) && !uplinkHealth.probeDue(now)) return nullptr;
+    LOG_W("Firebase not ready. Retrying...\n");
+    initializeFirebase(false);
+    if (!firebaseReady) {
+      uplinkHealth.failure("Firebase not ready", millis());
+      return nullptr;
     }
+    uplinkHealth.success(millis());
   }
-  
-  delay(2000);
+  if (uplinkHealth.takeReauth()) {
+    LOG_W("Uplink rejected the token, refreshing\n");
+    Firebase.refreshToken(&config);
+  }
+  firebaseReady = Firebase.ready();   // also refreshes the token ahead of expiry
+  return firebaseReady ? uploadGate(guardedUplink, now) : nullptr;
 }
 
+// Upload the latest sample; a slow upload only pushes this task's deadline, sampling stays on its grid
+// While offline the sample goes to the flash log instead of being lost
+void uploadTask() {
+  #ifdef UPLOAD_HEAP_ASSERT
+  HeapSnapshot before = HeapSnapshot::take();
+  #endif
 
-// Connect to WiFi
-void connectToWiFi() {
-  Serial.print("Connecting to WiFi: ");
-  Serial.println(WIFI_SSID);
-  
-  WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
-  
-  int attempts = 0;
-  while (WiFi.status() != WL_CONNECTED && attempts < 20) {
-    delay(500);
-    Serial.print(".");
-    attempts++;
+  Uplink* up = activeUplink(millis());
+  #ifdef ENABLE_AGGREGATION
+  if (!sampleUploaded) uploadWindows(up, offlineWindows, aggregator, &sampleRec, 1, millis());
+  // Replays the log even with raw uploads off, so nothing stored while they were on is stranded
+  uploadCycle(up, offlineLog, sampleDoc, rawUploads && !sampleUploaded, millis());
+  #else
+  uploadCycle(up, offlineLog, sampleDoc, !sampleUploaded, millis());
+  #endif
+  sampleUploaded = true;
+
+  #ifdef UPLOAD_HEAP_ASSERT
+  if (up && ++heapCycles > HEAP_ASSERT_WARMUP) checkHeapDelta(before);
+  #endif
+
+  METRIC_HEAP();
+  #ifdef ENABLE_METRICS
+  if (up && metricsDue(millis())) uploadMetrics(*up, millis(), reportedClock);
+  #endif
+}
+
+#ifdef ENABLE_DUAL_CORE
+// Upload task: drains the sample queue, owns the uplink and the offline log
+void uploadLoop(void*) {
+  TickType_t last = xTaskGetTickCount();
+  for (;;) {
+    // Woken by every queued sample; the timeout keeps backlog replay and reconnects going
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(UPLOAD_INTERVAL));
+
+    #ifdef UPLOAD_HEAP_ASSERT
+    HeapSnapshot before = HeapSnapshot::take();
+    #endif
+
+    Uplink* up = activeUplink(millis());
+    #ifdef ENABLE_AGGREGATION
+    uploadQueueWindows(up, offlineLog, offlineWindows, sampleQueue, aggregator, rawUploads, millis(), &liveSample);
+    #else
+    uploadQueue(up, offlineLog, sampleQueue, millis(), &liveSample);
+    #endif
+
+    #ifdef UPLOAD_HEAP_ASSERT
+    if (up && ++heapCycles > HEAP_ASSERT_WARMUP) checkHeapDelta(before);
+    #endif
+
+    METRIC_HEAP();
+    #ifdef ENABLE_METRICS
+    if (up && metricsDue(millis())) uploadMetrics(*up, millis(), reportedClock);
+    #endif
+
+    // At most one upload per UPLOAD_INTERVAL; samples queued meanwhile go out as one batch
+    vTaskDelayUntil(&last, pdMS_TO_TICKS(UPLOAD_INTERVAL));
   }
-  
-  Serial.println();
-  
-  if (WiFi.status() == WL_CONNECTED) {
-    Serial.println("WiFi Connected!");
-    Serial.print("IP Address: ");
-    Serial.println(WiFi.localIP());
-  } else {
-    Serial.println("WiFi Connection Failed!");
-    Serial.println("Please check your credentials and restart.");
+}
+#endif
+
+#ifdef UPLOAD_HEAP_ASSERT
+// A steady-state cycle must hand back every block it took and leave the largest free block intact
+void checkHeapDelta(const HeapSnapshot& before) {
+  HeapSnapshot after = HeapSnapshot::take();
+  if (after.freeBytes == before.freeBytes && after.blocks == before.blocks &&
+      after.largestFree >= before.largestFree) return;
+  heapViolations++;
+  LOG_E("✗ Heap delta: %ld bytes, %ld blocks, largest free %u -> %u (%u violations)\n",
+        (long)before.freeBytes - (long)after.freeBytes, (long)after.blocks - (long)before.blocks,
+        (unsigned)before.largestFree, (unsigned)after.largestFree, (unsigned)heapViolations);
+}
+#endif
+
+// Connect to WiFi: cached BSSID/channel first, full scan only if that fails.
+// Later drops are handled by wifiLink from the disconnect event.
+bool connectToWiFi() {
+  LOG_I("Connecting to WiFi: %s\n", WIFI_SSID);
+
+  #ifdef WIFI_REUSE_LEASE
+  wifiLink.begin(WIFI_SSID, WIFI_PASSWORD, true);
+  #else
+  wifiLink.begin(WIFI_SSID, WIFI_PASSWORD);
+  #endif
+
+  if (wifiLink.connect(WIFI_CONNECT_TIMEOUT)) {
+    LOG_I("WiFi Connected in %u ms (%s)\n", (unsigned)wifiLink.connectMs(),
+          wifiLink.usedCache() ? "cached BSSID" : "full scan");
+    LOG_I("IP Address: %s\n", WiFi.localIP().toString().c_str());
+    return true;
   }
+  LOG_E("WiFi Connection Failed! (reason %u)\n", (unsigned)wifiLink.lastReason());
+  LOG_E("Please check your credentials and restart.\n");
+  return false;
 }
 
 // Initialize Firebase
-void initializeFirebase() {
-  Serial.println("\nInitializing Firebase...");
+// Token callback: the TokenHelper printout, then keep the stored session in step
+void onTokenStatus(TokenInfo info) {
+  tokenStatusCallback(info);
+  if (info.status == token_status_ready) {
+    authSessionSave();
+  } else if (authSessionRejected(info)) {
+    // Refresh token revoked or user deleted: sign up again on the next init
+    authSessionClear();
+    firebaseStarted = false;
+  }
+}
+
+void initializeFirebase(bool wait) {
+  METRIC_SCOPE(M_FIREBASE_INIT);
+
+  if (firebaseStarted) {
+    // Session already set up; ready() refreshes the token if needed, no new sign-up
+    firebaseReady = Firebase.ready();
+    if (firebaseReady) LOG_I("Firebase is ready!\n");
+    return;
+  }
+
+  LOG_I("\nInitializing Firebase...\n");
   
   // Configure Firebase
   config.api_key = API_KEY;
@@ -171,21 +496,34 @@ void initializeFirebase() {
   auth.user.email = "";
   auth.user.password = "";
 
-  // Signup anonymously in firebase before trying to upload or read data.
-  //Can sign up anonymously a lot of times...
-  if (Firebase.signUp(&config, &auth, "", "")) {
-    Serial.println("Firebase signup successful");
+  // Reuse the anonymous user from NVS; sign up only when there is none
+  bool restored = authSessionLoad(API_KEY);
+  if (restored) {
+    LOG_I("Firebase session restored\n");
+    signupOK = true;
+  } else if (Firebase.signUp(&config, &auth, "", "")) {
+    LOG_I("Firebase signup successful\n");
     signupOK = true;
   } else {
-    Serial.printf("Firebase signup failed: %s\n", config.signer.signupError.message.c_str());
+    LOG_E("Firebase signup failed: %s\n", config.signer.signupError.message.c_str());
   }
 
   // Assign the callback function for token generation
-  config.token_status_callback = tokenStatusCallback;
+  config.token_status_callback = onTokenStatus;
+  // ready() refreshes this long before expiry, so uploads never hit an expired token
+  config.signer.preRefreshSeconds = AUTH_PRE_REFRESH;
   
   // Initialize Firebase
   Firebase.begin(&config, &auth);
-  Firebase.reconnectWiFi(true);
+  if (restored) authSessionApply(config);
+  Firebase.reconnectWiFi(false);   // wifiLink reconnects from the disconnect event
+  firebaseStarted = signupOK;
+
+  #if defined(ENABLE_FANOUT_UPLOAD) && defined(ENABLE_STREAM_UPLOAD)
+  if (!rtdbStream.begin(DATABASE_URL)) {
+    LOG_E("✗ DATABASE_URL could not be parsed for streamed uploads\n");
+  }
+  #endif
   
   // Set the size of HTTP response buffer
   fbdo.setBSSLBufferSize(1024, 1024);
@@ -193,275 +531,253 @@ void initializeFirebase() {
   // Set timeout
   fbdo.setResponseSize(1024);
   
-  Serial.println("Firebase initialized!");
+  LOG_I("Firebase initialized!\n");
   
   // Wait for Firebase to be ready
   int attempts = 0;
-  while (!Firebase.ready() && attempts < 30) {
-    Serial.print(".");
+  while (wait && !Firebase.ready() && attempts < 30) {
+    LOG_I(".");
     delay(500);
     attempts++;
   }
   
-  Serial.println();
+  LOG_I("\n");
   
   if (Firebase.ready()) {
     firebaseReady = true;
-    Serial.println("Firebase is ready!");
+    LOG_I("Firebase is ready!\n");
   } else {
     firebaseReady = false;
-    Serial.println("Firebase connection failed!");
-    Serial.println("Please check your API_KEY and DATABASE_URL");
+    LOG_E("Firebase connection failed!\n");
+    LOG_E("Please check your API_KEY and DATABASE_URL\n");
   }
 }
 
-// Initialize all enabled sensors
+// Initialize the sensors in the registry
 void initializeSensors() {
-  #ifdef ENABLE_BME280
-  Wire.begin();
-  delay(100);
-  if (!bme.begin(0x76, &Wire)) {
-    Serial.println(F("BME280 initialization failed!"));
-  } else {
-    Serial.println(F("BME280 initialized"));
-  }
-  #endif
-  
-  #ifdef ENABLE_DHT11
-  dht.begin();
-  Serial.println(F("DHT11 initialized"));
-  #endif
-  
-  #ifdef ENABLE_SOIL_TEMP
-  soilTempSensor.begin();
-  Serial.println(F("DS18B20 soil temperature initialized"));
-  #endif
-  
-  #ifdef ENABLE_SOIL_MOISTURE
-  pinMode(SOIL_MOISTURE_PIN, INPUT);
-  Serial.println(F("Soil moisture sensor initialized"));
-  #endif
+  sensors.begin(millis());
 }
 
-// Read data from all enabled sensors
-void readSensorData(JsonDocument& doc) {
-  #ifdef ENABLE_BME280
-  readBME280(doc);
-  #endif
-  
-  #ifdef ENABLE_DHT11
-  readDHT11(doc);
-  #endif
-  
-  #ifdef ENABLE_SOIL_TEMP
-  readSoilTemperature(doc);
-  #endif
-  
-  #ifdef ENABLE_SOIL_MOISTURE
-  readSoilMoisture(doc);
-  #endif
+#ifdef ENABLE_DEEP_SLEEP
+// Milliseconds on the RTC clock, which keeps counting through deep sleep; millis() restarts every wake.
+// Epoch time once an upload wake has had an SNTP answer.
+static uint64_t rtcMillis() {
+  timeval tv;
+  gettimeofday(&tv, nullptr);
+  return tv.tv_sec * 1000ULL + tv.tv_usec / 1000;
 }
 
-// Call: uploadSensorData(doc);
-// Requires: fbdo (FirebaseData), Firebase initialized and firebaseReady true, ArduinoJson included
-
-void uploadSensorData(JsonDocument& doc) {
-  Serial.println("\n==========================================");
-  Serial.println("Uploading sensor JSON to Firebase RTDB...");
-
-  // Make sure Firebase is initialized on your side before calling this.
-  // Build base path: <FARM_OWNER>/FarmData<NODE_NAME>
-  String basePath = String(FARM_OWNER);
-  basePath.concat(String("/FarmData"));
-  basePath.concat(String(NODE_NAME)); // NODE_NAME may contain leading slash in your project
-
-  // Create a timestamp key (unique). Replace with epoch if you have NTP/time available.
-  unsigned long ts = millis();
-  doc["uploaded_at_ms"] = ts;
-
-  // Serialize the incoming JSON document
-  String jsonString;
-  serializeJson(doc, jsonString);
-
-  // Target path for the full JSON (under lastReadings/<ts>)
-  String targetPath = basePath;
-  targetPath.concat(String("/lastReadings/"));
-  targetPath.concat(String(ts));
-
-  bool overallSuccess = true;
-
-  // Create FirebaseJson object from serialized string
-  FirebaseJson fbJson;
-  fbJson.setJsonData(jsonString.c_str());
+// Cold boot: full sensor setup, remembered in RTC memory for the following wakes
+static void coldStartSensors() {
+  rtcBatch.reset();
+  initializeSensors();
+  sensors.save(rtcBatch.sensors);
+}
 
-  // Upload full JSON at timestamped node
-  if (Firebase.RTDB.setJSON(&fbdo, targetPath.c_str(), &fbJson)) {
-    Serial.print("✓ JSON uploaded to: ");
-    Serial.println(targetPath);
-  } else {
-    Serial.print("✗ JSON upload failed: ");
-    Serial.println(fbdo.errorReason());
-    overallSuccess = false;
-  }
+// Timer wake: the sensors stayed powered and configured, so skip the bus search,
+// the BME280 reset/calibration read and the DS18B20 EEPROM writes
+static void resumeSensors() {
+  sensors.resume(rtcBatch.sensors, millis());
+}
 
-  // Also update 'latest' pointer with same JSON (so easy reads)
-  String latestPath = basePath;
-  latestPath.concat(String("/lastReadings/latest"));
-  if (Firebase.RTDB.setJSON(&fbdo, latestPath.c_str(), &fbJson)) {
-    Serial.println("✓ 'latest' updated");
-  } else {
-    Serial.print("⚠ failed to update 'latest' pointer: ");
-    Serial.println(fbdo.errorReason());
-    overallSuccess = false;
+// Start the conversions, light-sleep through them, then read everything once
+static void sampleOnce(SampleRecord& rec) {
+  uint32_t wait = sensors.startAll(millis());
+  if (wait) {
+    halLogFlush();
+    int64_t start = esp_timer_get_time();
+    esp_sleep_enable_timer_wakeup((wait + 2) * 1000ULL);
+    esp_light_sleep_start();
+    lightSleptUs += esp_timer_get_time() - start;
   }
+  sensors.readAll(millis());
 
-  // ---- Upload individual scalar fields (if present in JSON) ----
-  // dht11: temperature, humidity, heatIndex
-  if (doc.containsKey("dht11")) {
-    JsonObject dht = doc["dht11"];
-    if (dht.containsKey("temperature")) {
-      float temperature = dht["temperature"].as<float>();
-      String path = basePath; path.concat(String("/Temperature"));
-      if (Firebase.RTDB.setFloat(&fbdo, path.c_str(), temperature)) {
-        Serial.println("✓ Temperature uploaded");
-      } else {
-        Serial.print("✗ Temperature upload failed: ");
-        Serial.println(fbdo.errorReason());
-        overallSuccess = false;
-      }
-    }
-
-    if (dht.containsKey("humidity")) {
-      float humidity = dht["humidity"].as<float>();
-      String path = basePath; path.concat(String("/Humidity"));
-      if (Firebase.RTDB.setFloat(&fbdo, path.c_str(), humidity)) {
-        Serial.println("✓ Humidity uploaded");
-      } else {
-        Serial.print("✗ Humidity upload failed: ");
-        Serial.println(fbdo.errorReason());
-        overallSuccess = false;
-      }
-    }
+  sampleDoc.clear();
+  sensors.publish(rtcMillis(), sampleDoc, rec);
+  LOG_D_JSON(sampleDoc);
+}
 
-    if (dht.containsKey("heatIndex")) {
-      float hi = dht["heatIndex"].as<float>();
-      String path = basePath; path.concat(String("/HeatIndex"));
-      if (Firebase.RTDB.setFloat(&fbdo, path.c_str(), hi)) {
-        Serial.println("✓ HeatIndex uploaded");
-      } else {
-        Serial.print("✗ HeatIndex upload failed: ");
-        Serial.println(fbdo.errorReason());
-        overallSuccess = false;
-      }
-    }
-  }
+// Energy per sample from the duty-cycle counters, with radio-on time as the main proxy
+static void reportEnergy(Uplink* up, uint32_t now) {
+  const RtcBatch& b = rtcBatch;
+  if (b.sampleCount == 0) return;
+  float awakeMs = b.awakeUs / 1000.0f / b.sampleCount;
+  float radioMs = b.radioOnUs / 1000.0f / b.sampleCount;
+  // mA x ms = uC, x V = uJ
+  float mJ = (awakeMs * SLEEP_CPU_MA + radioMs * SLEEP_RADIO_MA) * SLEEP_SUPPLY_V / 1000.0f;
+  LOG_I("Energy: %.1f ms awake, %.1f ms radio on, ~%.2f mJ per sample (%u samples, %u uploads)\n",
+        awakeMs, radioMs, mJ, (unsigned)b.sampleCount, (unsigned)b.uploads);
+  if (!up) return;
+
+  uploadArena.reset();
+  JsonDocument doc(&uploadArena);
+  JsonObject energy = doc["energy"].to<JsonObject>();
+  energy["at_ms"] = now;
+  energy["samples"] = b.sampleCount;
+  energy["uploads"] = b.uploads;
+  energy["awakeMsPerSample"] = round(awakeMs * 10) / 10.0;
+  energy["radioOnMsPerSample"] = round(radioMs * 10) / 10.0;
+  energy["mJPerSample"] = round(mJ * 100) / 100.0;
+  if (up->update(PATH_BASE, doc) != UPLINK_OK) LOG_E("✗ Energy report failed: %s\n", up->errorReason());
+}
 
-  // soilTemperature: celsius, fahrenheit
-  if (doc.containsKey("soilTemperature")) {
-    JsonObject st = doc["soilTemperature"];
-    if (st.containsKey("celsius")) {
-      float sc = st["celsius"].as<float>();
-      String path = basePath; path.concat(String("/SoilTemperature"));
-      if (Firebase.RTDB.setFloat(&fbdo, path.c_str(), sc)) {
-        Serial.println("✓ Soil Temperature uploaded");
-      } else {
-        Serial.print("✗ Soil Temperature upload failed: ");
-        Serial.println(fbdo.errorReason());
-        overallSuccess = false;
-      }
-    }
-    // }
-    // if (st.containsKey("fahrenheit")) {
-    //   float sf = st["fahrenheit"].as<float>();
-    //   String path = basePath; path.concat(String("/SoilTemperatureF"));
-    //   if (Firebase.RTDB.setFloat(&fbdo, path.c_str(), sf)) {
-    //     Serial.println("✓ Soil Temperature (F) uploaded");
-    //   } else {
-    //     Serial.print("✗ Soil Temperature (F) upload failed: ");
-    //     Serial.println(fbdo.errorReason());
-    //     overallSuccess = false;
-    //   }
-    // }
+// Bring the radio up only for this: connect, push the whole batch, report, power down
+static void uploadRtcBatch() {
+  int64_t radioStart = esp_timer_get_time();
+  if (connectToWiFi()) {
+    configTime(0, 0, SNTP_SERVER_1, SNTP_SERVER_2);   // sets the RTC clock while the upload runs
+    initializeFirebase();
   }
+  #ifdef ENABLE_OFFLINE_LOG
+  initializeOfflineLog();
+  #endif
 
-  // soilMoisture: raw, percentage
-  if (doc.containsKey("soilMoisture")) {
-    JsonObject sm = doc["soilMoisture"];
-    if (sm.containsKey("percentage")) {
-      float pct = sm["percentage"].as<float>();
-      String path = basePath; path.concat(String("/SoilMoisture"));
-      if (Firebase.RTDB.setFloat(&fbdo, path.c_str(), pct)) {
-        Serial.println("✓ Soil Moisture (percentage) uploaded");
-      } else {
-        Serial.print("✗ Soil Moisture (percentage) upload failed: ");
-        Serial.println(fbdo.errorReason());
-        overallSuccess = false;
-      }
-    }
+  uint32_t now = (uint32_t)rtcMillis();   // heartbeats and reports only need differences
+  Uplink* up = firebaseReady ? &uplink : nullptr;
+  if (up && offlineLog && offlineLog->pending() > 0) uploadBacklog(*up, *offlineLog);
+  size_t delivered = uploadBatch(up, offlineLog, rtcBatch.samples, rtcBatch.count, now);
+  LOG_I("Uploaded %u of %u batched samples\n", (unsigned)delivered, (unsigned)rtcBatch.count);
+  if (delivered > 0) {
+    rtcBatch.reference = rtcBatch.samples[rtcBatch.count - 1];
+    rtcBatch.hasReference = true;
   }
+  // With the offline log, whatever failed is on flash now; without it, keep the batch for next time
+  if (delivered == rtcBatch.count || offlineLog) rtcBatch.count = 0;
+  rtcBatch.uploads++;
+
+  reportEnergy(up, now);
+  wifiLink.end();
+  WiFi.mode(WIFI_OFF);
+  rtcBatch.radioOnUs += esp_timer_get_time() - radioStart;
+}
 
-  // Summary
-  if (overallSuccess) {
-    Serial.println("\n✓ All data uploaded successfully!");
+// Battery mode, runs once per wake from setup(): sample, maybe upload, deep sleep
+void dutyCycle() {
+  bool warm = esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_TIMER && rtcBatch.valid();
+  if (warm) {
+    resumeSensors();
   } else {
-    Serial.println("\n⚠ Some data failed to upload (see lines above)");
+    LOG_I("Deep-sleep duty cycle, cold boot\n");
+    coldStartSensors();
   }
+  rtcBatch.wakes++;
 
-  Serial.println("==========================================");
-}
+  SampleRecord rec;
+  sampleOnce(rec);
+  bool crossed = rtcBatch.crossed(rec);
+  rtcBatch.append(rec);
 
+  if (crossed || rtcBatch.full() || rtcBatch.count >= SLEEP_UPLOAD_EVERY) {
+    uploadRtcBatch();
+  } else {
+    LOG_I("Batched %u/%u samples\n", (unsigned)rtcBatch.count, SLEEP_UPLOAD_EVERY);
+  }
 
-#ifdef ENABLE_BME280
-// Read BME280 sensor (temperature, pressure, humidity, altitude)
-void readBME280(JsonDocument& doc) {
-  JsonObject bme280 = doc["bme280"].to<JsonObject>();
-  bme280["temperature"] = round(bme.readTemperature() * 100) / 100.0;
-  bme280["pressure"] = round(bme.readPressure() / 100.0F * 100) / 100.0;
-  bme280["humidity"] = round(bme.readHumidity() * 100) / 100.0;
-  bme280["altitude"] = round(bme.readAltitude(SEALEVELPRESSURE_HPA) * 100) / 100.0;
+  // Keep the wake period fixed regardless of how long this wake took
+  int64_t awake = esp_timer_get_time();
+  rtcBatch.awakeUs += awake - lightSleptUs;
+  uint64_t period = SLEEP_INTERVAL_MS * 1000ULL;
+  esp_sleep_enable_timer_wakeup((uint64_t)awake < period ? period - awake : 1000);
+  halLogFlush();
+  esp_deep_sleep_start();
 }
 #endif
 
-#ifdef ENABLE_DHT11
-// Read DHT11 sensor (temperature, humidity, heat index)
-void readDHT11(JsonDocument& doc) {
-  float h = dht.readHumidity();
-  float t = dht.readTemperature();
-  
-  if (!isnan(h) && !isnan(t)) {
-    JsonObject dht11 = doc["dht11"].to<JsonObject>();
-    dht11["temperature"] = round(t * 100) / 100.0;
-    dht11["humidity"] = round(h * 100) / 100.0;
-    dht11["heatIndex"] = round(dht.computeHeatIndex(t, h, false) * 100) / 100.0;
-  } else {
-    doc["dht11"] = "error";
+#ifdef UPLOAD_PATH_BENCH
+#include <esp_timer.h>
+#include "rtdbStream.h"
+#define BENCH_ROUNDS 50
+
+// Discards the body, standing in for the TLS socket
+class NullPrint : public Print {
+public:
+  size_t write(uint8_t) override { return 1; }
+  size_t write(const uint8_t*, size_t size) override { return size; }
+};
+
+// Per-payload CPU time and peak heap of both upload serialization paths, without network I/O.
+// Peak heap is taken at the point where every intermediate copy of the payload is alive.
+void benchUploadPaths() {
+  JsonDocument sample;
+  sample["timestamp"] = 123456;
+  JsonObject dht11 = sample["dht11"].to<JsonObject>();
+  dht11["temperature"] = 24.5;
+  dht11["humidity"] = 61.0;
+  dht11["heatIndex"] = 24.71;
+  JsonObject soilTemp = sample["soilTemperature"].to<JsonObject>();
+  soilTemp["celsius"] = 19.25;
+  soilTemp["fahrenheit"] = 66.65;
+  JsonObject soil = sample["soilMoisture"].to<JsonObject>();
+  soil["raw"] = 1834;
+  soil["percentage"] = 44.79;
+
+  uploadArena.reset();
+  JsonDocument update(&uploadArena);
+  update["lastReadings/123456"] = sample;
+  update["lastReadings/latest"] = sample;
+  update["Temperature"] = 24.5;
+  update["Humidity"] = 61.0;
+  update["HeatIndex"] = 24.71;
+  update["SoilTemperature"] = 19.25;
+  update["SoilMoisture"] = 44.79;
+
+  // serializeJson -> String -> FirebaseJson::setJsonData -> FirebaseJson::toString (request body)
+  uint32_t base = ESP.getFreeHeap();
+  uint32_t lowest = base;
+  int64_t start = esp_timer_get_time();
+  for (int i = 0; i < BENCH_ROUNDS; i++) {
+    String text;
+    serializeJson(update, text);
+    if (ESP.getFreeHeap() < lowest) lowest = ESP.getFreeHeap();
+    FirebaseJson fbJson;
+    fbJson.setJsonData(text.c_str());
+    if (ESP.getFreeHeap() < lowest) lowest = ESP.getFreeHeap();
+    String body;
+    fbJson.toString(body);
+    if (ESP.getFreeHeap() < lowest) lowest = ESP.getFreeHeap();
   }
-}
-#endif
+  int64_t bufferedUs = (esp_timer_get_time() - start) / BENCH_ROUNDS;
+  uint32_t bufferedPeak = base - lowest;
+
+  // serializeJson straight into the chunked writer
+  NullPrint sink;
+  size_t bytes = 0;
+  base = ESP.getFreeHeap();
+  lowest = base;
+  start = esp_timer_get_time();
+  for (int i = 0; i < BENCH_ROUNDS; i++) {
+    ChunkedPrint body(sink);
+    serializeJson(update, body);
+    body.finish();
+    bytes = body.total();
+    if (ESP.getFreeHeap() < lowest) lowest = ESP.getFreeHeap();
+  }
+  int64_t streamedUs = (esp_timer_get_time() - start) / BENCH_ROUNDS;
+  uint32_t streamedPeak = base - lowest;
 
-#ifdef ENABLE_SOIL_TEMP
-// Read DS18B20 soil temperature sensor
-void readSoilTemperature(JsonDocument& doc) {
-  soilTempSensor.requestTemperatures();
-  delay(50); // Give sensor time to read
-  float soilTempC = soilTempSensor.getTempCByIndex(0);
-  float soilTempF = soilTempSensor.getTempFByIndex(0);
-  
-  JsonObject soilTempData = doc["soilTemperature"].to<JsonObject>();
-  soilTempData["celsius"] = round(soilTempC * 100) / 100.0;
-  soilTempData["fahrenheit"] = round(soilTempF * 100) / 100.0;
+  LOG_I("Upload path bench, %u byte payload, %d rounds\n", (unsigned)bytes, BENCH_ROUNDS);
+  LOG_I("  FirebaseJson: %lld us, peak heap %u bytes\n", bufferedUs, (unsigned)bufferedPeak);
+  LOG_I("  Streamed:     %lld us, peak heap %u bytes\n", streamedUs, (unsigned)streamedPeak);
 }
 #endif
 
-#ifdef ENABLE_SOIL_MOISTURE
-// Read analog soil moisture sensor
-void readSoilMoisture(JsonDocument& doc) {
-  int soilMoisture = analogRead(SOIL_MOISTURE_PIN);
-  JsonObject soilData = doc["soilMoisture"].to<JsonObject>();
-  soilData["raw"] = soilMoisture;
-  soilData["percentage"] = map(soilMoisture, 0, 4095, 0, 100);
+#ifdef ENABLE_OFFLINE_LOG
+// Mount the filesystem (formatting it on first use) and recover the log
+void initializeOfflineLog() {
+  if (!LittleFS.begin(true) || !logStore.begin() || !sampleLog.begin()) {
+    LOG_E("Offline log unavailable!\n");
+    return;
+  }
+  LOG_I("Offline log ready, pending samples: %u\n", (unsigned)sampleLog.pending());
+  #ifdef ENABLE_AGGREGATION
+  if (!windowStore.begin() || !windowLog.begin()) {
+    LOG_E("Window log unavailable, summaries wait in memory\n");
+    offlineWindows = nullptr;
+  } else {
+    LOG_I("Window log ready, pending summaries: %u\n", (unsigned)windowLog.pending());
+  }
+  #endif
 }
 #endif
 
 #endif
-
@@ -0,0 +1,154 @@
+#include "metrics.h"
+#ifdef ENABLE_METRICS
+#include <string.h>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
+// Recording runs on both cores; a spinlock section is a few dozen cycles
+static portMUX_TYPE metricsMux = portMUX_INITIALIZER_UNLOCKED;
+#define METRICS_LOCK() portENTER_CRITICAL(&metricsMux)
+#define METRICS_UNLOCK() portEXIT_CRITICAL(&metricsMux)
+#else
+#include <atomic>
+#include <chrono>
+static std::atomic_flag metricsLock = ATOMIC_FLAG_INIT;
+#define METRICS_LOCK() while (metricsLock.test_and_set(std::memory_order_acquire)) {}
+#define METRICS_UNLOCK() metricsLock.clear(std::memory_order_release)
+#endif
+
+static const char* const metricNames[M_COUNT] = {
+  "readSensorData", "readBME280", "readDHT11", "readSoilTemperature", "readSoilMoisture",
+  "serializeJson", "rtdbFanout", "rtdbBatch", "rtdbNode", "initializeFirebase", "sampleJitter",
+};
+
+static MetricHist hist[M_COUNT];
+static uint32_t heapFreeMin = UINT32_MAX;
+static uint32_t heapLargestMin = UINT32_MAX;
+static uint32_t windowStartMs = 0;
+static uint32_t attemptMs = 0;
+// Summarized by metricsPublish, waiting for the upload's outcome
+static MetricHist taken[M_COUNT];
+static uint32_t takenFreeMin = UINT32_MAX;
+static uint32_t takenLargestMin = UINT32_MAX;
+static bool takenPending = false;
+
+uint32_t metricsNowUs() {
+#ifdef ARDUINO
+  return (uint32_t)esp_timer_get_time();
+#else
+  return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+static uint8_t bucketFor(uint32_t us) {
+  uint8_t b = 0;
+  while (us > 1 && b < METRICS_BUCKETS - 1) {
+    us >>= 1;
+    b++;
+  }
+  return b;
+}
+
+void metricsRecord(MetricId id, uint32_t us) {
+  uint8_t b = bucketFor(us);
+  METRICS_LOCK();
+  MetricHist& h = hist[id];
+  if (h.count == 0 || us < h.minUs) h.minUs = us;
+  if (us > h.maxUs) h.maxUs = us;
+  h.count++;
+  h.sumUs += us;
+  h.buckets[b]++;
+  METRICS_UNLOCK();
+}
+
+void metricsSampleHeap() {
+#ifdef ARDUINO
+  uint32_t freeBytes = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+  uint32_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+  METRICS_LOCK();
+  if (freeBytes < heapFreeMin) heapFreeMin = freeBytes;
+  if (largest < heapLargestMin) heapLargestMin = largest;
+  METRICS_UNLOCK();
+#endif
+}
+
+bool metricsDue(uint32_t nowMs) {
+  return nowMs - attemptMs >= METRICS_PUBLISH_MINUTES * 60000UL;
+}
+
+// Upper bound of the bucket holding the q-th quantile, capped by the observed max
+static uint32_t quantileUs(const MetricHist& h, float q) {
+  uint32_t rank = (uint32_t)(q * h.count + 0.5f);
+  if (rank == 0) rank = 1;
+  uint32_t seen = 0;
+  for (uint8_t b = 0; b < METRICS_BUCKETS; b++) {
+    seen += h.buckets[b];
+    if (seen >= rank) {
+      uint32_t upper = b == METRICS_BUCKETS - 1 ? h.maxUs : (2UL << b) - 1;
+      return upper < h.maxUs ? upper : h.maxUs;
+    }
+  }
+  return h.maxUs;
+}
+
+static void mergeHist(MetricHist& into, const MetricHist& from) {
+  if (from.count == 0) return;
+  if (into.count == 0 || from.minUs < into.minUs) into.minUs = from.minUs;
+  if (from.maxUs > into.maxUs) into.maxUs = from.maxUs;
+  into.count += from.count;
+  into.sumUs += from.sumUs;
+  for (uint8_t b = 0; b < METRICS_BUCKETS; b++) into.buckets[b] += from.buckets[b];
+}
+
+void metricsPublished(bool delivered) {
+  if (!takenPending) return;
+  takenPending = false;
+  if (delivered) {
+    windowStartMs = attemptMs;   // the next window starts where the published one ended
+    return;
+  }
+  METRICS_LOCK();
+  for (uint8_t i = 0; i < M_COUNT; i++) mergeHist(hist[i], taken[i]);
+  if (takenFreeMin < heapFreeMin) heapFreeMin = takenFreeMin;
+  if (takenLargestMin < heapLargestMin) heapLargestMin = takenLargestMin;
+  METRICS_UNLOCK();
+}
+
+void metricsPublish(JsonObject out, uint32_t nowMs) {
+  metricsPublished(false);   // an earlier publish that was never settled
+  METRICS_LOCK();
+  memcpy(taken, hist, sizeof(hist));
+  memset(hist, 0, sizeof(hist));
+  takenFreeMin = heapFreeMin;
+  takenLargestMin = heapLargestMin;
+  heapFreeMin = heapLargestMin = UINT32_MAX;
+  METRICS_UNLOCK();
+  takenPending = true;
+  attemptMs = nowMs;
+
+  out["window_s"] = (nowMs - windowStartMs) / 1000;
+  out["at_ms"] = nowMs;
+  if (takenFreeMin != UINT32_MAX) {
+    out["heapFreeMin"] = takenFreeMin;
+    out["heapLargestMin"] = takenLargestMin;
+  }
+
+  // Times in microseconds; percentiles are log2 bucket bounds, so within 2x
+  JsonObject stages = out["stages"].to<JsonObject>();
+  for (uint8_t i = 0; i < M_COUNT; i++) {
+    const MetricHist& h = taken[i];
+    if (h.count == 0) continue;
+    JsonObject s = stages[metricNames[i]].to<JsonObject>();
+    s["n"] = h.count;
+    s["mean"] = (uint32_t)(h.sumUs / h.count);
+    s["min"] = h.minUs;
+    s["max"] = h.maxUs;
+    s["p50"] = quantileUs(h, 0.50f);
+    s["p90"] = quantileUs(h, 0.90f);
+    s["p99"] = quantileUs(h, 0.99f);
+  }
+}
+#endif
@@ -0,0 +1,72 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+// Hot-path instrumentation: per-stage latency histograms and heap watermarks, published
+// periodically as a metrics node next to lastReadings. Built with -DENABLE_METRICS;
+// without it the macros below expand to nothing and this module compiles away.
+
+#include <stdint.h>
+
+#define METRICS_PUBLISH_MINUTES 10
+#define METRICS_BUCKETS 24        // log2 microsecond buckets: [2^i, 2^(i+1)) us, last one open
+
+enum MetricId {
+  M_READ_SENSORS,                 // readSensorData, SensorRegistry::publish
+  M_READ_BME280,
+  M_READ_DHT11,
+  M_READ_SOIL_TEMP,
+  M_READ_SOIL_MOISTURE,
+  M_SERIALIZE,                    // serializeJson of upload documents (into the socket when streaming)
+  M_RTDB_FANOUT,                  // fan-out update of the live sample
+  M_RTDB_BATCH,                   // lastReadings batch: backlog replay or queued samples
+  M_RTDB_NODE,                    // one per-node request (PerNodeUplink)
+  M_FIREBASE_INIT,                // initializeFirebase
+  M_SAMPLE_JITTER,                // sample start after its timer alarm (sampleClock.h), not a duration
+  M_COUNT
+};
+
+#ifdef ENABLE_METRICS
+#include <ArduinoJson.h>
+
+struct MetricHist {
+  uint32_t count;
+  uint32_t minUs;
+  uint32_t maxUs;
+  uint64_t sumUs;
+  uint32_t buckets[METRICS_BUCKETS];
+};
+
+uint32_t metricsNowUs();
+void metricsRecord(MetricId id, uint32_t us);
+// Free heap and largest free block, folded into the window's low watermarks
+void metricsSampleHeap();
+// True once per METRICS_PUBLISH_MINUTES since the last publish attempt
+bool metricsDue(uint32_t nowMs);
+// Summary of the window so far (count, mean, max, p50/p90/p99 bucket bounds per stage,
+// heap watermarks). What it summarizes is set aside until metricsPublished.
+void metricsPublish(JsonObject out, uint32_t nowMs);
+// The upload's outcome: delivered starts a new window; otherwise the set-aside counts go
+// back into the current one, and the next publish covers both intervals
+void metricsPublished(bool delivered);
+
+// Times the enclosing scope
+class MetricScope {
+public:
+  explicit MetricScope(MetricId id) : id_(id), start_(metricsNowUs()) {}
+  ~MetricScope() { metricsRecord(id_, metricsNowUs() - start_); }
+
+private:
+  MetricId id_;
+  uint32_t start_;
+};
+
+#define METRIC_CONCAT2(a, b) a##b
+#define METRIC_CONCAT(a, b) METRIC_CONCAT2(a, b)
+#define METRIC_SCOPE(id) MetricScope METRIC_CONCAT(metricScope_, __LINE__)(id)
+#define METRIC_HEAP() metricsSampleHeap()
+#else
+#define METRIC_SCOPE(id) do {} while (0)
+#define METRIC_HEAP() do {} while (0)
+#endif
+
+#endif
@@ -0,0 +1,136 @@
+#ifndef ARDUINO
+#include "mockRtdb.h"
+#include "socketIo.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <strings.h>
+#include <unistd.h>
+#include <poll.h>
+#include <chrono>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+bool MockRtdb::start(uint16_t port) {
+  listenFd_ = socket(AF_INET, SOCK_STREAM, 0);
+  if (listenFd_ < 0) return false;
+  int one = 1;
+  setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+  sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons(port);
+  socklen_t len = sizeof(addr);
+  if (bind(listenFd_, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(listenFd_, 4) != 0 ||
+      getsockname(listenFd_, (sockaddr*)&addr, &len) != 0) {
+    close(listenFd_);
+    listenFd_ = -1;
+    return false;
+  }
+  port_ = ntohs(addr.sin_port);
+  running_ = true;
+  thread_ = std::thread(&MockRtdb::serve, this);
+  return true;
+}
+
+void MockRtdb::stop() {
+  if (!running_) return;
+  running_ = false;
+  int fd = clientFd_.exchange(-1);
+  if (fd >= 0) shutdown(fd, SHUT_RDWR);
+  if (thread_.joinable()) thread_.join();
+  close(listenFd_);
+  listenFd_ = -1;
+}
+
+uint32_t MockRtdb::random() {
+  rng_ ^= rng_ << 13;
+  rng_ ^= rng_ >> 17;
+  rng_ ^= rng_ << 5;
+  return rng_;
+}
+
+// One client at a time, like the single keep-alive connection the node holds
+void MockRtdb::serve() {
+  while (running_) {
+    pollfd p = { listenFd_, POLLIN, 0 };
+    if (poll(&p, 1, 50) <= 0) continue;
+    int fd = accept(listenFd_, nullptr, nullptr);
+    if (fd < 0) continue;
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    connections++;
+    clientFd_ = fd;
+    SocketReader in(fd);
+    while (running_ && handle(fd, in)) {}
+    clientFd_ = -1;
+    close(fd);
+  }
+}
+
+bool MockRtdb::handle(int fd, SocketReader& in) {
+  uint64_t before = in.total();
+  char line[512];
+  if (!in.readLine(line, sizeof(line))) return false;
+
+  char method[8] = "";
+  if (sscanf(line, "%7s", method) != 1) return false;
+
+  long contentLength = -1;
+  bool chunked = false;
+  bool close = false;
+  for (;;) {
+    if (!in.readLine(line, sizeof(line))) return false;
+    if (line[0] == '\0') break;
+    if (strncasecmp(line, "Content-Length:", 15) == 0) contentLength = atol(line + 15);
+    if (strncasecmp(line, "Transfer-Encoding: chunked", 26) == 0) chunked = true;
+    if (strncasecmp(line, "Connection: close", 17) == 0) close = true;
+  }
+
+  uint64_t body = 0;
+  if (chunked) {
+    for (;;) {
+      if (!in.readLine(line, sizeof(line))) return false;
+      size_t n = strtoul(line, nullptr, 16);
+      if (!in.skip(n) || !in.readLine(line, sizeof(line))) return false;   // data + CRLF
+      body += n;
+      if (n == 0) break;   // the blank line after the last chunk was just consumed
+    }
+  } else if (contentLength > 0) {
+    if (!in.skip((size_t)contentLength)) return false;
+    body = (uint64_t)contentLength;
+  }
+  requests++;
+  bytesIn += in.total() - before;
+  bodyBytes += body;
+
+  uint32_t delay = config_.latencyMs + (config_.jitterMs ? random() % (config_.jitterMs + 1) : 0);
+  if (delay) std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+
+  uint32_t roll = random() % 100;
+  if (roll < config_.dropPercent) {
+    drops++;
+    return false;
+  }
+
+  char resp[256];
+  int n;
+  if (roll < (uint32_t)config_.dropPercent + config_.errorPercent) {
+    errors++;
+    const char* reason = config_.errorCode == 401 ? "Permission denied" : "Injected error";
+    char err[64];
+    int e = snprintf(err, sizeof(err), "{\n  \"error\" : \"%s\"\n}\n", reason);
+    n = snprintf(resp, sizeof(resp), "HTTP/1.1 %u Error\r\nContent-Type: application/json\r\n"
+                 "Content-Length: %d\r\nConnection: keep-alive\r\n\r\n%s",
+                 (unsigned)config_.errorCode, e, err);
+  } else {
+    // print=silent: no body, nothing for the client to parse
+    n = snprintf(resp, sizeof(resp), "HTTP/1.1 204 No Content\r\nConnection: keep-alive\r\n\r\n");
+  }
+  if (!sendAll(fd, resp, (size_t)n)) return false;
+  bytesOut += (uint64_t)n;
+  return !close;
+}
+#endif
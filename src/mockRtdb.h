@@ -0,0 +1,58 @@
+#ifndef MOCK_RTDB_H
+#define MOCK_RTDB_H
+
+#ifndef ARDUINO
+#include <stdint.h>
+#include <atomic>
+#include <thread>
+
+class SocketReader;
+
+// Local stand-in for the Realtime Database REST API, for host benchmarks.
+// Accepts the requests RtdbStream/HttpUplink send (PUT/PATCH <path>.json, chunked or
+// Content-Length body, keep-alive) on 127.0.0.1 and answers like RTDB does with
+// print=silent. Latency and failures are injected per request from a seeded PRNG,
+// so a run is repeatable.
+struct MockRtdbConfig {
+  uint32_t latencyMs = 0;     // added before every response
+  uint32_t jitterMs = 0;      // uniform 0..jitterMs on top of latencyMs
+  uint8_t errorPercent = 0;   // requests answered with errorCode
+  uint16_t errorCode = 503;
+  uint8_t dropPercent = 0;    // requests whose connection is closed without an answer
+  uint32_t seed = 1;
+};
+
+class MockRtdb {
+public:
+  explicit MockRtdb(const MockRtdbConfig& config) : config_(config), rng_(config.seed ? config.seed : 1) {}
+  ~MockRtdb() { stop(); }
+
+  bool start(uint16_t port = 0);    // 0 picks a free port
+  void stop();
+  uint16_t port() const { return port_; }
+
+  // Server-side counters, safe to read while running
+  std::atomic<uint32_t> requests{0};
+  std::atomic<uint32_t> errors{0};       // injected error responses
+  std::atomic<uint32_t> drops{0};        // injected connection drops
+  std::atomic<uint32_t> connections{0};
+  std::atomic<uint64_t> bytesIn{0};      // request line, headers, chunk framing and body
+  std::atomic<uint64_t> bodyBytes{0};    // decoded JSON bodies
+  std::atomic<uint64_t> bytesOut{0};
+
+private:
+  void serve();
+  bool handle(int fd, SocketReader& in);    // one request; false closes the connection
+  uint32_t random();
+
+  MockRtdbConfig config_;
+  uint32_t rng_;
+  int listenFd_ = -1;
+  std::atomic<int> clientFd_{-1};
+  uint16_t port_ = 0;
+  std::atomic<bool> running_{false};
+  std::thread thread_;
+};
+#endif
+
+#endif
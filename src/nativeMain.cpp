@@ -0,0 +1,290 @@
+#include "select.h"
+#if defined(MAIN) && !defined(ARDUINO) && !defined(RTDB_BENCH) && !defined(PIO_UNIT_TESTING)
+// Host entry point for env:native: runs the acquisition/upload pipeline against the
+// simulated HAL on a fake clock and reports host CPU time per stage.
+// "program codec [trace]" compares both batch formats' size and cost with JSON.
+// "program trace [n]" prints n simulated samples as the node's console echo, for codec.
+// "program export" turns packed batches (base64, one per line on stdin) back into JSON.
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <string.h>
+#include <string>
+#include <unistd.h>
+#include <ArduinoJson.h>
+#include "nodeConfig.h"
+#include "scheduler.h"
+#include "halSim.h"
+#include "acquisition.h"
+#include "upload.h"
+#include "metrics.h"
+#include "logger.h"
+#include "sampleCodec.h"
+
+#define SOIL_TEMP_MARGIN 20
+
+static SimDht dht;
+static SimSoilTemp soilTemp(2);
+static SimBaro baro;
+static SimAnalog moisture;
+static SimUplink uplink;
+// Capacitive probe: ~2.8 V in dry soil, ~1.2 V saturated
+static const MoistureCalPoint moisturePoints[] = { { 1200, 10000 }, { 1700, 6500 }, { 2800, 0 } };
+static const MoistureCal moistureCal = { moisturePoints, 3 };
+static SensorHal hal = { &dht, &soilTemp, &baro, &moisture, &moistureCal, FakeClock::read };
+
+static Scheduler<4> scheduler(FakeClock::read);
+static JsonDocument sampleDoc;
+static SampleRecord sampleRec;
+static bool sampleUploaded = true;
+static uint32_t samples = 0;
+static double sampleUs = 0;
+static double uploadUs = 0;
+
+typedef std::chrono::steady_clock HostClock;
+
+static double elapsedUs(HostClock::time_point start) {
+  return std::chrono::duration<double, std::micro>(HostClock::now() - start).count();
+}
+
+static void soilConvTask() {
+  soilTemp.start(FakeClock::read());
+}
+
+static void sampleTask() {
+  HostClock::time_point start = HostClock::now();
+  sampleDoc.clear();
+  readSensorData(hal, FakeClock::read(), sampleDoc, sampleRec);
+  sampleUs += elapsedUs(start);
+  samples++;
+  sampleUploaded = false;
+}
+
+static void uploadTask() {
+  HostClock::time_point start = HostClock::now();
+  uploadCycle(&uplink, nullptr, sampleDoc, !sampleUploaded, FakeClock::read());
+  uploadUs += elapsedUs(start);
+  sampleUploaded = true;
+}
+
+// Batches as uploadRecords sends them, each way; returns the request body length
+static size_t jsonBatch(const SampleRecord* recs, size_t n, std::string& out) {
+  JsonDocument update;
+  char key[32];
+  for (size_t i = 0; i < n; i++) {
+    snprintf(key, sizeof(key), "lastReadings/%llu", (unsigned long long)recs[i].timestamp);
+    sampleToJson(recs[i], update[key].to<JsonObject>());
+  }
+  return serializeJson(update, out);
+}
+
+typedef size_t (*BatchEncoder)(const SampleRecord*, size_t, char*, size_t);
+
+static char codecB64[SAMPLE_BATCH_CHARS(SAMPLE_LOG_BATCH)];
+
+static size_t packedBatch(BatchEncoder encode, const SampleRecord* recs, size_t n, std::string& out) {
+  JsonDocument update;
+  char key[32];
+  if (!encode(recs, n, codecB64, sizeof(codecB64))) return 0;
+  snprintf(key, sizeof(key), "packed/%llu", (unsigned long long)recs[0].timestamp);
+  update[key] = (const char*)codecB64;
+  return serializeJson(update, out);
+}
+
+// A recorded trace: the JSON lines the node echoes to its console, one sample per line
+static uint32_t loadTrace(const char* path, SampleRecord* recs, uint32_t max) {
+  FILE* f = fopen(path, "r");
+  if (!f) return 0;
+  char line[LOG_LINE_MAX];
+  uint32_t n = 0;
+  JsonDocument doc;
+  while (n < max && fgets(line, sizeof(line), f)) {
+    if (line[0] != '{' || deserializeJson(doc, line)) continue;
+    sampleFromJson(doc, recs[n++]);
+  }
+  fclose(f);
+  return n;
+}
+
+// The samples readSensorData produces on the simulated HAL, with sensors dropping out now
+// and then and a late sample
+static uint32_t simulatedTrace(SampleRecord* recs, uint32_t n) {
+  JsonDocument doc;
+  for (uint32_t i = 0; i < n; i++) {
+    soilTemp.start(FakeClock::read());
+    FakeClock::advance(SAMPLE_INTERVAL + (i % 50 == 17 ? 130 : 0));
+    doc.clear();
+    readSensorData(hal, FakeClock::read() + 1760000000000ULL, doc, recs[i]);   // epoch-ms timestamps
+    if (i % 7 == 3) recs[i].flags &= ~SAMPLE_HAS_BME280;
+    if (i % 11 == 5) recs[i].flags &= ~(SAMPLE_HAS_DHT11 | SAMPLE_HAS_SOIL_TEMP);
+  }
+  return n;
+}
+
+// Both batch formats over a trace against the JSON update: body size, encode and decode
+// cost. "program codec [trace]" uses a recorded console log instead of the simulated HAL;
+// a batch of it that does not decode back is counted, test/test_sample_codec has the checks.
+#define CODEC_SAMPLES (SAMPLE_LOG_BATCH * 20)
+#define CODEC_ROUNDS 200
+
+struct CodecFormat {
+  const char* name;
+  BatchEncoder encode;
+  size_t body;
+  uint32_t errors;
+  double encodeUs;
+  double decodeUs;
+};
+
+static bool codecBench(const char* tracePath) {
+  static SampleRecord recs[CODEC_SAMPLES];
+  uint32_t n = tracePath ? loadTrace(tracePath, recs, CODEC_SAMPLES) : simulatedTrace(recs, CODEC_SAMPLES);
+  uint32_t batches = n / SAMPLE_LOG_BATCH;
+  if (batches == 0) {
+    printf("need at least %u samples, got %u\n", SAMPLE_LOG_BATCH, (unsigned)n);
+    return false;
+  }
+
+  size_t packedBytes = 0;
+  for (uint32_t i = 0; i < n; i++) {
+    uint8_t buf[SAMPLE_PACKED_MAX];
+    packedBytes += encodeSample(recs[i], buf, sizeof(buf));
+  }
+
+  CodecFormat formats[] = {
+    { "packed", encodeBatch, 0, 0, 0, 0 },
+    { "delta", encodeDeltaBatch, 0, 0, 0, 0 },
+  };
+  size_t jsonBody = 0;
+  for (uint32_t b = 0; b < batches; b++) {
+    const SampleRecord* batch = recs + b * SAMPLE_LOG_BATCH;
+    std::string body;
+    jsonBody += jsonBatch(batch, SAMPLE_LOG_BATCH, body);
+    for (CodecFormat& f : formats) {
+      f.body += packedBatch(f.encode, batch, SAMPLE_LOG_BATCH, body);
+      SampleRecord back[SAMPLE_LOG_BATCH];
+      if (decodeBatch(codecB64, back, SAMPLE_LOG_BATCH) != SAMPLE_LOG_BATCH ||
+          back[SAMPLE_LOG_BATCH - 1].timestamp != batch[SAMPLE_LOG_BATCH - 1].timestamp) {
+        f.errors++;
+      }
+    }
+  }
+
+  // Encode: document + serializeJson against the packed encoders; decode back to records
+  std::string sink;
+  HostClock::time_point start = HostClock::now();
+  for (uint32_t r = 0; r < CODEC_ROUNDS; r++) jsonBatch(recs + (r % batches) * SAMPLE_LOG_BATCH, SAMPLE_LOG_BATCH, sink);
+  double jsonUs = elapsedUs(start) / CODEC_ROUNDS;
+  for (CodecFormat& f : formats) {
+    SampleRecord back[SAMPLE_LOG_BATCH];
+    start = HostClock::now();
+    for (uint32_t r = 0; r < CODEC_ROUNDS; r++) {
+      f.encode(recs + (r % batches) * SAMPLE_LOG_BATCH, SAMPLE_LOG_BATCH, codecB64, sizeof(codecB64));
+    }
+    f.encodeUs = elapsedUs(start) / CODEC_ROUNDS;
+    start = HostClock::now();
+    for (uint32_t r = 0; r < CODEC_ROUNDS; r++) decodeBatch(codecB64, back, SAMPLE_LOG_BATCH);
+    f.decodeUs = elapsedUs(start) / CODEC_ROUNDS;
+  }
+
+  printf("  %u samples (%s), %u-sample batches; packed sample %.1f bytes\n", (unsigned)n,
+         tracePath ? tracePath : "simulated", SAMPLE_LOG_BATCH, (double)packedBytes / n);
+  printf("  %-7s %6u bytes/batch %6.1f bytes/sample   1.0x  encode %7.2f us\n", "json",
+         (unsigned)(jsonBody / batches), (double)jsonBody / (batches * SAMPLE_LOG_BATCH), jsonUs);
+  bool ok = true;
+  for (CodecFormat& f : formats) {
+    printf("  %-7s %6u bytes/batch %6.1f bytes/sample %5.1fx  encode %7.2f us  decode %6.2f us", f.name,
+           (unsigned)(f.body / batches), (double)f.body / (batches * SAMPLE_LOG_BATCH), (double)jsonBody / f.body,
+           f.encodeUs, f.decodeUs);
+    printf(f.errors ? "  %u batches not decoded\n" : "\n", (unsigned)f.errors);
+    ok = ok && f.errors == 0;
+  }
+  return ok;
+}
+
+// The console echo of n simulated samples, the format loadTrace reads
+static void printTrace(uint32_t n) {
+  JsonDocument doc;
+  SampleRecord rec;
+  for (uint32_t i = 0; i < n; i++) {
+    soilTemp.start(FakeClock::read());
+    FakeClock::advance(SAMPLE_INTERVAL);
+    doc.clear();
+    readSensorData(hal, FakeClock::read(), doc, rec);
+    halLogJson(doc);
+  }
+}
+
+// Exporter: packed/<ts> values, one per line, as the lastReadings entries they stand for.
+// Quotes and whitespace around each value are ignored, so RTDB export values paste as they are.
+static bool exportBatches() {
+  JsonDocument out;
+  JsonObject readings = out.to<JsonObject>();
+  std::string line;
+  bool ok = true;
+  int c;
+  while ((c = getchar()) != EOF || !line.empty()) {
+    if (c != EOF && c != '\n') {
+      if (c != '"' && c != ' ' && c != '\r' && c != '\t' && c != ',') line += (char)c;
+      continue;
+    }
+    if (!line.empty() && !packedBatchToJson(line.c_str(), readings)) {
+      fprintf(stderr, "not a packed batch: %.40s\n", line.c_str());
+      ok = false;
+    }
+    line.clear();
+    if (c == EOF) break;
+  }
+  std::string json;
+  serializeJson(out, json);
+  printf("%s\n", json.c_str());
+  return ok;
+}
+
+int main(int argc, char** argv) {
+  if (argc > 1 && strcmp(argv[1], "codec") == 0) return codecBench(argc > 2 ? argv[2] : nullptr) ? 0 : 1;
+  if (argc > 1 && strcmp(argv[1], "trace") == 0) {
+    printTrace(argc > 2 ? (uint32_t)atol(argv[2]) : CODEC_SAMPLES);
+    return 0;
+  }
+  if (argc > 1 && strcmp(argv[1], "export") == 0) return exportBatches() ? 0 : 1;
+
+  uint32_t cycles = argc > 1 ? (uint32_t)atol(argv[1]) : 1000;
+  simLogEnabled = argc > 2 && argv[2][0] == 'v';
+
+  scheduler.addTask("sample", sampleTask, SAMPLE_INTERVAL);
+  scheduler.addTask("upload", uploadTask, UPLOAD_INTERVAL, 20);
+  scheduler.addTask("soilConv", soilConvTask, SAMPLE_INTERVAL,
+                    SAMPLE_INTERVAL - soilTemp.conversionMs() - SOIL_TEMP_MARGIN);
+
+  while (samples < cycles) {
+    uint32_t wait = scheduler.tick();
+    FakeClock::advance(wait ? wait : 1);
+  }
+
+  char last[512];
+  serializeJson(sampleDoc, last, sizeof(last));
+  printf("%s\n", last);
+  printf("cycles %u, requests %u, bytes %llu (%.0f per request)\n", (unsigned)samples,
+         (unsigned)uplink.requests, (unsigned long long)uplink.bytes,
+         uplink.requests ? (double)uplink.bytes / uplink.requests : 0.0);
+  uint32_t scalarSent = 0, scalarSuppressed = 0;
+  for (uint8_t i = 0; i < SCALAR_COUNT; i++) {
+    scalarSent += scalarFilter.sent[i];
+    scalarSuppressed += scalarFilter.suppressed[i];
+  }
+  printf("scalar writes %u, suppressed by deadband %u\n", (unsigned)scalarSent, (unsigned)scalarSuppressed);
+  printf("readSensorData %.2f us/cycle, upload %.2f us/cycle, arena peak %u bytes\n",
+         sampleUs / samples, uploadUs / samples, (unsigned)uploadArena.peak());
+#ifdef ENABLE_METRICS
+  // What the node would publish as <node>/metrics for this run
+  JsonDocument metrics;
+  metricsPublish(metrics.to<JsonObject>(), FakeClock::read());
+  metricsPublished(true);
+  std::string out;
+  serializeJson(metrics, out);
+  printf("metrics %s\n", out.c_str());
+#endif
+  return 0;
+}
+#endif
@@ -0,0 +1,29 @@
+#ifndef NODE_CONFIG_H
+#define NODE_CONFIG_H
+
+// RTDB creds
+#define FARM_OWNER "Niranj"        // Farm owner name
+#define NODE_NAME "/Node1"          // Node name
+#define FARM_SIZE 12
+
+#define SAMPLE_INTERVAL 2000            // ms; samples are keyed on multiples of this in epoch time
+#define SNTP_SERVER_1 "pool.ntp.org"
+#define SNTP_SERVER_2 "time.google.com"
+#define UPLOAD_INTERVAL 2000
+#define SEALEVELPRESSURE_HPA (1013.25)
+
+// Scalar nodes (/Temperature, ...) are rewritten only when the value moved by more than
+// its deadband since the last write, or when its heartbeat (max silence, ms) runs out
+#define DEADBAND_TEMPERATURE 0.3f       // degC
+#define DEADBAND_HUMIDITY 1.0f          // %RH
+#define DEADBAND_HEAT_INDEX 0.3f        // degC
+#define DEADBAND_SOIL_TEMPERATURE 0.1f  // degC
+#define DEADBAND_SOIL_MOISTURE 0.5f     // %
+#define HEARTBEAT_AIR 300000            // Temperature, Humidity, HeatIndex
+#define HEARTBEAT_SOIL 900000           // SoilTemperature, SoilMoisture
+
+// RTDB paths are fixed at compile time; only the timestamp key is rewritten per cycle
+#define BASE_PATH FARM_OWNER "/FarmData" NODE_NAME
+static const char PATH_BASE[] = BASE_PATH;
+
+#endif
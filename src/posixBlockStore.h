@@ -0,0 +1,95 @@
+#ifndef POSIX_BLOCK_STORE_H
+#define POSIX_BLOCK_STORE_H
+
+#ifndef ARDUINO
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <unistd.h>
+#include "blockStore.h"
+
+// BlockStore over plain files in a host directory, for exercising the sample log on Linux
+class PosixBlockStore : public BlockStore {
+public:
+  explicit PosixBlockStore(const std::string& dir) : dir_(dir) {}
+
+  int32_t size(uint8_t seg) override {
+    FILE* f = fopen(segPath(seg).c_str(), "rb");
+    if (!f) return -1;
+    fseek(f, 0, SEEK_END);
+    int32_t n = (int32_t)ftell(f);
+    fclose(f);
+    return n;
+  }
+
+  bool read(uint8_t seg, uint32_t off, void* buf, size_t len) override {
+    FILE* f = fopen(segPath(seg).c_str(), "rb");
+    if (!f) return false;
+    bool ok = fseek(f, off, SEEK_SET) == 0 && fread(buf, 1, len, f) == len;
+    fclose(f);
+    return ok;
+  }
+
+  bool append(uint8_t seg, const void* buf, size_t len) override {
+    FILE* f = fopen(segPath(seg).c_str(), "ab");
+    if (!f) return false;
+    bool ok = fwrite(buf, 1, len, f) == len && fflush(f) == 0 && fsync(fileno(f)) == 0;
+    fclose(f);
+    return ok;
+  }
+
+  bool erase(uint8_t seg) override {
+    std::string path = segPath(seg);
+    return access(path.c_str(), F_OK) != 0 || remove(path.c_str()) == 0;
+  }
+
+  bool readMeta(void* buf, size_t len) override {
+    FILE* f = fopen((dir_ + "/meta").c_str(), "rb");
+    if (!f) return false;
+    bool ok = fread(buf, 1, len, f) == len;
+    fclose(f);
+    return ok;
+  }
+
+  bool writeMeta(const void* buf, size_t len) override {
+    std::string tmp = dir_ + "/meta.tmp";
+    FILE* f = fopen(tmp.c_str(), "wb");
+    if (!f) return false;
+    bool ok = fwrite(buf, 1, len, f) == len && fflush(f) == 0 && fsync(fileno(f)) == 0;
+    fclose(f);
+    return ok && rename(tmp.c_str(), (dir_ + "/meta").c_str()) == 0;
+  }
+
+protected:
+  std::string dir_;
+
+private:
+  std::string segPath(uint8_t seg) const { return dir_ + "/" + std::to_string(seg) + ".bin"; }
+};
+
+// PosixBlockStore in a fresh temporary directory, removed with everything in it on destruction
+class TempBlockStore : public PosixBlockStore {
+public:
+  explicit TempBlockStore(const char* prefix) : PosixBlockStore(makeDir(prefix)) {}
+  ~TempBlockStore() {
+    if (dir_.empty()) return;
+    if (DIR* d = opendir(dir_.c_str())) {
+      while (struct dirent* e = readdir(d)) {
+        if (e->d_name[0] != '.') unlink((dir_ + "/" + e->d_name).c_str());
+      }
+      closedir(d);
+    }
+    rmdir(dir_.c_str());
+  }
+  bool ok() const { return !dir_.empty(); }
+
+private:
+  static std::string makeDir(const char* prefix) {
+    std::string dir = std::string(prefix) + ".XXXXXX";
+    return mkdtemp(&dir[0]) ? dir : std::string();
+  }
+};
+#endif
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef RTC_BATCH_H
+#define RTC_BATCH_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sampleRecord.h"
+#include "bme280Compensation.h"
+
+// State kept in RTC slow memory across deep-sleep wakes: the batch of samples not yet
+// uploaded, what the sensors were configured with on the cold boot, and duty-cycle
+// counters for the energy report. ~2.1 KB of the 8 KB RTC slow memory.
+
+#define RTC_BATCH_CAPACITY 60
+#define RTC_BATCH_MAGIC 0x52544343   // "RTCC"; bump when the layout changes
+#define RTC_MAX_PROBES 4
+
+// Upload before N wakes if any of these moved by at least this much since the last upload
+#define RTC_DELTA_SOIL_MOISTURE 500  // 0.01 %
+#define RTC_DELTA_AIR_TEMP 200       // 0.01 degC
+#define RTC_DELTA_SOIL_TEMP 100      // 0.01 degC
+
+struct RtcSensorState {
+  uint8_t probeCount;
+  uint8_t probeAddr[RTC_MAX_PROBES][8];
+  uint8_t probeResolution[RTC_MAX_PROBES];
+  bool bmeValid;
+  Bme280Calib bmeCalib;
+};
+
+struct RtcBatch {
+  uint32_t magic;
+  uint16_t count;
+  SampleRecord samples[RTC_BATCH_CAPACITY];
+  bool hasReference;
+  SampleRecord reference;        // last sample that reached the cloud, for the thresholds
+  RtcSensorState sensors;
+
+  // Duty-cycle accounting since the cold boot
+  uint32_t wakes;
+  uint32_t sampleCount;
+  uint32_t uploads;
+  uint64_t awakeUs;
+  uint64_t radioOnUs;
+
+  bool valid() const { return magic == RTC_BATCH_MAGIC; }
+
+  void reset() {
+    memset(this, 0, sizeof(*this));
+    magic = RTC_BATCH_MAGIC;
+  }
+
+  // When full the oldest sample makes room; the caller uploads before that normally happens
+  void append(const SampleRecord& rec) {
+    if (count == RTC_BATCH_CAPACITY) {
+      memmove(samples, samples + 1, sizeof(samples) - sizeof(samples[0]));
+      count--;
+    }
+    samples[count++] = rec;
+    sampleCount++;
+  }
+
+  bool full() const { return count == RTC_BATCH_CAPACITY; }
+
+  // A reading that moved past a threshold goes out now instead of waiting for the batch
+  bool crossed(const SampleRecord& rec) const {
+    if (!hasReference) return true;
+    const SampleRecord& ref = reference;
+    if ((rec.flags & ref.flags & SAMPLE_HAS_SOIL_MOISTURE) &&
+        abs(rec.soilMoisture - ref.soilMoisture) >= RTC_DELTA_SOIL_MOISTURE) return true;
+    if ((rec.flags & ref.flags & SAMPLE_HAS_DHT11) &&
+        abs(rec.airTemp - ref.airTemp) >= RTC_DELTA_AIR_TEMP) return true;
+    if ((rec.flags & ref.flags & SAMPLE_HAS_SOIL_TEMP) &&
+        abs(rec.soilTemp - ref.soilTemp) >= RTC_DELTA_SOIL_TEMP) return true;
+    return false;
+  }
+};
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef RTDB_PATHS_H
+#define RTDB_PATHS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// Fixed-size path buffer: a constant prefix copied once, followed by a decimal key
+// rewritten in place on every use, e.g. "<base>/lastReadings/" + "<ts>".
+// with() returns the same buffer every time, so a document it keys must copy the key:
+// ArduinoJson does for const char* from 7.3 on (platformio.ini pins ^7.3.0); 7.2 kept
+// the pointer, and every key of a batch read as the last one written.
+template <size_t PrefixSize>
+class KeyedPath {
+public:
+  explicit KeyedPath(const char (&prefix)[PrefixSize]) { memcpy(buf_, prefix, PrefixSize); }
+
+  const char* with(uint64_t key) {
+    char digits[20];
+    size_t n = 0;
+    do {
+      digits[n++] = (char)('0' + key % 10);
+      key /= 10;
+    } while (key);
+    char* p = buf_ + PrefixSize - 1;
+    while (n) *p++ = digits[--n];
+    *p = '\0';
+    return buf_;
+  }
+
+  const char* c_str() const { return buf_; }
+
+private:
+  char buf_[PrefixSize + 20];
+};
+
+#endif
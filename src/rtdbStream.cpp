@@ -0,0 +1,140 @@
+#include "rtdbStream.h"
+#include <string.h>
+#include "metrics.h"
+
+size_t ChunkedPrint::write(uint8_t c) {
+  return write(&c, 1);
+}
+
+size_t ChunkedPrint::write(const uint8_t* buf, size_t size) {
+  if (failed_) return 0;
+  size_t done = 0;
+  while (done < size) {
+    size_t n = size - done;
+    if (n > sizeof(buf_) - len_) n = sizeof(buf_) - len_;
+    memcpy(buf_ + len_, buf + done, n);
+    len_ += n;
+    done += n;
+    if (len_ == sizeof(buf_) && !flushChunk()) return 0;
+  }
+  total_ += size;
+  return size;
+}
+
+bool ChunkedPrint::flushChunk() {
+  if (len_ == 0) return true;
+  char head[8];
+  int h = snprintf(head, sizeof(head), "%x\r\n", (unsigned)len_);
+  failed_ = out_.write((const uint8_t*)head, h) != (size_t)h ||
+            out_.write(buf_, len_) != len_ ||
+            out_.write((const uint8_t*)"\r\n", 2) != 2;
+  len_ = 0;
+  return !failed_;
+}
+
+bool ChunkedPrint::finish() {
+  if (!flushChunk()) return false;
+  return out_.write((const uint8_t*)"0\r\n\r\n", 5) == 5;
+}
+
+bool RtdbStream::begin(const char* databaseUrl) {
+  const char* p = strstr(databaseUrl, "://");
+  p = p ? p + 3 : databaseUrl;
+  size_t n = strcspn(p, "/");
+  if (n == 0 || n >= sizeof(host_)) return false;
+  memcpy(host_, p, n);
+  host_[n] = '\0';
+  // Same trust model as the Firebase client without a configured root CA
+  client_.setInsecure();
+  client_.setTimeout(RTDB_STREAM_TIMEOUT / 1000);   // seconds on arduino-esp32 2.x
+  return true;
+}
+
+bool RtdbStream::update(const char* path, JsonDocument& doc, const char* idToken) {
+  return send("PATCH", path, doc, idToken);
+}
+
+bool RtdbStream::set(const char* path, JsonDocument& doc, const char* idToken) {
+  return send("PUT", path, doc, idToken);
+}
+
+bool RtdbStream::connect() {
+  if (client_.connected()) return true;
+  client_.stop();
+  return client_.connect(host_, 443);
+}
+
+bool RtdbStream::fail(const char* reason) {
+  error_ = reason;
+  client_.stop();
+  return false;
+}
+
+bool RtdbStream::send(const char* method, const char* path, JsonDocument& doc, const char* idToken) {
+  httpCode_ = 0;
+  lastBytes_ = 0;
+  error_ = "";
+  if (!connect()) return fail("connection refused");
+
+  // print=silent: RTDB answers 204 with no body, so nothing has to be parsed back
+  client_.print(method);
+  client_.print(path[0] == '/' ? " " : " /");
+  client_.print(path);
+  client_.print(".json?print=silent&auth=");
+  client_.print(idToken);
+  client_.print(" HTTP/1.1\r\nHost: ");
+  client_.print(host_);
+  client_.print("\r\nContent-Type: application/json\r\n"
+                "Transfer-Encoding: chunked\r\n"
+                "Connection: keep-alive\r\n\r\n");
+
+  ChunkedPrint body(client_);
+  {
+    METRIC_SCOPE(M_SERIALIZE);   // serializer and TLS writes interleave, timed together
+    serializeJson(doc, body);
+  }
+  if (!body.finish()) return fail("send failed");
+  lastBytes_ = body.total();
+
+  return readResponse();
+}
+
+// Status line, then headers; any body (error details) is drained so the connection can be reused
+bool RtdbStream::readResponse() {
+  char line[128];
+  size_t n = client_.readBytesUntil('\n', line, sizeof(line) - 1);
+  if (n == 0) return fail("response timeout");
+  line[n] = '\0';
+  if (strncmp(line, "HTTP/1.", 7) != 0) return fail("bad response");
+  httpCode_ = atoi(line + 9);
+
+  long contentLength = 0;
+  bool close = false;
+  for (;;) {
+    n = client_.readBytesUntil('\n', line, sizeof(line) - 1);
+    line[n] = '\0';
+    if (n <= 1) break;  // blank line ends the headers
+    if (strncasecmp(line, "Content-Length:", 15) == 0) contentLength = atol(line + 15);
+    if (strncasecmp(line, "Connection: close", 17) == 0) close = true;
+    if (strncasecmp(line, "Transfer-Encoding: chunked", 26) == 0) close = true;  // not worth decoding
+  }
+  while (contentLength > 0) {
+    size_t k = client_.readBytes(line, contentLength < (long)sizeof(line) ? contentLength : sizeof(line));
+    if (k == 0) {
+      close = true;
+      break;
+    }
+    contentLength -= k;
+  }
+  if (close) client_.stop();
+
+  if (httpCode_ >= 200 && httpCode_ < 300) return true;
+  switch (httpCode_) {
+    case 401: error_ = "permission denied"; break;
+    case 400: error_ = "bad request"; break;
+    case 404: error_ = "not found"; break;
+    case 412: error_ = "precondition failed"; break;
+    default: error_ = httpCode_ >= 500 ? "server error" : "request failed"; break;
+  }
+  return false;
+}
@@ -0,0 +1,58 @@
+#ifndef RTDB_STREAM_H
+#define RTDB_STREAM_H
+
+#include <Arduino.h>
+#include <WiFiClientSecure.h>
+#include <ArduinoJson.h>
+
+#define RTDB_STREAM_CHUNK 1024    // One TLS record per chunk
+#define RTDB_STREAM_TIMEOUT 5000
+
+// Chunked Print adapter: buffers serializer output and emits HTTP/1.1 chunks,
+// so a document goes out in one pass without knowing its length up front.
+class ChunkedPrint : public Print {
+public:
+  explicit ChunkedPrint(Print& out) : out_(out), len_(0), total_(0), failed_(false) {}
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* buf, size_t size) override;
+  bool finish();               // flush the last chunk and the terminator
+  size_t total() const { return total_; }
+
+private:
+  bool flushChunk();
+
+  Print& out_;
+  uint8_t buf_[RTDB_STREAM_CHUNK];
+  size_t len_;
+  size_t total_;
+  bool failed_;
+};
+
+// Minimal RTDB REST client that writes ArduinoJson documents straight into the TLS socket.
+// Replaces serializeJson -> String -> FirebaseJson::setJsonData -> re-serialize with a single
+// serializer pass and no intermediate copies. The connection is kept alive between calls.
+class RtdbStream {
+public:
+  bool begin(const char* databaseUrl);
+  // PATCH <path>.json: multi-location update, keys of doc are paths relative to path
+  bool update(const char* path, JsonDocument& doc, const char* idToken);
+  bool set(const char* path, JsonDocument& doc, const char* idToken);
+
+  int httpCode() const { return httpCode_; }
+  const char* errorReason() const { return error_; }
+  size_t lastBytes() const { return lastBytes_; }
+
+private:
+  bool send(const char* method, const char* path, JsonDocument& doc, const char* idToken);
+  bool connect();
+  bool readResponse();
+  bool fail(const char* reason);
+
+  WiFiClientSecure client_;
+  char host_[96];
+  int httpCode_ = 0;
+  size_t lastBytes_ = 0;
+  const char* error_ = "";
+};
+
+#endif
@@ -0,0 +1,129 @@
+#include "sampleClock.h"
+
+#define PPB 1000000000LL
+
+static int32_t clamp32(int64_t v, int64_t limit) {
+  return (int32_t)(v > limit ? limit : v < -limit ? -limit : v);
+}
+
+SampleClock::SampleClock(uint32_t periodMs) : periodMs_(periodMs) {
+  begin(0, 0);
+}
+
+void SampleClock::begin(uint64_t us, uint64_t guessMs, uint64_t lastKey) {
+  baseUs_ = us;
+  baseEpochUs_ = (int64_t)(guessMs > lastKey ? guessMs : lastKey) * 1000;
+  freqPpb_ = 0;
+  driftKnown_ = false;
+  slewPpb_ = 0;
+  slewUs_ = 0;
+  lastKey_ = lastKey;
+  lastGridKey_ = 0;
+  lastProvisional_ = lastKey;
+  synced_ = false;
+  stepped_ = false;
+  lastOffsetUs_ = 0;
+  syncs_ = steps_ = samples_ = missed_ = provisionals_ = jitterMaxUs_ = 0;
+}
+
+uint64_t SampleClock::epochUs(uint64_t us) const {
+  int64_t d = (int64_t)(us - baseUs_);
+  int64_t s = d < slewUs_ ? d : slewUs_;
+  return (uint64_t)(baseEpochUs_ + d + d * freqPpb_ / PPB + s * slewPpb_ / PPB);
+}
+
+// The mapping is within a few hundred ppm of the identity, so each pass gains three digits
+uint64_t SampleClock::counterAt(uint64_t epochUs) const {
+  uint64_t us = baseUs_ + (uint64_t)((int64_t)epochUs - baseEpochUs_);
+  for (uint8_t i = 0; i < 3; i++) us += (uint64_t)((int64_t)epochUs - (int64_t)this->epochUs(us));
+  return us;
+}
+
+// Offset the running slew has yet to apply at counter value us
+int64_t SampleClock::pendingSlewUs(uint64_t us) const {
+  int64_t d = (int64_t)(us - baseUs_);
+  if (d >= slewUs_) return 0;
+  return (slewUs_ - (d > 0 ? d : 0)) * slewPpb_ / PPB;
+}
+
+void SampleClock::step(uint64_t us, int64_t epochUs) {
+  baseUs_ = us;
+  baseEpochUs_ = epochUs;
+  slewPpb_ = 0;
+  slewUs_ = 0;
+  steps_++;
+  stepped_ = true;
+}
+
+void SampleClock::sync(uint64_t us, uint64_t epochMs) {
+  syncs_++;
+  int64_t target = (int64_t)epochMs * 1000;
+  int64_t predicted = (int64_t)epochUs(us);
+  int64_t err = target - predicted;
+  lastOffsetUs_ = clamp32(err, INT32_MAX);
+  if (!synced_ || err > SAMPLE_CLOCK_STEP_MS * 1000LL || err < -SAMPLE_CLOCK_STEP_MS * 1000LL) {
+    step(us, target);
+    synced_ = true;
+    return;
+  }
+
+  // What the slew still had to do was planned; the rest built up from the rate being off.
+  // Later estimates only go half way, so one fix's network delay does not swing the rate.
+  int64_t since = (int64_t)(us - baseUs_);
+  if (since >= SAMPLE_CLOCK_MIN_DRIFT_S * 1000000LL) {
+    int64_t correction = (err - pendingSlewUs(us)) * PPB / since;
+    if (driftKnown_) correction /= 2;
+    freqPpb_ = clamp32(freqPpb_ + correction, SAMPLE_CLOCK_MAX_PPM * 1000LL);
+    driftKnown_ = true;
+  }
+
+  // Continue from where the mapping is now and work the whole offset in from here
+  baseUs_ = us;
+  baseEpochUs_ = predicted;
+  slewUs_ = SAMPLE_CLOCK_SLEW_S * 1000000LL;
+  slewPpb_ = (int32_t)(err * PPB / slewUs_);
+}
+
+uint64_t SampleClock::next(uint64_t now, uint64_t& alarmUs) const {
+  uint64_t boundary = (epochMs(now) / periodMs_ + 1) * periodMs_;
+  uint64_t key = boundary;
+  if (!synced_) {
+    // Only a guessed epoch can fall below the last run's keys; it skips ahead of them
+    if (boundary < lastProvisional_) boundary = (lastProvisional_ / periodMs_ + 1) * periodMs_;
+    key = boundary + 1;
+  } else if (boundary <= lastGridKey_) {
+    key = boundary + 1 + steps_ % (periodMs_ - 1);
+  }
+  alarmUs = counterAt(boundary * 1000);
+  return key;
+}
+
+uint32_t SampleClock::taken(uint64_t key, uint64_t alarmUs, uint64_t startUs) {
+  uint64_t late = startUs > alarmUs ? startUs - alarmUs : 0;
+  uint32_t jitter = late > UINT32_MAX ? UINT32_MAX : (uint32_t)late;
+  if (samples_ && !stepped_ && key > lastKey_ + periodMs_) missed_ += (uint32_t)((key - lastKey_) / periodMs_ - 1);
+  stepped_ = false;
+  lastKey_ = key;
+  if (provisional(key)) {
+    if (key > lastProvisional_) lastProvisional_ = key;
+    provisionals_++;
+  } else {
+    lastGridKey_ = key;
+  }
+  samples_++;
+  if (jitter > jitterMaxUs_) jitterMaxUs_ = jitter;
+  return jitter;
+}
+
+void SampleClock::report(JsonObject out) const {
+  out["synced"] = synced_;
+  out["periodMs"] = periodMs_;
+  out["driftPpb"] = freqPpb_;
+  out["lastOffsetUs"] = lastOffsetUs_;
+  out["syncs"] = syncs_;
+  out["steps"] = steps_;
+  out["samples"] = samples_;
+  out["missed"] = missed_;
+  out["provisional"] = provisionals_;
+  out["jitterMaxUs"] = jitterMaxUs_;
+}
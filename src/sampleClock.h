@@ -0,0 +1,101 @@
+#ifndef SAMPLE_CLOCK_H
+#define SAMPLE_CLOCK_H
+
+#include <stdint.h>
+#include <ArduinoJson.h>
+
+// Epoch time for sample keys, from a free-running microsecond counter (the sampling
+// timer's) disciplined by SNTP. Samples are taken on multiples of the period in epoch ms,
+// and once the clock has a fix that boundary is the sample's key: keys are evenly spaced
+// and, since epoch time only moves on, unique across reboots.
+//
+// Between fixes the counter is mapped to epoch time with a drift estimate (the crystal
+// is off by tens of ppm, ~2-4 s a day). A fix within SAMPLE_CLOCK_STEP_MS of the mapping
+// is slewed in over SAMPLE_CLOCK_SLEW_S, so sample spacing moves by under a millisecond;
+// the part of it the slew did not account for is drift and corrects the estimate. A larger
+// offset (the first fix after a cold boot) is stepped, and sampling carries on from the
+// stepped grid.
+//
+// Keys that cannot be trusted are provisional, flagged SAMPLE_UNSYNCED in the record, and
+// a few ms past their boundary so they never equal a key on the grid: every key before the
+// first fix (the epoch is a guess from the RTC or the last key) is 1 ms past and stays
+// above every key the last run handed out; a boundary that comes round again after a step
+// back is one ms further past for each step, so it repeats neither the grid nor an earlier
+// step's keys.
+//
+// Plain C++ driven by explicit counter values, so a host can run it on a simulated
+// oscillator (test/test_sample_clock); the timer, SNTP and persistence are in sampleTimer.cpp.
+
+#define SAMPLE_CLOCK_STEP_MS 500          // Larger offsets are stepped, smaller ones slewed
+#define SAMPLE_CLOCK_SLEW_S 1000          // Slew time: at most 500 ppm for a 500 ms offset
+#define SAMPLE_CLOCK_MAX_PPM 200          // Drift estimates are clamped to this
+#define SAMPLE_CLOCK_MIN_DRIFT_S 300      // Fixes closer together only correct the offset
+#define SAMPLE_CLOCK_EPOCH_VALID 1600000000000ULL   // ms; anything earlier was never set
+
+class SampleClock {
+public:
+  explicit SampleClock(uint32_t periodMs);
+
+  // Start the mapping at counter value us with the best epoch guess (RTC time, or the
+  // persisted last key). Provisional keys stay above lastKey.
+  void begin(uint64_t us, uint64_t guessMs, uint64_t lastKey = 0);
+  // An SNTP fix: the epoch was epochMs at counter value us
+  void sync(uint64_t us, uint64_t epochMs);
+
+  uint64_t epochUs(uint64_t us) const;      // counter -> epoch, us
+  uint64_t counterAt(uint64_t epochUs) const;
+  uint64_t epochMs(uint64_t us) const { return epochUs(us) / 1000; }
+
+  // Next sample: the first boundary after the counter value now. Returns its key, which is
+  // provisional without a fix or if the boundary was already used; alarmUs is the counter
+  // value to start acquisition at.
+  uint64_t next(uint64_t now, uint64_t& alarmUs) const;
+  bool provisional(uint64_t key) const { return key % periodMs_ != 0; }
+  // What the next run's begin() takes as lastKey: above every key handed out so far
+  uint64_t keyFloor() const { return lastKey_ > lastProvisional_ ? lastKey_ : lastProvisional_; }
+  // The sample for key started at counter value startUs, its alarm having been alarmUs.
+  // Returns the start latency in us, the jitter.
+  uint32_t taken(uint64_t key, uint64_t alarmUs, uint64_t startUs);
+
+  bool synced() const { return synced_; }
+  uint32_t periodMs() const { return periodMs_; }
+  uint64_t lastKey() const { return lastKey_; }
+  int32_t driftPpb() const { return freqPpb_; }           // counter rate error being corrected
+  int32_t lastOffsetUs() const { return lastOffsetUs_; }  // mapping error at the last fix, clamped
+  uint32_t syncs() const { return syncs_; }
+  uint32_t steps() const { return steps_; }
+  uint32_t samples() const { return samples_; }
+  uint32_t missed() const { return missed_; }             // boundaries skipped by a late start, not by a step
+  uint32_t provisionals() const { return provisionals_; }
+  uint32_t jitterMaxUs() const { return jitterMaxUs_; }
+
+  // Jitter report since boot, for the metrics node. Every field is 32 bits and written
+  // only by the sampling task, so another task can read it without a lock.
+  void report(JsonObject out) const;
+
+private:
+  void step(uint64_t us, int64_t epochUs);
+  int64_t pendingSlewUs(uint64_t us) const;
+
+  uint32_t periodMs_;
+  uint64_t baseUs_;         // counter value the mapping is anchored at
+  int64_t baseEpochUs_;     // its epoch time
+  int32_t freqPpb_;         // drift correction, parts per billion
+  bool driftKnown_;         // freqPpb_ has been measured at least once
+  int32_t slewPpb_;         // offset being slewed in ...
+  int64_t slewUs_;          // ... over this much counter time after baseUs_
+  uint64_t lastKey_;
+  uint64_t lastGridKey_;    // of this run; a boundary up to it is taken again as provisional
+  uint64_t lastProvisional_;   // keys before the first fix stay above it; starts at the last run's
+  bool synced_;
+  bool stepped_;            // since the last sample
+  int32_t lastOffsetUs_;
+  uint32_t syncs_;
+  uint32_t steps_;
+  uint32_t samples_;
+  uint32_t missed_;
+  uint32_t provisionals_;
+  uint32_t jitterMaxUs_;
+};
+
+#endif
@@ -0,0 +1,442 @@
+#include "sampleCodec.h"
+#include <stdio.h>
+#include <string.h>
+
+// ---- MessagePack, the integer subset this schema uses ----
+
+static uint8_t* putBe(uint8_t* p, uint64_t v, uint8_t bytes) {
+  while (bytes--) *p++ = (uint8_t)(v >> (8 * bytes));
+  return p;
+}
+
+static uint8_t* putUint(uint8_t* p, uint64_t v) {
+  if (v < 0x80) {
+    *p++ = (uint8_t)v;                        // positive fixint
+  } else if (v <= 0xFF) {
+    *p++ = 0xCC;
+    p = putBe(p, v, 1);
+  } else if (v <= 0xFFFF) {
+    *p++ = 0xCD;
+    p = putBe(p, v, 2);
+  } else if (v <= 0xFFFFFFFF) {
+    *p++ = 0xCE;
+    p = putBe(p, v, 4);
+  } else {
+    *p++ = 0xCF;                              // epoch-ms timestamps
+    p = putBe(p, v, 8);
+  }
+  return p;
+}
+
+static uint8_t* putInt(uint8_t* p, int32_t v) {
+  if (v >= 0) return putUint(p, (uint32_t)v);
+  if (v >= -32) {
+    *p++ = (uint8_t)v;                        // negative fixint
+  } else if (v >= -128) {
+    *p++ = 0xD0;
+    p = putBe(p, (uint32_t)v, 1);
+  } else if (v >= -32768) {
+    *p++ = 0xD1;
+    p = putBe(p, (uint32_t)v, 2);
+  } else {
+    *p++ = 0xD2;
+    p = putBe(p, (uint32_t)v, 4);
+  }
+  return p;
+}
+
+size_t encodeSample(const SampleRecord& rec, uint8_t* out, size_t cap) {
+  uint8_t buf[SAMPLE_PACKED_MAX];
+  uint8_t fields = 1;
+  if (rec.flags & SAMPLE_HAS_DHT11) fields += 3;
+  if (rec.flags & SAMPLE_HAS_SOIL_TEMP) fields += 1;
+  if (rec.flags & SAMPLE_HAS_SOIL_MOISTURE) fields += 2;
+  if (rec.flags & SAMPLE_HAS_BME280) fields += 3;
+  if (rec.flags & SAMPLE_UNSYNCED) fields += 1;
+
+  uint8_t* p = buf;
+  *p++ = 0x80 | fields;                       // fixmap, at most 11 pairs
+  *p++ = SF_TIMESTAMP;
+  p = putUint(p, rec.timestamp);
+  if (rec.flags & SAMPLE_HAS_DHT11) {
+    *p++ = SF_AIR_TEMP;
+    p = putInt(p, rec.airTemp);
+    *p++ = SF_AIR_HUMIDITY;
+    p = putInt(p, rec.airHumidity);
+    *p++ = SF_HEAT_INDEX;
+    p = putInt(p, rec.heatIndex);
+  }
+  if (rec.flags & SAMPLE_HAS_SOIL_TEMP) {
+    *p++ = SF_SOIL_TEMP;
+    p = putInt(p, rec.soilTemp);
+  }
+  if (rec.flags & SAMPLE_HAS_SOIL_MOISTURE) {
+    *p++ = SF_SOIL_MOISTURE;
+    p = putInt(p, rec.soilMoisture);
+    *p++ = SF_SOIL_RAW;
+    p = putUint(p, rec.soilRaw);
+  }
+  if (rec.flags & SAMPLE_HAS_BME280) {
+    *p++ = SF_BME_TEMP;
+    p = putInt(p, rec.bmeTemp);
+    *p++ = SF_BME_HUMIDITY;
+    p = putInt(p, rec.bmeHumidity);
+    *p++ = SF_PRESSURE;
+    p = putUint(p, rec.pressure);
+  }
+  if (rec.flags & SAMPLE_UNSYNCED) {
+    *p++ = SF_UNSYNCED;
+    *p++ = 1;
+  }
+
+  size_t n = p - buf;
+  if (n > cap) return 0;
+  memcpy(out, buf, n);
+  return n;
+}
+
+// Byte sources for the decoder: plain bytes, or base64 text decoded on the fly
+struct ByteReader {
+  const uint8_t* p;
+  const uint8_t* end;
+  bool next(uint8_t& b) {
+    if (p == end) return false;
+    b = *p++;
+    return true;
+  }
+};
+
+static int8_t base64Value(char c) {
+  if (c >= 'A' && c <= 'Z') return c - 'A';
+  if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+  if (c >= '0' && c <= '9') return c - '0' + 52;
+  if (c == '+') return 62;
+  if (c == '/') return 63;
+  return -1;
+}
+
+struct Base64Reader {
+  const char* s;
+  uint32_t acc;
+  uint8_t bits;
+  bool next(uint8_t& b) {
+    while (bits < 8) {
+      int8_t v = base64Value(*s);
+      if (v < 0) return false;                // '=', NUL or garbage ends the stream
+      s++;
+      acc = acc << 6 | (uint8_t)v;
+      bits += 6;
+    }
+    bits -= 8;
+    b = (uint8_t)(acc >> bits);
+    return true;
+  }
+};
+
+template <class R>
+static bool readBe(R& r, uint8_t bytes, uint64_t& v) {
+  v = 0;
+  uint8_t b;
+  while (bytes--) {
+    if (!r.next(b)) return false;
+    v = v << 8 | b;
+  }
+  return true;
+}
+
+// Any MessagePack integer up to uint32, int32 or a 63-bit uint64 (the timestamp), as int64
+template <class R>
+static bool readInt(R& r, int64_t& v) {
+  uint8_t t;
+  uint64_t u;
+  if (!r.next(t)) return false;
+  if (t < 0x80) { v = t; return true; }
+  if (t >= 0xE0) { v = (int8_t)t; return true; }
+  switch (t) {
+    case 0xCC: if (!readBe(r, 1, u)) return false; v = u; return true;
+    case 0xCD: if (!readBe(r, 2, u)) return false; v = u; return true;
+    case 0xCE: if (!readBe(r, 4, u)) return false; v = u; return true;
+    case 0xCF: if (!readBe(r, 8, u) || u > INT64_MAX) return false; v = (int64_t)u; return true;
+    case 0xD0: if (!readBe(r, 1, u)) return false; v = (int8_t)u; return true;
+    case 0xD1: if (!readBe(r, 2, u)) return false; v = (int16_t)u; return true;
+    case 0xD2: if (!readBe(r, 4, u)) return false; v = (int32_t)u; return true;
+    default: return false;
+  }
+}
+
+template <class R>
+static bool readSample(R& r, SampleRecord& rec) {
+  memset(&rec, 0, sizeof(rec));
+  uint8_t t;
+  if (!r.next(t) || (t & 0xF0) != 0x80) return false;
+  uint8_t pairs = t & 0x0F;
+  bool haveTimestamp = false;
+  while (pairs--) {
+    int64_t key, v;
+    if (!readInt(r, key) || !readInt(r, v)) return false;
+    switch (key) {
+      case SF_TIMESTAMP: rec.timestamp = (uint64_t)v; haveTimestamp = true; break;
+      case SF_AIR_TEMP: rec.airTemp = (int16_t)v; rec.flags |= SAMPLE_HAS_DHT11; break;
+      case SF_AIR_HUMIDITY: rec.airHumidity = (int16_t)v; rec.flags |= SAMPLE_HAS_DHT11; break;
+      case SF_HEAT_INDEX: rec.heatIndex = (int16_t)v; rec.flags |= SAMPLE_HAS_DHT11; break;
+      case SF_SOIL_TEMP: rec.soilTemp = (int16_t)v; rec.flags |= SAMPLE_HAS_SOIL_TEMP; break;
+      case SF_SOIL_MOISTURE: rec.soilMoisture = (int16_t)v; rec.flags |= SAMPLE_HAS_SOIL_MOISTURE; break;
+      case SF_SOIL_RAW: rec.soilRaw = (uint16_t)v; rec.flags |= SAMPLE_HAS_SOIL_MOISTURE; break;
+      case SF_BME_TEMP: rec.bmeTemp = (int16_t)v; rec.flags |= SAMPLE_HAS_BME280; break;
+      case SF_BME_HUMIDITY: rec.bmeHumidity = (int16_t)v; rec.flags |= SAMPLE_HAS_BME280; break;
+      case SF_PRESSURE: rec.pressure = (uint32_t)v; rec.flags |= SAMPLE_HAS_BME280; break;
+      case SF_UNSYNCED: if (v) rec.flags |= SAMPLE_UNSYNCED; break;
+      default: break;                         // a field from a newer writer
+    }
+  }
+  return haveTimestamp;
+}
+
+size_t decodeSample(const uint8_t* in, size_t len, SampleRecord& rec) {
+  ByteReader r = { in, in + len };
+  return readSample(r, rec) ? (size_t)(r.p - in) : 0;
+}
+
+// ---- Batches ----
+
+static const char base64Chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+struct Base64Writer {
+  char* out;
+  size_t cap;
+  size_t n;
+  uint32_t acc;
+  uint8_t bits;
+  bool ok;
+
+  void emit(char c) {
+    if (n + 1 < cap) out[n++] = c;            // room for the NUL is kept
+    else ok = false;
+  }
+  void put(const uint8_t* p, size_t len) {
+    while (len--) {
+      acc = acc << 8 | *p++;
+      bits += 8;
+      while (bits >= 6) {
+        bits -= 6;
+        emit(base64Chars[(acc >> bits) & 0x3F]);
+      }
+    }
+  }
+  size_t finish() {
+    if (bits) emit(base64Chars[(acc << (6 - bits)) & 0x3F]);
+    while (ok && n % 4) emit('=');
+    if (!ok || cap == 0) return 0;
+    out[n] = '\0';
+    return n;
+  }
+};
+
+size_t encodeBatch(const SampleRecord* recs, size_t n, char* out, size_t cap) {
+  if (n > 0xFFFF) return 0;
+  Base64Writer w = { out, cap, 0, 0, 0, true };
+  uint8_t buf[SAMPLE_PACKED_MAX];
+  uint8_t* p = buf;
+  if (n < 16) {
+    *p++ = 0x90 | (uint8_t)n;                 // fixarray
+  } else {
+    *p++ = 0xDC;                              // array 16
+    p = putBe(p, (uint32_t)n, 2);
+  }
+  w.put(buf, p - buf);
+  for (size_t i = 0; i < n && w.ok; i++) w.put(buf, encodeSample(recs[i], buf, sizeof(buf)));
+  return w.finish();
+}
+
+// ---- Delta batches ----
+
+static uint8_t* putVarint(uint8_t* p, uint64_t v) {
+  while (v >= 0x80) {
+    *p++ = (uint8_t)(v | 0x80);
+    v >>= 7;
+  }
+  *p++ = (uint8_t)v;
+  return p;
+}
+
+template <class R>
+static bool readVarint(R& r, uint64_t& v) {
+  v = 0;
+  uint8_t b;
+  for (uint8_t shift = 0; shift < 70; shift += 7) {
+    if (!r.next(b)) return false;
+    v |= (uint64_t)(b & 0x7F) << shift;
+    if (!(b & 0x80)) return true;
+  }
+  return false;
+}
+
+// Small magnitudes of either sign to small unsigned numbers: 0, -1, 1, -2 -> 0, 1, 2, 3
+static uint32_t zigzag(int32_t v) { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+static int32_t unzigzag(uint32_t v) { return (int32_t)(v >> 1) ^ -(int32_t)(v & 1); }
+// The same for timestamps, whose first delta is the whole epoch-ms value
+static uint64_t zigzag64(int64_t v) { return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63); }
+static int64_t unzigzag64(uint64_t v) { return (int64_t)(v >> 1) ^ -(int64_t)(v & 1); }
+
+// The value fields each SAMPLE_HAS_* group fills, as a mask of field IDs
+static uint16_t fieldsFor(uint16_t flags) {
+  uint16_t m = 0;
+  if (flags & SAMPLE_HAS_DHT11) m |= 1 << SF_AIR_TEMP | 1 << SF_AIR_HUMIDITY | 1 << SF_HEAT_INDEX;
+  if (flags & SAMPLE_HAS_SOIL_TEMP) m |= 1 << SF_SOIL_TEMP;
+  if (flags & SAMPLE_HAS_SOIL_MOISTURE) m |= 1 << SF_SOIL_MOISTURE | 1 << SF_SOIL_RAW;
+  if (flags & SAMPLE_HAS_BME280) m |= 1 << SF_BME_TEMP | 1 << SF_BME_HUMIDITY | 1 << SF_PRESSURE;
+  return m;
+}
+
+// Unsigned fields go through int32 too; deltas wrap the same way on both sides
+static int32_t getField(const SampleRecord& r, uint8_t id) {
+  switch (id) {
+    case SF_AIR_TEMP: return r.airTemp;
+    case SF_AIR_HUMIDITY: return r.airHumidity;
+    case SF_HEAT_INDEX: return r.heatIndex;
+    case SF_SOIL_TEMP: return r.soilTemp;
+    case SF_SOIL_MOISTURE: return r.soilMoisture;
+    case SF_SOIL_RAW: return r.soilRaw;
+    case SF_BME_TEMP: return r.bmeTemp;
+    case SF_BME_HUMIDITY: return r.bmeHumidity;
+    case SF_PRESSURE: return (int32_t)r.pressure;
+    default: return 0;
+  }
+}
+
+static void setField(SampleRecord& r, uint8_t id, int32_t v) {
+  switch (id) {
+    case SF_AIR_TEMP: r.airTemp = (int16_t)v; break;
+    case SF_AIR_HUMIDITY: r.airHumidity = (int16_t)v; break;
+    case SF_HEAT_INDEX: r.heatIndex = (int16_t)v; break;
+    case SF_SOIL_TEMP: r.soilTemp = (int16_t)v; break;
+    case SF_SOIL_MOISTURE: r.soilMoisture = (int16_t)v; break;
+    case SF_SOIL_RAW: r.soilRaw = (uint16_t)v; break;
+    case SF_BME_TEMP: r.bmeTemp = (int16_t)v; break;
+    case SF_BME_HUMIDITY: r.bmeHumidity = (int16_t)v; break;
+    case SF_PRESSURE: r.pressure = (uint32_t)v; break;
+  }
+}
+
+// What the previous record left behind; a zeroed state makes the first record its own delta
+struct DeltaState {
+  uint16_t flags;
+  uint64_t timestamp;
+  uint64_t interval;
+  int32_t values[SF_COUNT];
+};
+
+size_t encodeDeltaBatch(const SampleRecord* recs, size_t n, char* out, size_t cap) {
+  if (n > 0xFFFF) return 0;
+  Base64Writer w = { out, cap, 0, 0, 0, true };
+  uint8_t buf[SAMPLE_DELTA_HEADER + SAMPLE_DELTA_RECORD_MAX];
+  uint16_t mask = 0;
+  for (size_t i = 0; i < n; i++) mask |= fieldsFor(recs[i].flags);
+
+  uint8_t* p = buf;
+  *p++ = SAMPLE_DELTA_MAGIC;
+  p = putVarint(p, (uint32_t)n);
+  p = putVarint(p, mask);                     // the field dictionary, once per batch
+  w.put(buf, p - buf);
+
+  DeltaState st;
+  memset(&st, 0, sizeof(st));
+  for (size_t i = 0; i < n && w.ok; i++) {
+    const SampleRecord& r = recs[i];
+    p = buf;
+    p = putVarint(p, r.flags ^ st.flags);
+    uint64_t interval = r.timestamp - st.timestamp;
+    p = putVarint(p, zigzag64((int64_t)(interval - st.interval)));   // delta of delta: 0 on a steady grid
+    st.flags = r.flags;
+    st.timestamp = r.timestamp;
+    st.interval = interval;
+    for (uint8_t id = 1; id < SF_COUNT; id++) {
+      if (!(mask & 1 << id)) continue;
+      int32_t v = getField(r, id);
+      p = putVarint(p, zigzag((int32_t)((uint32_t)v - (uint32_t)st.values[id])));
+      st.values[id] = v;
+    }
+    w.put(buf, p - buf);
+  }
+  return w.finish();
+}
+
+// Samples of a base64 batch in either format, one at a time
+struct BatchReader {
+  Base64Reader in;
+  bool delta;
+  uint32_t remaining;
+  uint16_t mask;
+  DeltaState st;
+
+  bool begin(const char* b64) {
+    in.s = b64;
+    in.acc = 0;
+    in.bits = 0;
+    memset(&st, 0, sizeof(st));
+    uint8_t t;
+    uint64_t n, u;
+    if (!in.next(t)) return false;
+    delta = t == SAMPLE_DELTA_MAGIC;
+    if (delta) {
+      if (!readVarint(in, n) || n > 0xFFFF || !readVarint(in, u)) return false;
+      remaining = (uint32_t)n;
+      mask = (uint16_t)u;
+      return true;
+    }
+    if ((t & 0xF0) == 0x90) {
+      remaining = t & 0x0F;
+      return true;
+    }
+    if (t != 0xDC || !readBe(in, 2, u)) return false;
+    remaining = (uint32_t)u;
+    return true;
+  }
+
+  bool next(SampleRecord& rec) {
+    if (!remaining) return false;
+    remaining--;
+    if (!delta) return readSample(in, rec);
+
+    memset(&rec, 0, sizeof(rec));
+    uint64_t u;
+    if (!readVarint(in, u)) return false;
+    st.flags ^= (uint16_t)u;
+    if (!readVarint(in, u)) return false;
+    st.interval += (uint64_t)unzigzag64(u);
+    st.timestamp += st.interval;
+    for (uint8_t id = 1; id < SF_COUNT; id++) {
+      if (!(mask & 1 << id)) continue;
+      if (!readVarint(in, u)) return false;
+      st.values[id] = (int32_t)((uint32_t)st.values[id] + (uint32_t)unzigzag((uint32_t)u));
+      setField(rec, id, st.values[id]);
+    }
+    rec.flags = st.flags;
+    rec.timestamp = st.timestamp;
+    return true;
+  }
+};
+
+size_t decodeBatch(const char* b64, SampleRecord* out, size_t max) {
+  BatchReader r;
+  if (!r.begin(b64)) return 0;
+  size_t got = 0;
+  while (got < max && r.remaining) {
+    if (!r.next(out[got])) return 0;
+    got++;
+  }
+  return got;
+}
+
+bool packedBatchToJson(const char* b64, JsonObject out) {
+  BatchReader r;
+  if (!r.begin(b64)) return false;
+  char key[21];
+  SampleRecord rec;
+  while (r.remaining) {
+    if (!r.next(rec)) return false;
+    snprintf(key, sizeof(key), "%llu", (unsigned long long)rec.timestamp);
+    sampleToJson(rec, out[key].to<JsonObject>());
+  }
+  return true;
+}
@@ -0,0 +1,67 @@
+#ifndef SAMPLE_CODEC_H
+#define SAMPLE_CODEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <ArduinoJson.h>
+#include "sampleRecord.h"
+
+// Binary form of a SampleRecord for batch uploads: a MessagePack map keyed by the small
+// integer field IDs below, each value the record's own fixed-point integer in its shortest
+// MessagePack encoding. Sensor groups the sample does not have are left out. A full sample
+// is at most 51 bytes against about 240 for its JSON, and encoding is a few byte stores per
+// field with no document in between. Any MessagePack decoder can read it; decodeSample()
+// and packedBatchToJson() turn it back into the JSON that readSensorData produces.
+//
+// Field IDs are part of the stored format: add new ones at the end, never renumber.
+enum SampleField {
+  SF_TIMESTAMP = 0,       // epoch ms; 32-bit values from before epoch keys still decode
+  SF_AIR_TEMP = 1,        // DHT11, 0.01 degC
+  SF_AIR_HUMIDITY = 2,    // DHT11, 0.01 %RH
+  SF_HEAT_INDEX = 3,      // DHT11, 0.01 degC
+  SF_SOIL_TEMP = 4,       // DS18B20, 0.01 degC
+  SF_SOIL_MOISTURE = 5,   // 0.01 %
+  SF_SOIL_RAW = 6,        // ADC counts
+  SF_BME_TEMP = 7,        // 0.01 degC
+  SF_BME_HUMIDITY = 8,    // 0.01 %RH
+  SF_PRESSURE = 9,        // Pa
+  SF_UNSYNCED = 10,       // 1: the key is provisional (sampleClock.h); left out otherwise
+  SF_COUNT
+};
+
+// Map header 1, timestamp 1 + 9, pressure 1 + 5, eight 16-bit fields at 1 + 3, unsynced 1 + 1
+#define SAMPLE_PACKED_MAX 51
+// A batch is one MessagePack array of samples, base64 so it can be stored as an RTDB string
+#define SAMPLE_BATCH_BYTES(n) (3 + (n) * SAMPLE_PACKED_MAX)
+#define SAMPLE_BATCH_CHARS(n) ((SAMPLE_BATCH_BYTES(n) + 2) / 3 * 4 + 1)
+
+// Bytes written, 0 if cap is too small
+size_t encodeSample(const SampleRecord& rec, uint8_t* out, size_t cap);
+// Bytes consumed, 0 if the input is not a packed sample. Unknown integer fields are skipped.
+size_t decodeSample(const uint8_t* in, size_t len, SampleRecord& rec);
+
+// n samples as a NUL-terminated base64 batch; returns its length, 0 if cap is too small
+size_t encodeBatch(const SampleRecord* recs, size_t n, char* out, size_t cap);
+
+// Delta batch, for runs of consecutive samples that differ by a few hundredths. After the
+// magic byte come the sample count and a mask of the field IDs used anywhere in the batch
+// (the key dictionary, stored once). Each sample is then varints: its flags XOR the
+// previous flags, the zig-zag delta of delta of its timestamp (Gorilla-style, 0 on a
+// steady sampling grid), and per dictionary field the zig-zag delta from the previous
+// value. The first sample is coded against an all-zero one, so it carries the base values.
+// A steady trace costs about one byte per field.
+#define SAMPLE_DELTA_MAGIC 0x44   // 'D'; a MessagePack positive fixint, never an array header
+#define SAMPLE_DELTA_HEADER 6     // magic, count and mask varints
+#define SAMPLE_DELTA_RECORD_MAX 42    // flags 3, timestamp 10, eight 16-bit deltas at 3, pressure 5
+#define SAMPLE_DELTA_BYTES(n) (SAMPLE_DELTA_HEADER + (n) * SAMPLE_DELTA_RECORD_MAX)
+#define SAMPLE_DELTA_CHARS(n) ((SAMPLE_DELTA_BYTES(n) + 2) / 3 * 4 + 1)
+size_t encodeDeltaBatch(const SampleRecord* recs, size_t n, char* out, size_t cap);
+
+// Both batch formats decode here, told apart by the first byte. Plain C++ with no device
+// dependencies, so the ingestion side can build this file as it is.
+// Up to max samples of a base64 batch; returns the number decoded, 0 if malformed
+size_t decodeBatch(const char* b64, SampleRecord* out, size_t max);
+// Exporter: a batch as today's lastReadings entries, out["<timestamp>"] = sample
+bool packedBatchToJson(const char* b64, JsonObject out);
+
+#endif
@@ -0,0 +1,11 @@
+#include "sampleLog.h"
+
+// CRC-16/CCITT-FALSE
+uint16_t crc16(const void* data, size_t len, uint16_t crc) {
+  const uint8_t* p = (const uint8_t*)data;
+  while (len--) {
+    crc ^= (uint16_t)(*p++) << 8;
+    for (uint8_t i = 0; i < 8; i++) crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+  }
+  return crc;
+}
@@ -0,0 +1,240 @@
+#ifndef SAMPLE_LOG_H
+#define SAMPLE_LOG_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "blockStore.h"
+#include "sampleRecord.h"
+
+#define SAMPLE_LOG_SEGMENTS 8          // Segment files in rotation
+#define SAMPLE_LOG_SEG_RECORDS 256     // Records per segment (~9 KB per file)
+#define SAMPLE_LOG_SEG_MAGIC 0x534C4732UL   // "SLG2": 64-bit timestamps; older segments are ignored
+#define RECORD_LOG_META_MAGIC 0x534D4554UL  // "SMET"
+#define RECORD_LOG_FRAME_MAGIC 0xA55A
+
+uint16_t crc16(const void* data, size_t len, uint16_t crc = 0xFFFF);
+
+// Bounded store-and-forward log of fixed-size records (SampleRecords, window summaries).
+// Records are appended as fixed-size CRC-checked frames to the head segment; a full segment
+// is sealed and the next slot is erased and reused, so writes rotate over every file and the
+// log never holds more than SEGMENTS x SEG_RECORDS records (oldest are dropped first).
+// A torn frame from a crash is detected by its CRC on begin(); the head is then sealed and
+// appends continue in a fresh segment, so no file is ever rewritten in place.
+// The read cursor lives in the metadata blob and only advances after a batch is committed.
+// SEG_MAGIC tells the record format apart: segments of another format are ignored.
+template <typename Rec, uint32_t SEGMENTS, uint32_t SEG_RECORDS, uint32_t SEG_MAGIC>
+class RecordLog {
+  static_assert(SEGMENTS >= 2 && SEGMENTS <= 255 && SEG_RECORDS <= 0xFFFF, "log geometry");
+
+public:
+  explicit RecordLog(BlockStore& store) : store_(store) {}
+
+  bool begin() {
+    empty_ = true;
+    for (uint8_t s = 0; s < SEGMENTS; s++) {
+      SegHeader hdr;
+      if (store_.size(s) < (int32_t)sizeof(hdr)) continue;
+      if (!store_.read(s, 0, &hdr, sizeof(hdr)) || hdr.magic != SEG_MAGIC) continue;
+      if (hdr.seq % SEGMENTS != s) continue;
+      if (empty_ || hdr.seq > headSeq_) headSeq_ = hdr.seq;
+      empty_ = false;
+    }
+
+    if (!empty_) {
+      // Sealed segments by their size; a corrupt frame among them is found by peek()
+      for (uint32_t seq = oldestSeq(); seq < headSeq_; seq++) {
+        int32_t size = readHeader(seq) ? store_.size(slot(seq)) : 0;
+        uint32_t n = size > (int32_t)sizeof(SegHeader) ? (size - sizeof(SegHeader)) / sizeof(Frame) : 0;
+        counts_[slot(seq)] = (uint16_t)(n < SEG_RECORDS ? n : SEG_RECORDS);
+      }
+      headCount_ = validRecords(headSeq_);
+      // A partial frame or bad CRC at the tail means the last append was torn
+      int32_t expect = (int32_t)(sizeof(SegHeader) + headCount_ * sizeof(Frame));
+      headSealed_ = headCount_ >= SEG_RECORDS || store_.size(slot(headSeq_)) != expect;
+    }
+
+    Meta meta;
+    if (store_.readMeta(&meta, sizeof(meta)) && meta.magic == RECORD_LOG_META_MAGIC &&
+        meta.crc == crc16(&meta, offsetof(Meta, crc))) {
+      readSeq_ = meta.readSeq;
+      readIdx_ = meta.readIdx;
+      dropped_ = meta.dropped;
+    } else {
+      readSeq_ = oldestSeq();
+      readIdx_ = 0;
+    }
+    if (readSeq_ < oldestSeq()) {
+      readSeq_ = oldestSeq();
+      readIdx_ = 0;
+    }
+    if (empty_ || readSeq_ > headSeq_) {
+      readSeq_ = empty_ ? 0 : headSeq_;
+      readIdx_ = empty_ ? 0 : headCount_;
+    }
+    peekSeq_ = readSeq_;
+    peekIdx_ = readIdx_;
+    return true;
+  }
+
+  bool append(const Rec& rec) {
+    if (empty_) {
+      if (!openSegment(0)) return false;
+    } else if (headSealed_ || headCount_ >= SEG_RECORDS) {
+      if (!openSegment(headSeq_ + 1)) return false;
+    }
+
+    Frame frame;
+    frame.magic = RECORD_LOG_FRAME_MAGIC;
+    frame.rec = rec;
+    frame.crc = crc16(&frame.rec, sizeof(frame.rec));
+    if (!store_.append(slot(headSeq_), &frame, sizeof(frame))) {
+      headSealed_ = true;   // unknown tail state, continue in a fresh segment
+      return false;
+    }
+    headCount_++;
+    return true;
+  }
+
+  // Copies up to max pending records starting at the cursor without consuming them
+  size_t peek(Rec* out, size_t max) {
+    size_t n = 0;
+    uint32_t seq = readSeq_;
+    uint32_t idx = readIdx_;
+    bool checked = false;
+
+    while (n < max && !empty_ && (seq < headSeq_ || idx < headCount_)) {
+      bool end = idx >= count(seq);
+      if (!end && !checked) {
+        end = !readHeader(seq);
+        checked = true;
+      }
+      if (!end && !readFrame(seq, idx, out[n])) end = true;
+      if (end) {
+        // Sealed early, missing or corrupt: the segment ends here, continue with the next
+        if (seq == headSeq_) break;
+        if (idx < count(seq)) counts_[slot(seq)] = (uint16_t)idx;
+        seq++;
+        idx = 0;
+        checked = false;
+        continue;
+      }
+      n++;
+      idx++;
+    }
+
+    peekSeq_ = seq;
+    peekIdx_ = idx;
+    return n;
+  }
+
+  // Consumes the records returned by the last peek and persists the cursor
+  bool commit() {
+    readSeq_ = peekSeq_;
+    readIdx_ = peekIdx_;
+
+    Meta meta;
+    memset(&meta, 0, sizeof(meta));
+    meta.magic = RECORD_LOG_META_MAGIC;
+    meta.readSeq = readSeq_;
+    meta.readIdx = readIdx_;
+    meta.dropped = dropped_;
+    meta.crc = crc16(&meta, offsetof(Meta, crc));
+    return store_.writeMeta(&meta, sizeof(meta));
+  }
+
+  // Records between the cursor and the head
+  uint32_t pending() const {
+    if (empty_) return 0;
+    uint32_t n = count(readSeq_) > readIdx_ ? count(readSeq_) - readIdx_ : 0;
+    for (uint32_t seq = readSeq_ + 1; seq <= headSeq_; seq++) n += count(seq);
+    return n;
+  }
+  uint32_t dropped() const { return dropped_; }
+
+private:
+  struct SegHeader {
+    uint32_t magic;
+    uint32_t seq;
+  };
+  struct Frame {
+    uint16_t magic;
+    uint16_t crc;
+    Rec rec;
+  };
+  struct Meta {
+    uint32_t magic;
+    uint32_t readSeq;
+    uint32_t readIdx;
+    uint32_t dropped;
+    uint16_t crc;
+  };
+
+  uint8_t slot(uint32_t seq) const { return seq % SEGMENTS; }
+  uint32_t oldestSeq() const { return headSeq_ >= SEGMENTS - 1 ? headSeq_ - (SEGMENTS - 1) : 0; }
+  uint32_t count(uint32_t seq) const { return seq == headSeq_ ? headCount_ : counts_[slot(seq)]; }
+
+  bool readHeader(uint32_t seq) {
+    SegHeader hdr;
+    return store_.read(slot(seq), 0, &hdr, sizeof(hdr)) && hdr.magic == SEG_MAGIC && hdr.seq == seq;
+  }
+
+  bool readFrame(uint32_t seq, uint32_t idx, Rec& rec) {
+    Frame frame;
+    uint32_t off = sizeof(SegHeader) + idx * sizeof(Frame);
+    if (!store_.read(slot(seq), off, &frame, sizeof(frame))) return false;
+    if (frame.magic != RECORD_LOG_FRAME_MAGIC || frame.crc != crc16(&frame.rec, sizeof(frame.rec))) return false;
+    rec = frame.rec;
+    return true;
+  }
+
+  uint32_t validRecords(uint32_t seq) {
+    if (!readHeader(seq)) return 0;
+    Rec rec;
+    uint32_t n = 0;
+    while (n < SEG_RECORDS && readFrame(seq, n, rec)) n++;
+    return n;
+  }
+
+  // Reuse the slot for seq. If the reader has not reached the segment that lived there,
+  // that segment is dropped and the cursor moves to the oldest surviving one.
+  bool openSegment(uint32_t seq) {
+    if (!empty_) counts_[slot(headSeq_)] = (uint16_t)headCount_;
+    if (seq >= SEGMENTS && readSeq_ <= seq - SEGMENTS) {
+      uint32_t lost = count(readSeq_);
+      dropped_ += lost > readIdx_ ? lost - readIdx_ : 0;
+      readSeq_ = seq - SEGMENTS + 1;
+      readIdx_ = 0;
+      peekSeq_ = readSeq_;
+      peekIdx_ = 0;
+    }
+
+    headSeq_ = seq;
+    headCount_ = 0;
+    headSealed_ = false;
+    empty_ = false;
+
+    SegHeader hdr = { SEG_MAGIC, seq };
+    if (!store_.erase(slot(seq)) || !store_.append(slot(seq), &hdr, sizeof(hdr))) {
+      headSealed_ = true;
+      return false;
+    }
+    return true;
+  }
+
+  BlockStore& store_;
+  bool empty_ = true;          // no segment written yet
+  uint32_t headSeq_ = 0;
+  uint32_t headCount_ = 0;     // records in head segment
+  uint16_t counts_[SEGMENTS] = {};   // records in each sealed segment, fewer if sealed early
+  bool headSealed_ = false;
+  uint32_t readSeq_ = 0;
+  uint32_t readIdx_ = 0;
+  uint32_t peekSeq_ = 0;       // cursor position after the last peek
+  uint32_t peekIdx_ = 0;
+  uint32_t dropped_ = 0;
+};
+
+typedef RecordLog<SampleRecord, SAMPLE_LOG_SEGMENTS, SAMPLE_LOG_SEG_RECORDS, SAMPLE_LOG_SEG_MAGIC> SampleLog;
+
+#endif
@@ -0,0 +1,72 @@
+#include "sampleRecord.h"
+#include <math.h>
+#include <string.h>
+
+void sampleFromJson(JsonDocument& doc, SampleRecord& rec) {
+  memset(&rec, 0, sizeof(rec));
+  rec.timestamp = doc["timestamp"].as<uint64_t>();
+
+  JsonObject dht = doc["dht11"];
+  if (!dht.isNull()) {
+    rec.flags |= SAMPLE_HAS_DHT11;
+    rec.airTemp = toCenti(dht["temperature"].as<float>());
+    rec.airHumidity = toCenti(dht["humidity"].as<float>());
+    rec.heatIndex = toCenti(dht["heatIndex"].as<float>());
+  }
+
+  JsonObject st = doc["soilTemperature"];
+  if (!st.isNull()) {
+    rec.flags |= SAMPLE_HAS_SOIL_TEMP;
+    rec.soilTemp = toCenti(st["celsius"].as<float>());
+  }
+
+  JsonObject sm = doc["soilMoisture"];
+  if (!sm.isNull()) {
+    rec.flags |= SAMPLE_HAS_SOIL_MOISTURE;
+    rec.soilRaw = sm["raw"].as<uint16_t>();
+    rec.soilMoisture = toCenti(sm["percentage"].as<float>());
+  }
+
+  JsonObject bme = doc["bme280"];
+  if (!bme.isNull()) {
+    rec.flags |= SAMPLE_HAS_BME280;
+    rec.bmeTemp = toCenti(bme["temperature"].as<float>());
+    rec.bmeHumidity = toCenti(bme["humidity"].as<float>());
+    rec.pressure = (uint32_t)lroundf(bme["pressure"].as<float>() * 100.0f);  // hPa -> Pa
+  }
+
+  if (doc["unsynced"].as<bool>()) rec.flags |= SAMPLE_UNSYNCED;
+}
+
+void sampleToJson(const SampleRecord& rec, JsonObject out) {
+  out["timestamp"] = rec.timestamp;
+
+  if (rec.flags & SAMPLE_HAS_DHT11) {
+    JsonObject dht = out["dht11"].to<JsonObject>();
+    dht["temperature"] = fromCenti(rec.airTemp);
+    dht["humidity"] = fromCenti(rec.airHumidity);
+    dht["heatIndex"] = fromCenti(rec.heatIndex);
+  }
+
+  if (rec.flags & SAMPLE_HAS_SOIL_TEMP) {
+    JsonObject st = out["soilTemperature"].to<JsonObject>();
+    st["celsius"] = fromCenti(rec.soilTemp);
+    int32_t f9 = rec.soilTemp * 9;
+    st["fahrenheit"] = fromCenti((f9 >= 0 ? f9 + 2 : f9 - 2) / 5 + 3200);
+  }
+
+  if (rec.flags & SAMPLE_HAS_SOIL_MOISTURE) {
+    JsonObject sm = out["soilMoisture"].to<JsonObject>();
+    sm["raw"] = rec.soilRaw;
+    sm["percentage"] = fromCenti(rec.soilMoisture);
+  }
+
+  if (rec.flags & SAMPLE_HAS_BME280) {
+    JsonObject bme = out["bme280"].to<JsonObject>();
+    bme["temperature"] = fromCenti(rec.bmeTemp);
+    bme["pressure"] = fromCenti(rec.pressure);   // Pa -> hPa
+    bme["humidity"] = fromCenti(rec.bmeHumidity);
+  }
+
+  if (rec.flags & SAMPLE_UNSYNCED) out["unsynced"] = true;
+}
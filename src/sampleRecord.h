@@ -0,0 +1,45 @@
+#ifndef SAMPLE_RECORD_H
+#define SAMPLE_RECORD_H
+
+#include <stdint.h>
+#include <ArduinoJson.h>
+
+// Compact fixed-point form of one sample set, used wherever samples are buffered or persisted.
+// Temperatures and percentages are in hundredths, pressure in Pa.
+
+#define SAMPLE_HAS_DHT11 0x0001
+#define SAMPLE_HAS_SOIL_TEMP 0x0002
+#define SAMPLE_HAS_SOIL_MOISTURE 0x0004
+#define SAMPLE_HAS_BME280 0x0008
+#define SAMPLE_UNSYNCED 0x0100   // provisional key: taken before the clock had an SNTP fix, or on a
+                                 // boundary that came round again after a step back (sampleClock.h)
+
+struct SampleRecord {
+  uint64_t timestamp;     // ms since the Unix epoch (sampleClock.h)
+  uint16_t flags;         // SAMPLE_HAS_*, SAMPLE_UNSYNCED
+  int16_t airTemp;        // DHT11, 0.01 degC
+  int16_t airHumidity;    // DHT11, 0.01 %RH
+  int16_t heatIndex;      // DHT11, 0.01 degC
+  int16_t soilTemp;       // DS18B20 first probe, 0.01 degC
+  int16_t soilMoisture;   // 0.01 %
+  uint16_t soilRaw;       // ADC counts
+  int16_t bmeTemp;        // 0.01 degC
+  int16_t bmeHumidity;    // 0.01 %RH
+  uint32_t pressure;      // Pa
+};
+
+// Driver floats enter fixed point once, at the HAL; values leave it only when serialized
+inline int16_t toCenti(float v) {
+  return (int16_t)(v * 100.0f + (v < 0 ? -0.5f : 0.5f));
+}
+
+inline double fromCenti(int32_t v) {
+  return v / 100.0;
+}
+
+// Pack the sensor fields of a sample document (as built by readSensorData)
+void sampleFromJson(JsonDocument& doc, SampleRecord& rec);
+// Rebuild the document shape readSensorData produces
+void sampleToJson(const SampleRecord& rec, JsonObject out);
+
+#endif
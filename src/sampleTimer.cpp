@@ -0,0 +1,164 @@
+#ifdef ARDUINO
+#include "sampleTimer.h"
+#include "metrics.h"
+#include "logger.h"
+#include <Preferences.h>
+#include <esp_attr.h>
+#include <esp_sntp.h>
+#include <sys/time.h>
+
+#define SAMPLE_KEY_MAGIC 0x534B4559   // "SKEY"
+
+struct RtcKey {
+  uint32_t magic;
+  uint64_t lastKey;
+};
+// Not cleared by a soft reset, a panic or a watchdog reset, unlike RTC_DATA_ATTR
+RTC_NOINIT_ATTR static RtcKey rtcKey;
+
+static TaskHandle_t notifyTask = nullptr;
+static hw_timer_t* activeTimer = nullptr;
+static volatile bool alarmFired = false;
+
+// SNTP fix waiting for the sampling task
+static portMUX_TYPE fixMux = portMUX_INITIALIZER_UNLOCKED;
+static bool fixPending = false;
+static uint64_t fixUs = 0;
+static uint64_t fixMs = 0;
+
+// Key floor handed to the save task: 64 bits are not written atomically
+static portMUX_TYPE keyMux = portMUX_INITIALIZER_UNLOCKED;
+static uint64_t takenFloor = 0;
+
+static void IRAM_ATTR onAlarm() {
+  alarmFired = true;
+  BaseType_t woken = pdFALSE;
+  vTaskNotifyGiveFromISR(notifyTask, &woken);
+  if (woken) portYIELD_FROM_ISR();
+}
+
+// lwIP task, right after SNTP has set the system time to tv
+static void onSntpSync(struct timeval* tv) {
+  uint64_t us = timerRead(activeTimer);
+  portENTER_CRITICAL(&fixMux);
+  fixUs = us;
+  fixMs = tv->tv_sec * 1000ULL + tv->tv_usec / 1000;
+  fixPending = true;
+  portEXIT_CRITICAL(&fixMux);
+  xTaskNotifyGive(notifyTask);   // apply it now rather than at the next alarm
+}
+
+bool SampleTimer::begin(TaskHandle_t task) {
+  notifyTask = task;
+  timer_ = timerBegin(SAMPLE_TIMER_ID, SAMPLE_TIMER_DIVIDER, true);
+  if (!timer_) {
+    LOG_E("✗ Sample timer unavailable\n");
+    return false;
+  }
+  activeTimer = timer_;
+  timerAttachInterrupt(timer_, onAlarm, true);
+
+  // Provisional keys continue above anything an earlier run can have handed out
+  uint64_t last = rtcKey.magic == SAMPLE_KEY_MAGIC ? rtcKey.lastKey : 0;
+  Preferences prefs;
+  if (prefs.begin(SAMPLE_CLOCK_NVS_NAMESPACE, true)) {
+    savedKey_ = prefs.getULong64("key", 0);
+    prefs.end();
+  }
+  if (savedKey_ && savedKey_ + SAMPLE_CLOCK_SAVE_MS > last) last = savedKey_ + SAMPLE_CLOCK_SAVE_MS;
+
+  // The RTC keeps the SNTP time through soft resets and deep sleep; after a power cycle
+  // it counts from 1970 and the last key is the better guess
+  timeval tv;
+  gettimeofday(&tv, nullptr);
+  uint64_t rtcMs = tv.tv_sec * 1000ULL + tv.tv_usec / 1000;
+  clock_.begin(now(), rtcMs >= SAMPLE_CLOCK_EPOCH_VALID ? rtcMs : 0, last);
+  arm();
+  xTaskCreate(saveTask, "clockSave", SAMPLE_CLOCK_SAVE_STACK, this, SAMPLE_CLOCK_SAVE_PRIORITY, nullptr);
+  LOG_I("✓ Sample clock started, first key %llu (%s)\n", (unsigned long long)key_,
+        rtcMs >= SAMPLE_CLOCK_EPOCH_VALID ? "RTC time" : "after the last key");
+  return true;
+}
+
+void SampleTimer::startSntp() {
+  if (!timer_) return;
+  sntp_set_time_sync_notification_cb(onSntpSync);
+  configTime(0, 0, SNTP_SERVER_1, SNTP_SERVER_2);
+}
+
+void SampleTimer::arm() {
+  key_ = clock_.next(now(), alarmUs_);
+  alarmFired = false;
+  timerAlarmWrite(timer_, alarmUs_, false);
+  timerAlarmEnable(timer_);
+}
+
+bool SampleTimer::due() {
+  if (!timer_) return false;
+  if (alarmFired) return true;
+
+  portENTER_CRITICAL(&fixMux);
+  bool pending = fixPending;
+  uint64_t us = fixUs, ms = fixMs;
+  fixPending = false;
+  portEXIT_CRITICAL(&fixMux);
+  if (!pending) return false;
+
+  uint32_t steps = clock_.steps();
+  clock_.sync(us, ms);
+  if (clock_.steps() != steps) {
+    LOG_W("⚠ Sample clock stepped by %ld ms\n", (long)(clock_.lastOffsetUs() / 1000));
+  } else {
+    LOG_I("✓ SNTP fix: offset %ld us, drift %ld ppb\n", (long)clock_.lastOffsetUs(), (long)clock_.driftPpb());
+  }
+
+  // The pending alarm was placed with the old mapping
+  timerAlarmDisable(timer_);
+  if (alarmFired) return true;   // take() re-arms on the new mapping
+  arm();
+  return false;
+}
+
+uint64_t SampleTimer::take() {
+  uint32_t jitter = clock_.taken(key_, alarmUs_, now());
+  #ifdef ENABLE_METRICS
+  metricsRecord(M_SAMPLE_JITTER, jitter);
+  #else
+  (void)jitter;
+  #endif
+  uint64_t key = key_;
+  rtcKey.magic = SAMPLE_KEY_MAGIC;
+  rtcKey.lastKey = clock_.keyFloor();
+  portENTER_CRITICAL(&keyMux);
+  takenFloor = rtcKey.lastKey;
+  portEXIT_CRITICAL(&keyMux);
+  arm();
+  return key;
+}
+
+void SampleTimer::saveTask(void* self) {
+  for (;;) {
+    vTaskDelay(pdMS_TO_TICKS(SAMPLE_CLOCK_SAVE_PERIOD));
+    static_cast<SampleTimer*>(self)->save();
+  }
+}
+
+void SampleTimer::save() {
+  portENTER_CRITICAL(&keyMux);
+  uint64_t key = takenFloor;
+  portEXIT_CRITICAL(&keyMux);
+  if (key > savedKey_) persist(key);
+}
+
+void SampleTimer::wait(uint32_t ms) {
+  ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(ms));
+}
+
+void SampleTimer::persist(uint64_t key) {
+  Preferences prefs;
+  if (!prefs.begin(SAMPLE_CLOCK_NVS_NAMESPACE, false)) return;
+  prefs.putULong64("key", key);
+  prefs.end();
+  savedKey_ = key;
+}
+#endif
@@ -0,0 +1,55 @@
+#ifndef SAMPLE_TIMER_H
+#define SAMPLE_TIMER_H
+
+#include <Arduino.h>
+#include "sampleClock.h"
+#include "nodeConfig.h"
+
+#define SAMPLE_TIMER_ID 0                 // Hardware timer group 0, timer 0
+#define SAMPLE_TIMER_DIVIDER 80           // 80 MHz APB -> 1 MHz, so the counter is in us
+#define SAMPLE_CLOCK_NVS_NAMESPACE "sclock"
+#define SAMPLE_CLOCK_SAVE_MS 600000       // A power cycle resumes provisional keys this far above the key in NVS
+#define SAMPLE_CLOCK_SAVE_PERIOD (SAMPLE_CLOCK_SAVE_MS / 2)   // save() this often, so NVS is never that far behind
+#define SAMPLE_CLOCK_SAVE_STACK 3072      // Preferences plus a log line
+#define SAMPLE_CLOCK_SAVE_PRIORITY 0      // Idle priority, as the log drain: never ahead of sampling or upload
+
+// Device side of SampleClock. A hardware timer's 64-bit counter is the clock's time base,
+// and its alarm, armed at the counter value of the next boundary, wakes the sampling task
+// from the ISR, so acquisition starts on the boundary rather than when loop() gets there.
+// SNTP fixes arrive on the lwIP task and are handed over under a spinlock; the sampling
+// task applies them. The last key is kept in RTC memory (soft resets, deep sleep) and in
+// NVS (power cycles), so provisional keys after a restart continue above it. The NVS write
+// can block for a flash erase, so a task of its own makes it, never the sampling task; the
+// cache is still off on both cores while flash is written, which can hold up a sample
+// start by a few ms every SAMPLE_CLOCK_SAVE_PERIOD at most (only when the key moved).
+class SampleTimer {
+public:
+  explicit SampleTimer(SampleClock& clock) : clock_(clock), timer_(nullptr), key_(0), alarmUs_(0), savedKey_(0) {}
+
+  // task is woken by the alarm, normally the loop task. Also starts the NVS save task.
+  bool begin(TaskHandle_t task);
+  // Once WiFi is up; fixes come every hour or so from then on
+  void startSntp();
+
+  // Sampling task only. Applies a pending SNTP fix; true once the alarm has fired.
+  bool due();
+  // Key of the due sample; records its jitter and arms the alarm for the next one
+  uint64_t take();
+  // Block for up to ms, back early when the alarm fires
+  void wait(uint32_t ms);
+
+private:
+  static void saveTask(void* self);
+  void save();              // last key to NVS if it moved; the save task only
+  uint64_t now() const { return timerRead(timer_); }
+  void arm();
+  void persist(uint64_t key);
+
+  SampleClock& clock_;
+  hw_timer_t* timer_;
+  uint64_t key_;            // sample the alarm is armed for
+  uint64_t alarmUs_;
+  uint64_t savedKey_;       // last key written to NVS
+};
+
+#endif
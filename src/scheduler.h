@@ -0,0 +1,124 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Cooperative deadline scheduler.
+// Each task owns an absolute deadline that advances by exactly one period per run,
+// so the sample period does not stretch by the time spent reading or uploading.
+// If a task falls behind by whole periods (e.g. a blocking upload), the missed slots
+// are skipped and counted instead of being replayed back to back.
+// The clock is injected, so the same code runs against millis() or a fake clock on a host.
+
+typedef uint32_t (*ClockFn)();
+typedef void (*TaskFn)();
+
+struct SchedTask {
+  const char* name;
+  TaskFn run;
+  uint32_t period;
+  uint32_t next;        // absolute deadline (clock units)
+  uint32_t lastLate;    // lateness of the most recent run
+  uint32_t maxLate;     // worst lateness seen since reset
+  uint32_t runs;
+  uint32_t skipped;     // whole periods dropped because the task was overdue
+  bool enabled;
+};
+
+template <size_t N>
+class Scheduler {
+public:
+  explicit Scheduler(ClockFn clock) : clock_(clock), count_(0) {}
+
+  // phase delays the first run relative to now, e.g. to order tasks sharing a period
+  int addTask(const char* name, TaskFn fn, uint32_t period, uint32_t phase = 0) {
+    if (count_ >= N || period == 0) return -1;
+    SchedTask& t = tasks_[count_];
+    t.name = name;
+    t.run = fn;
+    t.period = period;
+    t.next = clock_() + phase;
+    t.lastLate = 0;
+    t.maxLate = 0;
+    t.runs = 0;
+    t.skipped = 0;
+    t.enabled = true;
+    return (int)count_++;
+  }
+
+  // Runs every due task once, earliest deadline first.
+  // Returns the time until the next deadline so the caller can idle until then.
+  uint32_t tick() {
+    uint32_t ranMask = 0;
+    for (;;) {
+      uint32_t now = clock_();
+      int due = -1;
+      int32_t mostLate = 0;
+      for (size_t i = 0; i < count_; i++) {
+        SchedTask& t = tasks_[i];
+        if (!t.enabled || (ranMask & (1UL << i))) continue;
+        int32_t late = (int32_t)(now - t.next);
+        if (late >= 0 && (due < 0 || late > mostLate)) {
+          due = (int)i;
+          mostLate = late;
+        }
+      }
+      if (due < 0) break;
+
+      SchedTask& t = tasks_[due];
+      ranMask |= 1UL << due;
+      t.lastLate = (uint32_t)mostLate;
+      if (t.lastLate > t.maxLate) t.maxLate = t.lastLate;
+      t.runs++;
+      t.next += t.period;
+      // Overdue by one or more whole periods: realign to the grid instead of bursting
+      if ((int32_t)(now - t.next) >= 0) {
+        uint32_t missed = (now - t.next) / t.period + 1;
+        t.skipped += missed;
+        t.next += missed * t.period;
+      }
+      t.run();
+    }
+    return untilNext();
+  }
+
+  uint32_t untilNext() const {
+    uint32_t now = clock_();
+    uint32_t best = UINT32_MAX;
+    for (size_t i = 0; i < count_; i++) {
+      const SchedTask& t = tasks_[i];
+      if (!t.enabled) continue;
+      int32_t wait = (int32_t)(t.next - now);
+      uint32_t w = wait > 0 ? (uint32_t)wait : 0;
+      if (w < best) best = w;
+    }
+    return best;
+  }
+
+  SchedTask* task(int id) { return (id >= 0 && (size_t)id < count_) ? &tasks_[id] : nullptr; }
+  size_t size() const { return count_; }
+
+  void resetStats() {
+    for (size_t i = 0; i < count_; i++) {
+      tasks_[i].maxLate = 0;
+      tasks_[i].skipped = 0;
+      tasks_[i].runs = 0;
+    }
+  }
+
+private:
+  ClockFn clock_;
+  SchedTask tasks_[N];
+  size_t count_;
+};
+
+// Manually advanced clock for host-side tests of the scheduler and anything built on it
+struct FakeClock {
+  static uint32_t& now() { static uint32_t t = 0; return t; }
+  static uint32_t read() { return now(); }
+  static void set(uint32_t t) { now() = t; }
+  static void advance(uint32_t dt) { now() += dt; }
+};
+
+#endif
@@ -0,0 +1,219 @@
+#ifndef SENSOR_REGISTRY_H
+#define SENSOR_REGISTRY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <ArduinoJson.h>
+#include "sampleRecord.h"
+#include "rtcBatch.h"
+#include "acquisition.h"
+#include "metrics.h"
+#include "logger.h"
+
+// Compile-time list of the sensors on a node. Every sensor type declares its own timing
+// and output, and the registry samples each at its own period with no virtual calls and
+// no heap: the list is a chain of templates, one member per sensor type, fixed at compile
+// time. A sensor type provides
+//
+//   enum : uint32_t { MIN_PERIOD_MS = ..., WARMUP_MS = ... };   // sampling period, settle time after begin()
+//   enum : uint16_t { FIELDS = SAMPLE_HAS_... };                // SampleRecord fields it fills
+//   static const char* name();
+//   bool begin();                                 // cold start
+//   void save(RtcSensorState& s) const;           // what a deep-sleep wake needs to skip begin()
+//   bool resume(const RtcSensorState& s);         // warm start after deep sleep
+//   uint32_t start(uint32_t now);                 // trigger a conversion: ms until read() has it, 0 = read now
+//   void read(uint32_t now);                      // collect into the sensor's own fixed-point state
+//   void publish(JsonDocument& doc, SampleRecord& rec);   // newest state into the sample
+//
+// sensors.h has the types for the sensors in this repo.
+//
+// When samples are taken on SampleClock boundaries, align() at each one moves every sensor's
+// deadline onto it, so the published sample is read at its key rather than up to one
+// sensor period earlier; pending() holds until those reads are in.
+
+struct SensorSlot {
+  uint32_t next;        // next sampling deadline
+  uint32_t readAt;      // when the running conversion can be collected
+  bool converting;
+  uint32_t reads;
+  uint32_t skipped;     // whole periods dropped because poll() came late
+  uint32_t started;     // when the newest read started
+  uint32_t alignedAt;   // the read align() waits for starts here ...
+  bool pending;         // ... and has not been collected yet
+};
+
+struct SensorStats {
+  const char* name;
+  uint32_t periodMs;
+  uint32_t reads;
+  uint32_t skipped;
+  uint32_t lastStart;
+};
+
+template <typename... Sensors>
+class SensorRegistry;
+
+template <>
+class SensorRegistry<> {
+public:
+  enum : uint16_t { FIELDS = 0 };
+  enum : size_t { COUNT = 0 };
+
+  void begin(uint32_t) {}
+  void resume(const RtcSensorState&, uint32_t) {}
+  void save(RtcSensorState&) const {}
+  uint32_t poll(uint32_t) { return UINT32_MAX; }
+  void align(uint32_t) {}
+  bool pending() const { return false; }
+  uint32_t startAll(uint32_t) { return 0; }
+  void readAll(uint32_t) {}
+  void publishAll(JsonDocument&, SampleRecord&) {}
+  void stats(SensorStats*) const {}
+};
+
+template <typename Head, typename... Tail>
+class SensorRegistry<Head, Tail...> {
+  typedef SensorRegistry<Tail...> Rest;
+  static_assert((Head::FIELDS & Rest::FIELDS) == 0, "two sensors fill the same SampleRecord fields");
+  static_assert(Head::MIN_PERIOD_MS > 0, "a sensor needs a sampling period");
+
+public:
+  enum : uint16_t { FIELDS = Head::FIELDS | Rest::FIELDS };
+  enum : size_t { COUNT = 1 + Rest::COUNT };
+
+  explicit SensorRegistry(Head& head, Tail&... tail) : head_(head), rest_(tail...) {
+    slot_ = SensorSlot();
+  }
+
+  // Cold start; the first sample waits out the sensor's warm-up
+  void begin(uint32_t now) {
+    if (head_.begin()) LOG_I("✓ %s initialized\n", Head::name());
+    else LOG_E("✗ %s initialization failed\n", Head::name());
+    slot_ = SensorSlot();
+    slot_.next = now + Head::WARMUP_MS;
+    rest_.begin(now);
+  }
+
+  // Deep-sleep wake: the sensors stayed powered and configured
+  void resume(const RtcSensorState& s, uint32_t now) {
+    if (!head_.resume(s)) LOG_E("✗ %s warm start failed\n", Head::name());
+    slot_ = SensorSlot();
+    slot_.next = now;
+    rest_.resume(s, now);
+  }
+
+  void save(RtcSensorState& s) const {
+    head_.save(s);
+    rest_.save(s);
+  }
+
+  // Run every sensor that is due: start its conversion, or collect one that finished.
+  // Returns the time until the next sensor event so the caller can idle until then.
+  uint32_t poll(uint32_t now) {
+    if (slot_.converting && (int32_t)(now - slot_.readAt) >= 0) collect(now);
+    if (!slot_.converting && (int32_t)(now - slot_.next) >= 0) {
+      slot_.next += Head::MIN_PERIOD_MS;
+      // Overdue by whole periods: realign to the grid instead of bursting
+      if ((int32_t)(now - slot_.next) >= 0) {
+        uint32_t missed = (now - slot_.next) / Head::MIN_PERIOD_MS + 1;
+        slot_.skipped += missed;
+        slot_.next += missed * Head::MIN_PERIOD_MS;
+      }
+      slot_.started = now;
+      uint32_t conversion = head_.start(now);
+      if (conversion == 0) {
+        collect(now);
+      } else {
+        slot_.converting = true;
+        slot_.readAt = now + conversion;
+      }
+    }
+    int32_t wait = (int32_t)((slot_.converting ? slot_.readAt : slot_.next) - now);
+    uint32_t mine = wait > 0 ? (uint32_t)wait : 0;
+    uint32_t rest = rest_.poll(now);
+    return mine < rest ? mine : rest;
+  }
+
+  // A sample boundary at at: each sensor reads on it, or within an eighth of its period
+  // (millis() and the alarm disagree by a ms now and then), and its grid continues from
+  // there. One that could only do so by running faster than its period sits this sample
+  // out and moves onto the boundary's grid for the next.
+  void align(uint32_t at) {
+    const uint32_t slack = Head::MIN_PERIOD_MS / 8;
+    bool started = slot_.reads || slot_.converting;
+    uint32_t earliest = started ? slot_.started + Head::MIN_PERIOD_MS : slot_.next;
+    slot_.pending = false;
+    if (started && at - slot_.started <= slack) {
+      slot_.alignedAt = slot_.started;   // already reading on this boundary
+      slot_.pending = slot_.converting;
+    } else if ((int32_t)(earliest - at) <= (int32_t)slack) {
+      slot_.next = (int32_t)(earliest - at) > 0 ? earliest : at;
+      slot_.alignedAt = slot_.next;
+      slot_.pending = true;
+    } else {
+      slot_.next = at + (earliest - at + Head::MIN_PERIOD_MS - 1) / Head::MIN_PERIOD_MS * Head::MIN_PERIOD_MS;
+    }
+    rest_.align(at);
+  }
+
+  // Some read started by the last align() is still to be collected
+  bool pending() const {
+    return slot_.pending || rest_.pending();
+  }
+
+  // One-shot sampling (deep sleep): trigger everything, returns the longest conversion
+  uint32_t startAll(uint32_t now) {
+    uint32_t conversion = head_.start(now);
+    uint32_t rest = rest_.startAll(now);
+    return conversion > rest ? conversion : rest;
+  }
+
+  // ... then collect everything once that has passed
+  void readAll(uint32_t now) {
+    collect(now);
+    rest_.readAll(now);
+  }
+
+  // The newest reading of every sensor as one sample
+  void publish(uint64_t timestamp, JsonDocument& doc, SampleRecord& rec) {
+    METRIC_SCOPE(M_READ_SENSORS);
+    beginSample(timestamp, doc, rec);
+    publishAll(doc, rec);
+  }
+
+  void publishAll(JsonDocument& doc, SampleRecord& rec) {
+    head_.publish(doc, rec);
+    rest_.publishAll(doc, rec);
+  }
+
+  // out must have room for COUNT entries, in registry order
+  void stats(SensorStats* out) const {
+    out->name = Head::name();
+    out->periodMs = Head::MIN_PERIOD_MS;
+    out->reads = slot_.reads;
+    out->skipped = slot_.skipped;
+    out->lastStart = slot_.started;
+    rest_.stats(out + 1);
+  }
+
+private:
+  void collect(uint32_t now) {
+    head_.read(now);
+    slot_.converting = false;
+    slot_.reads++;
+    if (slot_.pending && (int32_t)(slot_.started - slot_.alignedAt) >= 0) slot_.pending = false;
+  }
+
+  Head& head_;
+  SensorSlot slot_;
+  Rest rest_;
+};
+
+// Deduces the registry type from its sensors, so the list is written once:
+//   auto sensors = makeSensorRegistry(dhtSensor, soilTempSensor);
+template <typename... Sensors>
+SensorRegistry<Sensors...> makeSensorRegistry(Sensors&... sensors) {
+  return SensorRegistry<Sensors...>(sensors...);
+}
+
+#endif
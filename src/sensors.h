@@ -0,0 +1,196 @@
+#ifndef SENSORS_H
+#define SENSORS_H
+
+#include "sensorRegistry.h"
+
+// Sensor types for SensorRegistry. Each wraps a driver by its concrete type, so the calls
+// bind at compile time: DhtArduino, SoilTempReader, Bme280Burst and ContinuousAdc on the
+// device, the Sim* classes on a host. read() only stores the driver's fixed-point values;
+// the document is built once per sample by publish() through the store* functions in
+// acquisition.cpp, the same ones readSensorData() uses.
+
+// DHT11: 1 Hz at most per the datasheet, and the Adafruit driver returns its cached
+// reading for 2 s anyway; 1 s from power-up before the first read
+template <class Driver>
+class DhtSensor {
+public:
+  enum : uint32_t { MIN_PERIOD_MS = 2000, WARMUP_MS = 1000 };
+  enum : uint16_t { FIELDS = SAMPLE_HAS_DHT11 };
+
+  explicit DhtSensor(Driver& dht) : dht_(dht), seen_(false), ok_(false), t_(0), h_(0) {}
+  static const char* name() { return "DHT11"; }
+
+  bool begin() { return dht_.begin(); }
+  void save(RtcSensorState&) const {}
+  bool resume(const RtcSensorState&) { return dht_.begin(); }
+  uint32_t start(uint32_t) { return 0; }
+
+  void read(uint32_t) {
+    METRIC_SCOPE(M_READ_DHT11);
+    ok_ = dht_.read(t_, h_);
+    seen_ = true;
+  }
+
+  void publish(JsonDocument& doc, SampleRecord& rec) {
+    if (!seen_) {
+      doc["dht11"] = "pending";
+      return;
+    }
+    storeDHT11(ok_, t_, h_, doc, rec);
+  }
+
+private:
+  Driver& dht_;
+  bool seen_, ok_;
+  int16_t t_, h_;
+};
+
+// DS18B20 probes on one bus: start() issues Convert T, read() collects it after the
+// conversion time of the configured resolution (750 ms at 12 bit)
+template <class Driver>
+class SoilTempSensor {
+public:
+  enum : uint32_t { MIN_PERIOD_MS = 1000, WARMUP_MS = 0 };
+  enum : uint16_t { FIELDS = SAMPLE_HAS_SOIL_TEMP };
+
+  SoilTempSensor(Driver& probes, uint8_t resolution) : probes_(probes), resolution_(resolution), seen_(false) {}
+  static const char* name() { return "DS18B20"; }
+
+  bool begin() { return probes_.begin(resolution_); }
+
+  void save(RtcSensorState& s) const {
+    s.probeCount = probes_.probeCount() < RTC_MAX_PROBES ? probes_.probeCount() : RTC_MAX_PROBES;
+    for (uint8_t i = 0; i < s.probeCount; i++) {
+      memcpy(s.probeAddr[i], probes_.address(i), 8);
+      s.probeResolution[i] = probes_.resolution(i);
+    }
+  }
+
+  bool resume(const RtcSensorState& s) {
+    probes_.resume(s.probeAddr, s.probeResolution, s.probeCount);
+    return s.probeCount > 0;
+  }
+
+  uint32_t start(uint32_t now) { return probes_.start(now) ? probes_.conversionMs() : 0; }
+
+  void read(uint32_t now) {
+    METRIC_SCOPE(M_READ_SOIL_TEMP);
+    if (probes_.poll(now)) seen_ = true;
+  }
+
+  // The last collected values stay valid while the next conversion runs
+  void publish(JsonDocument& doc, SampleRecord& rec) {
+    if (!seen_) {
+      doc["soilTemperature"] = "pending";
+      return;
+    }
+    storeSoilTemperature(probes_, doc, rec);
+  }
+
+private:
+  Driver& probes_;
+  uint8_t resolution_;
+  bool seen_;
+};
+
+// BME280 in forced mode: trigger, then one burst read once the measurement is done.
+// 1 Hz keeps self-heating out of the temperature, as Bosch recommends for weather monitoring.
+template <class Driver>
+class BaroSensor {
+public:
+  enum : uint32_t { MIN_PERIOD_MS = 1000, WARMUP_MS = 2 };
+  enum : uint16_t { FIELDS = SAMPLE_HAS_BME280 };
+
+  explicit BaroSensor(Driver& bme) : bme_(bme), seen_(false), ok_(false) {}
+  static const char* name() { return "BME280"; }
+
+  bool begin() { return bme_.begin(); }
+
+  void save(RtcSensorState& s) const {
+    s.bmeValid = true;
+    s.bmeCalib = bme_.calib();
+  }
+
+  bool resume(const RtcSensorState& s) {
+    if (!s.bmeValid) return bme_.begin();
+    bme_.resume(s.bmeCalib);
+    return true;
+  }
+
+  uint32_t start(uint32_t) { return bme_.trigger() ? bme_.measurementMs() : 0; }
+
+  void read(uint32_t) {
+    METRIC_SCOPE(M_READ_BME280);
+    ok_ = bme_.read(r_);
+    seen_ = true;
+  }
+
+  void publish(JsonDocument& doc, SampleRecord& rec) {
+    if (!seen_) {
+      doc["bme280"] = "pending";
+      return;
+    }
+    storeBME280(ok_ ? &r_ : nullptr, doc, rec);
+  }
+
+private:
+  Driver& bme_;
+  bool seen_, ok_;
+  Bme280Reading r_;
+};
+
+// Analog soil-moisture probe: each read() is one oversampled burst; publish() reports the
+// mean of the bursts since the last sample, 20 of them at the default sample interval
+template <class Driver>
+class SoilMoistureSensor {
+public:
+  enum : uint32_t { MIN_PERIOD_MS = 100, WARMUP_MS = 0 };
+  enum : uint16_t { FIELDS = SAMPLE_HAS_SOIL_MOISTURE };
+
+  SoilMoistureSensor(Driver& adc, const MoistureCal* cal) : adc_(adc), cal_(cal), seen_(false) { clear(); }
+  static const char* name() { return "soil moisture"; }
+
+  bool begin() { return adc_.begin(); }
+  void save(RtcSensorState&) const {}
+  bool resume(const RtcSensorState&) { return adc_.begin(); }   // the characterization is a few eFuse reads
+  uint32_t start(uint32_t) { return 0; }
+
+  void read(uint32_t) {
+    METRIC_SCOPE(M_READ_SOIL_MOISTURE);
+    seen_ = true;
+    int raw = adc_.read();
+    if (raw < 0) return;
+    int mv = adc_.millivolts();
+    rawSum_ += raw;
+    n_++;
+    if (mv >= 0) {
+      mvSum_ += mv;
+      mvN_++;
+    }
+  }
+
+  void publish(JsonDocument& doc, SampleRecord& rec) {
+    if (!seen_) {
+      doc["soilMoisture"] = "pending";
+      return;
+    }
+    int raw = n_ ? (int)((rawSum_ + n_ / 2) / n_) : -1;
+    int mv = mvN_ ? (int)((mvSum_ + mvN_ / 2) / mvN_) : -1;
+    storeSoilMoisture(raw, mv, cal_, doc, rec);
+    clear();
+  }
+
+private:
+  void clear() {
+    rawSum_ = mvSum_ = 0;
+    n_ = mvN_ = 0;
+  }
+
+  Driver& adc_;
+  const MoistureCal* cal_;
+  bool seen_;
+  uint32_t rawSum_, mvSum_;
+  uint16_t n_, mvN_;
+};
+
+#endif
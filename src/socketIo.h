@@ -0,0 +1,78 @@
+#ifndef SOCKET_IO_H
+#define SOCKET_IO_H
+
+#ifndef ARDUINO
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/socket.h>
+
+// Blocking socket helpers shared by the host-side HTTP client and the mock RTDB server
+
+inline bool sendAll(int fd, const void* buf, size_t len) {
+  const uint8_t* p = (const uint8_t*)buf;
+  while (len > 0) {
+    ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return false;
+    p += n;
+    len -= (size_t)n;
+  }
+  return true;
+}
+
+// Buffered reader with line and exact-length reads, counting every byte taken off the socket
+class SocketReader {
+public:
+  explicit SocketReader(int fd) : fd_(fd), pos_(0), len_(0), total_(0) {}
+
+  // Reads up to '\n', strips "\r\n"; false on EOF/timeout or an over-long line
+  bool readLine(char* out, size_t max) {
+    size_t n = 0;
+    for (;;) {
+      if (pos_ == len_ && !fill()) return false;
+      char c = (char)buf_[pos_++];
+      if (c == '\n') break;
+      if (n + 1 >= max) return false;
+      out[n++] = c;
+    }
+    if (n > 0 && out[n - 1] == '\r') n--;
+    out[n] = '\0';
+    return true;
+  }
+
+  // Discards len bytes
+  bool skip(size_t len) {
+    while (len > 0) {
+      if (pos_ == len_ && !fill()) return false;
+      size_t k = len_ - pos_ < len ? len_ - pos_ : len;
+      pos_ += k;
+      len -= k;
+    }
+    return true;
+  }
+
+  uint64_t total() const { return total_; }
+
+private:
+  bool fill() {
+    ssize_t n;
+    do {
+      n = recv(fd_, buf_, sizeof(buf_), 0);
+    } while (n < 0 && errno == EINTR);
+    if (n <= 0) return false;
+    pos_ = 0;
+    len_ = (size_t)n;
+    total_ += (uint64_t)n;
+    return true;
+  }
+
+  int fd_;
+  uint8_t buf_[2048];
+  size_t pos_, len_;
+  uint64_t total_;
+};
+#endif
+
+#endif
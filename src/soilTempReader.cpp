@@ -0,0 +1,80 @@
+#include "soilTempReader.h"
+#include <string.h>
+
+SoilTempReader::SoilTempReader(DallasTemperature& bus)
+  : bus_(bus), state_(IDLE), probeCount_(0), startedAt_(0), sampledAt_(0) {
+  for (uint8_t i = 0; i < SOIL_TEMP_MAX_PROBES; i++) {
+    resolution_[i] = 12;
+    centi_[i] = SOIL_TEMP_DISCONNECTED;
+    valid_[i] = false;
+  }
+}
+
+bool SoilTempReader::begin(uint8_t resolution) {
+  bus_.begin();
+  // Conversion timing is handled here, so the library must never block on it
+  bus_.setWaitForConversion(false);
+
+  // Cache ROM addresses once; by-index lookups would repeat the bus search on every read
+  probeCount_ = 0;
+  uint8_t found = bus_.getDeviceCount();
+  for (uint8_t i = 0; i < found && probeCount_ < SOIL_TEMP_MAX_PROBES; i++) {
+    if (bus_.getAddress(addr_[probeCount_], i)) probeCount_++;
+  }
+  for (uint8_t i = 0; i < probeCount_; i++) setResolution(i, resolution);
+  state_ = IDLE;
+  return probeCount_ > 0;
+}
+
+void SoilTempReader::resume(const uint8_t (*addr)[8], const uint8_t* resolution, uint8_t count) {
+  bus_.setWaitForConversion(false);
+  probeCount_ = count < SOIL_TEMP_MAX_PROBES ? count : SOIL_TEMP_MAX_PROBES;
+  for (uint8_t i = 0; i < probeCount_; i++) {
+    memcpy(addr_[i], addr[i], sizeof(DeviceAddress));
+    resolution_[i] = resolution[i];   // DallasTemperature stored it in the probe's EEPROM
+  }
+  state_ = IDLE;
+}
+
+bool SoilTempReader::setResolution(uint8_t probe, uint8_t bits) {
+  if (probe >= probeCount_ || bits < 9 || bits > 12) return false;
+  if (!bus_.setResolution(addr_[probe], bits)) return false;
+  resolution_[probe] = bits;
+  return true;
+}
+
+uint8_t SoilTempReader::resolution(uint8_t probe) const {
+  return probe < probeCount_ ? resolution_[probe] : 0;
+}
+
+// All probes convert in parallel, so the bus is ready after the slowest one
+uint16_t SoilTempReader::conversionMs() const {
+  uint8_t bits = 9;
+  for (uint8_t i = 0; i < probeCount_; i++) {
+    if (resolution_[i] > bits) bits = resolution_[i];
+  }
+  return conversionMsFor(bits);
+}
+
+bool SoilTempReader::start(uint32_t now) {
+  if (state_ == CONVERTING) return false;
+  bus_.requestTemperatures();
+  startedAt_ = now;
+  state_ = CONVERTING;
+  return true;
+}
+
+bool SoilTempReader::poll(uint32_t now) {
+  if (state_ != CONVERTING) return false;
+  if (now - startedAt_ < conversionMs()) return false;
+
+  for (uint8_t i = 0; i < probeCount_; i++) {
+    // Raw scratchpad value in 1/128 degC, straight to fixed point without a float
+    int32_t raw = bus_.getTemp(addr_[i]);
+    valid_[i] = raw != DEVICE_DISCONNECTED_RAW;
+    centi_[i] = valid_[i] ? (int16_t)((raw * 100 + (raw >= 0 ? 64 : -64)) / 128) : SOIL_TEMP_DISCONNECTED;
+  }
+  sampledAt_ = now;
+  state_ = READY;
+  return true;
+}
@@ -0,0 +1,53 @@
+#ifndef SOIL_TEMP_READER_H
+#define SOIL_TEMP_READER_H
+
+#include <stdint.h>
+#include <DallasTemperature.h>
+#include "hal.h"
+
+#define SOIL_TEMP_MAX_PROBES 4
+#define SOIL_TEMP_DISCONNECTED -12700   // DEVICE_DISCONNECTED_C in 0.01 degC
+
+// Non-blocking DS18B20 reader for one or more probes on a single OneWire bus.
+// ROM addresses are enumerated once in begin(), so later reads never re-walk the search.
+// start() issues one Convert T to every probe on the bus and returns immediately;
+// poll() reads each probe's scratchpad by address exactly once, on a later tick once
+// the conversion time for the configured resolution has passed (94/188/375/750 ms for 9/10/11/12 bit).
+class SoilTempReader final : public SoilTempInput {
+public:
+  explicit SoilTempReader(DallasTemperature& bus);
+
+  bool begin(uint8_t resolution = 12);   // false if no probe answered
+  // Warm start after deep sleep: reuse the addresses and resolutions found by begin(),
+  // skipping the bus search and the scratchpad/EEPROM writes
+  void resume(const uint8_t (*addr)[8], const uint8_t* resolution, uint8_t count);
+  bool setResolution(uint8_t probe, uint8_t bits);  // 9..12 bit, per probe
+  uint8_t resolution(uint8_t probe) const;
+
+  bool start(uint32_t now) override;   // false if a conversion is already running
+  bool poll(uint32_t now) override;    // true when a fresh reading has been collected
+
+  State state() const override { return state_; }
+  uint8_t probeCount() const override { return probeCount_; }
+  uint16_t conversionMs() const override;
+
+  bool valid(uint8_t probe) const override { return probe < probeCount_ && valid_[probe]; }
+  int16_t centiCelsius(uint8_t probe) const override { return probe < probeCount_ ? centi_[probe] : SOIL_TEMP_DISCONNECTED; }
+  const uint8_t* address(uint8_t probe) const override { return addr_[probe]; }
+  uint32_t sampledAt() const { return sampledAt_; }
+
+  static uint16_t conversionMsFor(uint8_t bits) { return 750 >> (12 - bits); }
+
+private:
+  DallasTemperature& bus_;
+  State state_;
+  uint8_t probeCount_;
+  DeviceAddress addr_[SOIL_TEMP_MAX_PROBES];
+  uint8_t resolution_[SOIL_TEMP_MAX_PROBES];
+  int16_t centi_[SOIL_TEMP_MAX_PROBES];
+  bool valid_[SOIL_TEMP_MAX_PROBES];
+  uint32_t startedAt_;
+  uint32_t sampledAt_;
+};
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+// Fixed-capacity lock-free queue for exactly one producer task and one consumer task.
+// head_ is written only by the producer, tail_ only by the consumer; acquire/release on
+// the indices publishes the slot contents, so no lock is ever taken and neither side can
+// block the other. Works across the two ESP32 cores and between host threads alike.
+//
+// Drop policy: when full, push() rejects the new item and counts it. Items already
+// queued are older and still in order, so the consumer never sees a gap in the middle
+// of a run. The producer can read size() against highWater() to apply backpressure
+// before that happens.
+template <typename T, size_t N>
+class SpscQueue {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "capacity must be a power of two");
+
+public:
+  SpscQueue() : head_(0), dropped_(0), highWater_(0), tail_(0) {}
+
+  // Producer only
+  bool push(const T& item) {
+    uint32_t head = head_.load(std::memory_order_relaxed);
+    uint32_t used = head - tail_.load(std::memory_order_acquire);
+    if (used >= N) {
+      dropped_.store(dropped_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      return false;
+    }
+    slots_[head & (N - 1)] = item;
+    head_.store(head + 1, std::memory_order_release);
+    if (used + 1 > highWater_.load(std::memory_order_relaxed)) {
+      highWater_.store(used + 1, std::memory_order_relaxed);
+    }
+    return true;
+  }
+
+  // Consumer only
+  bool pop(T& out) {
+    uint32_t tail = tail_.load(std::memory_order_relaxed);
+    if (head_.load(std::memory_order_acquire) == tail) return false;
+    out = slots_[tail & (N - 1)];
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer only: pops up to max items in FIFO order
+  size_t popMany(T* out, size_t max) {
+    size_t n = 0;
+    while (n < max && pop(out[n])) n++;
+    return n;
+  }
+
+  // Either side; a snapshot that may be stale by the time it is used
+  size_t size() const {
+    uint32_t tail = tail_.load(std::memory_order_acquire);   // tail first, so head >= tail
+    return head_.load(std::memory_order_acquire) - tail;
+  }
+  bool empty() const { return size() == 0; }
+  static size_t capacity() { return N; }
+  uint32_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+  uint32_t highWater() const { return highWater_.load(std::memory_order_relaxed); }
+
+private:
+  T slots_[N];
+  // Producer-written and consumer-written state on separate cache lines (ESP32 has none, hosts do)
+  alignas(64) std::atomic<uint32_t> head_;
+  std::atomic<uint32_t> dropped_;
+  std::atomic<uint32_t> highWater_;
+  alignas(64) std::atomic<uint32_t> tail_;
+};
+
+#endif
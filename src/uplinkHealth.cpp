@@ -0,0 +1,117 @@
+#include "uplinkHealth.h"
+#include "logger.h"
+#include <ctype.h>
+#include <stdlib.h>
+
+static bool containsNoCase(const char* s, const char* word) {
+  for (; *s; s++) {
+    const char* a = s;
+    const char* b = word;
+    while (*a && *b && tolower((unsigned char)*a) == *b) {
+      a++;
+      b++;
+    }
+    if (!*b) return true;
+  }
+  return false;
+}
+
+// Firebase_ESP_Client reasons (fbdo.errorReason()), plus RtdbStream/HttpUplink's own.
+// Anything unrecognised is treated as a network problem.
+UplinkError classifyUplinkError(const char* reason) {
+  if (!reason) return UPLINK_ERR_NETWORK;
+  static const char* const rate[] = { "too many", "429", "quota", "rate limit" };
+  static const char* const network[] = { "timed out", "timeout", "connection", "not connected",
+                                         "send", "no http server" };
+  static const char* const auth[] = { "permission denied", "unauthorized", "401", "forbidden", "403",
+                                      "token", "auth" };
+  static const char* const request[] = { "bad request", "400", "not found", "404", "precondition",
+                                         "412", "too large", "413", "invalid data" };
+  static const char* const server[] = { "server error", "internal", "unavailable", "bad gateway",
+                                        "insufficient storage", "500", "502", "503", "504" };
+  for (const char* w : rate) if (containsNoCase(reason, w)) return UPLINK_ERR_RATE;
+  for (const char* w : network) if (containsNoCase(reason, w)) return UPLINK_ERR_NETWORK;
+  for (const char* w : auth) if (containsNoCase(reason, w)) return UPLINK_ERR_AUTH;
+  for (const char* w : request) if (containsNoCase(reason, w)) return UPLINK_ERR_REQUEST;
+  for (const char* w : server) if (containsNoCase(reason, w)) return UPLINK_ERR_SERVER;
+  return UPLINK_ERR_NETWORK;
+}
+
+UplinkHealth::UplinkHealth(uint32_t seed)
+  : state_(LINK_CONNECTED), streak_(0), retryAt_(0), rng_(seed ? seed : 1), reauth_(false) {}
+
+const char* UplinkHealth::stateName(LinkState s) {
+  switch (s) {
+    case LINK_CONNECTED: return "connected";
+    case LINK_DEGRADED: return "degraded";
+    default: return "open";
+  }
+}
+
+bool UplinkHealth::allow(uint32_t now) const {
+  if (state_ == LINK_CONNECTED) return true;
+  if (state_ == LINK_OPEN) return false;
+  return (int32_t)(now - retryAt_) >= 0;
+}
+
+bool UplinkHealth::probeDue(uint32_t now) const {
+  return state_ == LINK_OPEN && (int32_t)(now - retryAt_) >= 0;
+}
+
+bool UplinkHealth::takeReauth() {
+  bool r = reauth_;
+  reauth_ = false;
+  return r;
+}
+
+void UplinkHealth::enter(LinkState s) {
+  if (s == LINK_OPEN && state_ != LINK_OPEN) opens++;
+  if (s != state_) LOG_W("Uplink %s -> %s\n", stateName(state_), stateName(s));
+  state_ = s;
+}
+
+void UplinkHealth::success(uint32_t now) {
+  (void)now;
+  streak_ = 0;
+  enter(LINK_CONNECTED);
+}
+
+// Full jitter over [d/2, d] with d = min * 2^(streak-1), capped: nodes that lost the backend
+// together do not come back in lockstep
+uint32_t UplinkHealth::backoff(uint32_t floor) {
+  uint32_t d = HEALTH_BACKOFF_MIN;
+  for (uint32_t i = 1; i < streak_ && d < HEALTH_BACKOFF_MAX; i++) d *= 2;
+  if (d > HEALTH_BACKOFF_MAX) d = HEALTH_BACKOFF_MAX;
+  rng_ ^= rng_ << 13;             // xorshift32
+  rng_ ^= rng_ >> 17;
+  rng_ ^= rng_ << 5;
+  d = d / 2 + rng_ % (d / 2 + 1);
+  return d < floor ? floor : d;
+}
+
+UplinkError UplinkHealth::failure(const char* reason, uint32_t now) {
+  UplinkError err = classifyUplinkError(reason);
+  if (err == UPLINK_ERR_REQUEST) {
+    requestErrors++;
+    return err;
+  }
+  failures++;
+  streak_++;
+  if (err == UPLINK_ERR_AUTH) reauth_ = true;
+  retryAt_ = now + backoff(err == UPLINK_ERR_RATE ? HEALTH_RATE_BACKOFF : 0);
+  enter(streak_ >= HEALTH_OPEN_AFTER ? LINK_OPEN : LINK_DEGRADED);
+  return err;
+}
+
+UplinkStatus GuardedUplink::update(const char* path, JsonDocument& doc) {
+  uint32_t now = clock_();
+  refused_ = !health_.allow(now);
+  if (refused_) {
+    health_.shortCircuits++;
+    return UPLINK_FAILED;
+  }
+  UplinkStatus status = inner_.update(path, doc);
+  if (status == UPLINK_OK) health_.success(now);
+  else if (status == UPLINK_FAILED) health_.failure(inner_.errorReason(), clock_());
+  return status;
+}
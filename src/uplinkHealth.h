@@ -0,0 +1,92 @@
+#ifndef UPLINK_HEALTH_H
+#define UPLINK_HEALTH_H
+
+#include <stdint.h>
+#include "hal.h"
+#include "scheduler.h"
+
+// Uplink health: connected -> degraded on a failure, degraded -> open after a run of
+// failures, back to connected on the first success. Degraded retries real uploads after a
+// jittered exponential backoff; an open circuit sends no uploads at all, only a tiny probe
+// each time the backoff expires. Samples keep flowing into the offline log meanwhile, so
+// sampling never waits on a dead backend.
+
+#define HEALTH_BACKOFF_MIN 2000       // First retry delay, ms
+#define HEALTH_BACKOFF_MAX 120000     // Cap, ms; also the worst-case delay in noticing recovery
+#define HEALTH_OPEN_AFTER 4           // Consecutive failures that open the circuit
+#define HEALTH_RATE_BACKOFF 60000     // Floor after the backend asks us to slow down
+
+enum LinkState {
+  LINK_CONNECTED,
+  LINK_DEGRADED,
+  LINK_OPEN,
+};
+
+// What a failure says about the link, from Uplink::errorReason()
+enum UplinkError {
+  UPLINK_ERR_NETWORK,   // no route, refused, lost or timed out: back off
+  UPLINK_ERR_SERVER,    // 5xx: back off
+  UPLINK_ERR_RATE,      // 429 / quota: back off at least HEALTH_RATE_BACKOFF
+  UPLINK_ERR_AUTH,      // 401/403 or token trouble: back off and refresh the token
+  UPLINK_ERR_REQUEST,   // 400/404/412/413: the request is wrong, the link is fine
+};
+
+UplinkError classifyUplinkError(const char* reason);
+
+class UplinkHealth {
+public:
+  explicit UplinkHealth(uint32_t seed = 1);
+
+  // Real uploads: always while connected, once the backoff expires while degraded, never when open
+  bool allow(uint32_t now) const;
+  // Open circuit only: the backoff expired, send a probe
+  bool probeDue(uint32_t now) const;
+  void success(uint32_t now);
+  UplinkError failure(const char* reason, uint32_t now);
+
+  // Set by an auth failure; the caller refreshes the token once and clears it
+  bool takeReauth();
+
+  LinkState state() const { return state_; }
+  uint32_t retryAt() const { return retryAt_; }
+  uint32_t streak() const { return streak_; }
+  static const char* stateName(LinkState s);
+
+  uint32_t failures = 0;
+  uint32_t requestErrors = 0;   // UPLINK_ERR_REQUEST, not held against the link
+  uint32_t opens = 0;
+  uint32_t probes = 0;
+  uint32_t shortCircuits = 0;   // requests refused by GuardedUplink
+
+private:
+  uint32_t backoff(uint32_t floor);
+  void enter(LinkState s);
+
+  LinkState state_;
+  uint32_t streak_;             // consecutive failures
+  uint32_t retryAt_;
+  uint32_t rng_;
+  bool reauth_;
+};
+
+// Uplink decorator that reports every result to an UplinkHealth and refuses requests the
+// health state does not allow, so a batch cycle stops at the first failure
+class GuardedUplink : public Uplink {
+public:
+  GuardedUplink(Uplink& inner, UplinkHealth& health, ClockFn clock)
+    : inner_(inner), health_(health), clock_(clock), refused_(false) {}
+  UplinkStatus update(const char* path, JsonDocument& doc) override;
+  const char* errorReason() const override { return refused_ ? "backing off" : inner_.errorReason(); }
+
+  Uplink& inner() { return inner_; }
+  UplinkHealth& health() { return health_; }
+  uint32_t now() const { return clock_(); }
+
+private:
+  Uplink& inner_;
+  UplinkHealth& health_;
+  ClockFn clock_;
+  bool refused_;
+};
+
+#endif
@@ -0,0 +1,371 @@
+#include "upload.h"
+#include "nodeConfig.h"
+#include "rtdbPaths.h"
+#include "metrics.h"
+#include "logger.h"
+#include "sampleCodec.h"
+#include <string.h>
+
+static uint8_t uploadArenaBuf[UPLOAD_ARENA_SIZE];
+ArenaAllocator uploadArena(uploadArenaBuf, sizeof(uploadArenaBuf));
+static KeyedPath<sizeof("lastReadings/")> readingKey("lastReadings/");   // relative to PATH_BASE
+static SampleRecord backlog[SAMPLE_LOG_BATCH];
+static SampleRecord queued[SAMPLE_QUEUE_DEPTH];
+#ifdef UPLOAD_PACKED_BATCHES
+static KeyedPath<sizeof("packed/")> packedKey("packed/");
+static char packedBatch[SAMPLE_DELTA_CHARS(SAMPLE_LOG_BATCH > SAMPLE_QUEUE_DEPTH ? SAMPLE_LOG_BATCH : SAMPLE_QUEUE_DEPTH)];
+#endif
+static KeyedPath<sizeof("windows/")> windowKey("windows/");
+static WindowSummary pendingWindows[AGG_PENDING_WINDOWS];   // closed, not yet acknowledged or stored
+static WindowSummary storedWindows[WINDOW_LOG_BATCH];
+static size_t pendingWindowCount = 0;
+uint32_t windowsDropped = 0;
+static uint8_t liveArenaBuf[2048];
+static ArenaAllocator liveArena(liveArenaBuf, sizeof(liveArenaBuf));   // newest queued sample as a document
+uint32_t liveMisses = 0;
+
+const char* const scalarNodes[SCALAR_COUNT] = {
+  "Temperature", "Humidity", "HeatIndex", "SoilTemperature", "SoilMoisture",
+};
+static const ScalarFilter::Rule scalarRules[SCALAR_COUNT] = {
+  { DEADBAND_TEMPERATURE, HEARTBEAT_AIR },
+  { DEADBAND_HUMIDITY, HEARTBEAT_AIR },
+  { DEADBAND_HEAT_INDEX, HEARTBEAT_AIR },
+  { DEADBAND_SOIL_TEMPERATURE, HEARTBEAT_SOIL },
+  { DEADBAND_SOIL_MOISTURE, HEARTBEAT_SOIL },
+};
+ScalarFilter scalarFilter(scalarRules);
+
+static void addScalar(JsonDocument& update, ScalarNode node, float value, uint32_t now) {
+  if (scalarFilter.offer(node, value, now)) update[scalarNodes[node]] = value;
+}
+
+// 'latest' and the scalar nodes for a sample document; scalars only when outside their deadband
+static void addLiveNodes(JsonDocument& update, JsonDocument& doc, uint32_t now) {
+  update["lastReadings/latest"] = doc;
+
+  // ---- Scalar fields (if present in JSON) ----
+  JsonObject dht = doc["dht11"];
+  if (dht.containsKey("temperature")) addScalar(update, SCALAR_TEMPERATURE, dht["temperature"].as<float>(), now);
+  if (dht.containsKey("humidity")) addScalar(update, SCALAR_HUMIDITY, dht["humidity"].as<float>(), now);
+  if (dht.containsKey("heatIndex")) addScalar(update, SCALAR_HEAT_INDEX, dht["heatIndex"].as<float>(), now);
+
+  JsonObject st = doc["soilTemperature"];
+  if (st.containsKey("celsius")) addScalar(update, SCALAR_SOIL_TEMPERATURE, st["celsius"].as<float>(), now);
+
+  JsonObject sm = doc["soilMoisture"];
+  if (sm.containsKey("percentage")) addScalar(update, SCALAR_SOIL_MOISTURE, sm["percentage"].as<float>(), now);
+}
+
+// Keys of the fan-out document are paths relative to PATH_BASE, so RTDB applies
+// every write atomically in one round trip: 'latest' and the scalar nodes can never
+// disagree, and existing lastReadings/<ts> entries are untouched. The entry is keyed by
+// the sample's own timestamp, never the upload time, so a retry rewrites the same key.
+bool uploadSensorDataFanout(Uplink& uplink, JsonDocument& doc, uint32_t now) {
+  LOG_D("\n==========================================\n");
+  LOG_D("Uploading sensor JSON to Firebase RTDB (fan-out)...\n");
+
+  doc["uploaded_at_ms"] = now;
+
+  // The fan-out document lives in the upload arena; nothing here touches the heap
+  uploadArena.reset();
+  JsonDocument update(&uploadArena);
+  update[readingKey.with(doc["timestamp"].as<uint64_t>())] = doc;
+  addLiveNodes(update, doc, now);
+
+  UplinkStatus status = UPLINK_TOO_LARGE;
+  if (!update.overflowed()) {
+    METRIC_SCOPE(M_RTDB_FANOUT);
+    status = uplink.update(PATH_BASE, update);
+  }
+  if (status == UPLINK_OK) scalarFilter.commit();
+  else scalarFilter.abandon();
+  if (status == UPLINK_OK) {
+    LOG_I("✓ %u nodes updated under: %s\n", (unsigned)update.size(), PATH_BASE);
+  } else if (status == UPLINK_TOO_LARGE) {
+    LOG_E("✗ Fan-out document larger than upload buffers\n");
+  } else {
+    LOG_E("✗ Fan-out upload failed: %s\n", uplink.errorReason());
+  }
+
+  LOG_D("==========================================\n");
+  return status == UPLINK_OK;
+}
+
+#ifdef UPLOAD_PACKED_BATCHES
+// Stored or queued samples as one delta batch under packed/<first ts> (sampleCodec.h);
+// packedBatchToJson turns it back into the lastReadings/<ts> entries the other path writes
+static UplinkStatus uploadRecords(Uplink& uplink, const SampleRecord* recs, size_t n) {
+  uploadArena.reset();
+  JsonDocument update(&uploadArena);
+  if (!encodeDeltaBatch(recs, n, packedBatch, sizeof(packedBatch))) return UPLINK_TOO_LARGE;
+  update[packedKey.with(recs[0].timestamp)] = (const char*)packedBatch;
+  if (update.overflowed()) return UPLINK_TOO_LARGE;
+  METRIC_SCOPE(M_RTDB_BATCH);
+  return uplink.update(PATH_BASE, update);
+}
+#else
+// Stored or queued samples as lastReadings/<ts> entries of one multi-path update
+static UplinkStatus uploadRecords(Uplink& uplink, const SampleRecord* recs, size_t n) {
+  uploadArena.reset();
+  JsonDocument update(&uploadArena);
+  for (size_t i = 0; i < n; i++) {
+    sampleToJson(recs[i], update[readingKey.with(recs[i].timestamp)].to<JsonObject>());
+  }
+  if (update.overflowed()) return UPLINK_TOO_LARGE;
+  METRIC_SCOPE(M_RTDB_BATCH);
+  return uplink.update(PATH_BASE, update);
+}
+#endif
+
+// The cursor only advances once the whole batch is acknowledged
+bool uploadBacklog(Uplink& uplink, SampleLog& log) {
+  // Halve the batch until it fits the upload buffers
+  for (size_t max = SAMPLE_LOG_BATCH; ; max /= 2) {
+    size_t n = log.peek(backlog, max);
+    if (n == 0) return true;
+
+    UplinkStatus status = uploadRecords(uplink, backlog, n);
+    if (status == UPLINK_OK) {
+      log.commit();
+      LOG_I("✓ Replayed %u stored samples, %u pending\n", (unsigned)n, (unsigned)log.pending());
+      return true;
+    }
+    if (status == UPLINK_FAILED) {
+      LOG_E("✗ Backlog upload failed: %s\n", uplink.errorReason());
+      return false;
+    }
+    if (max == 1) {
+      LOG_E("✗ Backlog record larger than upload buffers\n");
+      return false;
+    }
+  }
+}
+
+bool uploadCycle(Uplink* uplink, SampleLog* log, JsonDocument& doc, bool fresh, uint32_t now) {
+  // Drain the backlog oldest first, one batch per tick
+  if (uplink && log && log->pending() > 0) uploadBacklog(*uplink, *log);
+  if (!fresh) return false;
+
+  bool ok = uplink && uploadSensorDataFanout(*uplink, doc, now);
+  if (!ok && log) {
+    SampleRecord rec;
+    sampleFromJson(doc, rec);
+    if (log->append(rec)) LOG_W("Sample stored offline (%u pending)\n", (unsigned)log->pending());
+  }
+  return ok;
+}
+
+// The newest sample as a document: in full from live while it still holds it, else rebuilt
+// from the record, which lacks the probes, altitude, millivolts and sensor errors
+static void liveDocument(LiveSample* live, const SampleRecord& rec, JsonDocument& doc) {
+  if (live && live->take(rec.timestamp, doc) && !doc.overflowed()) return;
+  if (live) {
+    liveMisses++;
+    LOG_W("⚠ Sample %llu not in the live slot, uploading its record fields only (%u times)\n",
+          (unsigned long long)rec.timestamp, (unsigned)liveMisses);
+  }
+  sampleToJson(rec, doc.to<JsonObject>());
+}
+
+static void storeOffline(SampleLog* log, const SampleRecord* recs, size_t n) {
+  if (!log) return;
+  size_t stored = 0;
+  for (size_t i = 0; i < n; i++) stored += log->append(recs[i]);
+  if (stored) LOG_W("%u samples stored offline (%u pending)\n", (unsigned)stored, (unsigned)log->pending());
+}
+
+size_t uploadQueue(Uplink* uplink, SampleLog* log, SampleQueue& queue, uint32_t now, LiveSample* live) {
+  if (uplink && log && log->pending() > 0) uploadBacklog(*uplink, *log);
+
+  size_t n = queue.popMany(queued, SAMPLE_QUEUE_DEPTH);
+  return n ? uploadBatch(uplink, log, queued, n, now, live) : 0;
+}
+
+size_t uploadBatch(Uplink* uplink, SampleLog* log, const SampleRecord* recs, size_t n, uint32_t now,
+                   LiveSample* live) {
+  if (!uplink) {
+    storeOffline(log, recs, n);
+    return 0;
+  }
+
+  // Samples that piled up go out together as plain lastReadings entries;
+  // only the newest one gets the full fan-out to 'latest' and the scalar nodes
+  size_t older = n - 1;
+  size_t delivered = 0;
+  if (older > 0) {
+    UplinkStatus status = uploadRecords(*uplink, recs, older);
+    if (status == UPLINK_OK) {
+      LOG_I("✓ Caught up %u batched samples\n", (unsigned)older);
+      delivered = older;
+    } else {
+      LOG_E("✗ Batched samples upload failed: %s\n",
+             status == UPLINK_TOO_LARGE ? "larger than upload buffers" : uplink->errorReason());
+      storeOffline(log, recs, older);
+    }
+  }
+
+  liveArena.reset();
+  JsonDocument doc(&liveArena);
+  liveDocument(live, recs[older], doc);
+  if (uploadSensorDataFanout(*uplink, doc, now)) return delivered + 1;
+  storeOffline(log, &recs[older], 1);
+  return delivered;
+}
+
+// Summaries as windows/<start> entries of one update, with 'latest' and the scalar nodes
+// from doc when there is one
+static UplinkStatus uploadWindowList(Uplink& uplink, const WindowSummary* windows, size_t n, JsonDocument* doc,
+                                     uint32_t now) {
+  uploadArena.reset();
+  JsonDocument update(&uploadArena);
+  for (size_t i = 0; i < n; i++) {
+    windowToJson(windows[i], update[windowKey.with(windows[i].start)].to<JsonObject>());
+  }
+  if (doc) addLiveNodes(update, *doc, now);
+
+  UplinkStatus status = UPLINK_TOO_LARGE;
+  if (!update.overflowed()) {
+    METRIC_SCOPE(doc ? M_RTDB_FANOUT : M_RTDB_BATCH);
+    status = uplink.update(PATH_BASE, update);
+  }
+  if (doc && status == UPLINK_OK) scalarFilter.commit();
+  else if (doc) scalarFilter.abandon();
+  return status;
+}
+
+// Stored summaries oldest first; as uploadBacklog, the batch is halved until it fits and
+// the cursor only advances once it is acknowledged
+static bool uploadWindowBacklog(Uplink& uplink, WindowLog& winLog) {
+  for (size_t max = WINDOW_LOG_BATCH; ; max /= 2) {
+    size_t n = winLog.peek(storedWindows, max);
+    if (n == 0) return true;
+
+    UplinkStatus status = uploadWindowList(uplink, storedWindows, n, nullptr, 0);
+    if (status == UPLINK_OK) {
+      winLog.commit();
+      LOG_I("✓ Replayed %u stored window summaries, %u pending\n", (unsigned)n, (unsigned)winLog.pending());
+      return true;
+    }
+    if (status == UPLINK_FAILED) {
+      LOG_E("✗ Window backlog upload failed: %s\n", uplink.errorReason());
+      return false;
+    }
+    if (max == 1) {
+      LOG_E("✗ Stored window summary larger than upload buffers\n");
+      return false;
+    }
+  }
+}
+
+size_t uploadWindows(Uplink* uplink, WindowLog* winLog, WindowAggregator& agg, const SampleRecord* recs, size_t n,
+                     uint32_t now, LiveSample* live) {
+  for (size_t i = 0; i < n; i++) {
+    if (!agg.add(recs[i])) continue;
+    if (pendingWindowCount == AGG_PENDING_WINDOWS) {
+      memmove(pendingWindows, pendingWindows + 1, sizeof(pendingWindows) - sizeof(pendingWindows[0]));
+      pendingWindowCount--;
+      windowsDropped++;
+    }
+    pendingWindows[pendingWindowCount++] = agg.closed();
+  }
+  if (uplink && winLog && winLog->pending() > 0) uploadWindowBacklog(*uplink, *winLog);
+  if (pendingWindowCount == 0) return 0;
+
+  size_t sent = 0;
+  if (uplink) {
+    // The live nodes come from the newest closed window's last sample
+    liveArena.reset();
+    JsonDocument doc(&liveArena);
+    liveDocument(live, pendingWindows[pendingWindowCount - 1].last, doc);
+
+    // Halve the summaries per update until they fit; the live nodes go with the newest
+    UplinkStatus status = UPLINK_OK;
+    for (size_t max = pendingWindowCount; sent < pendingWindowCount;) {
+      size_t k = pendingWindowCount - sent < max ? pendingWindowCount - sent : max;
+      bool newest = sent + k == pendingWindowCount;
+      status = uploadWindowList(*uplink, pendingWindows + sent, k, newest ? &doc : nullptr, now);
+      if (status == UPLINK_OK) {
+        sent += k;
+      } else if (status == UPLINK_TOO_LARGE && k > 1) {
+        max = k / 2;
+      } else {
+        break;
+      }
+    }
+    if (sent) LOG_I("✓ %u window summaries uploaded under: %swindows\n", (unsigned)sent, PATH_BASE);
+    if (status != UPLINK_OK) {
+      LOG_E("✗ Window summary upload failed: %s, %u waiting\n",
+             status == UPLINK_TOO_LARGE ? "larger than upload buffers" : uplink->errorReason(),
+             (unsigned)(pendingWindowCount - sent));
+    }
+  }
+
+  // The rest waits on flash, in memory only if it cannot be stored
+  size_t done = sent;
+  if (winLog) {
+    while (done < pendingWindowCount && winLog->append(pendingWindows[done])) done++;
+    if (done > sent) LOG_W("%u window summaries stored offline (%u pending)\n", (unsigned)(done - sent),
+                           (unsigned)winLog->pending());
+  }
+  pendingWindowCount -= done;
+  memmove(pendingWindows, pendingWindows + done, pendingWindowCount * sizeof(pendingWindows[0]));
+  return sent;
+}
+
+size_t uploadQueueWindows(Uplink* uplink, SampleLog* log, WindowLog* winLog, SampleQueue& queue,
+                          WindowAggregator& agg, bool raw, uint32_t now, LiveSample* live) {
+  // Whatever raw mode or an older run left in the log still goes up, summaries or not
+  if (uplink && log && log->pending() > 0) uploadBacklog(*uplink, *log);
+  size_t n = queue.popMany(queued, SAMPLE_QUEUE_DEPTH);
+  size_t sent = uploadWindows(uplink, winLog, agg, queued, n, now, live);
+  if (raw && n) uploadBatch(uplink, log, queued, n, now, live);
+  return sent;
+}
+
+bool uploadProbe(Uplink& uplink, uint32_t now) {
+  uploadArena.reset();
+  JsonDocument update(&uploadArena);
+  update["status/seen_ms"] = now;
+  return uplink.update(PATH_BASE, update) == UPLINK_OK;
+}
+
+Uplink* uploadGate(GuardedUplink& guarded, uint32_t now) {
+  UplinkHealth& health = guarded.health();
+  if (health.probeDue(now)) {
+    health.probes++;
+    Uplink& inner = guarded.inner();
+    // Any answer from the backend, even a rejected request, means the link is back
+    if (uploadProbe(inner, now) || classifyUplinkError(inner.errorReason()) == UPLINK_ERR_REQUEST) {
+      LOG_I("✓ Uplink probe answered\n");
+      health.success(now);
+    } else {
+      health.failure(inner.errorReason(), guarded.now());
+      LOG_E("✗ Uplink probe failed: %s, next in %u s\n", inner.errorReason(),
+             (unsigned)((health.retryAt() - now) / 1000));
+    }
+  }
+  return health.allow(now) ? &guarded : nullptr;
+}
+
+#ifdef ENABLE_METRICS
+bool uploadMetrics(Uplink& uplink, uint32_t now, const SampleClock* clock) {
+  uploadArena.reset();
+  JsonDocument update(&uploadArena);
+  JsonObject metrics = update["metrics"].to<JsonObject>();
+  metricsPublish(metrics, now);
+  // Scalar writes since boot, against those the deadband saved
+  JsonObject scalars = metrics["scalars"].to<JsonObject>();
+  for (uint8_t i = 0; i < SCALAR_COUNT; i++) {
+    JsonObject s = scalars[scalarNodes[i]].to<JsonObject>();
+    s["sent"] = scalarFilter.sent[i];
+    s["suppressed"] = scalarFilter.suppressed[i];
+  }
+  if (clock) clock->report(metrics["sampleClock"].to<JsonObject>());
+  UplinkStatus status = update.overflowed() ? UPLINK_TOO_LARGE : uplink.update(PATH_BASE, update);
+  metricsPublished(status == UPLINK_OK);
+  if (status == UPLINK_OK) LOG_I("✓ Metrics published\n");
+  else LOG_E("✗ Metrics upload failed: %s\n", uplink.errorReason());
+  return status == UPLINK_OK;
+}
+#endif
@@ -0,0 +1,91 @@
+#ifndef UPLOAD_H
+#define UPLOAD_H
+
+#include <ArduinoJson.h>
+#include "hal.h"
+#include "arenaAllocator.h"
+#include "sampleLog.h"
+#include "spscQueue.h"
+#include "liveSample.h"
+#include "uplinkHealth.h"
+#include "windowStats.h"
+#include "deadband.h"
+#include "sampleClock.h"
+
+#define UPLOAD_ARENA_SIZE 16384
+#define SAMPLE_LOG_BATCH 32       // Stored samples replayed per multi-path update
+#define SAMPLE_QUEUE_DEPTH 32     // Samples buffered between the acquisition and upload tasks
+#define AGG_PENDING_WINDOWS 10    // Window summaries held in memory while the uplink is down, without a window log
+#define WINDOW_LOG_SEGMENTS 8     // Window log segment files in rotation
+#define WINDOW_LOG_SEG_RECORDS 32 // Summaries per segment (~8 KB per file): 3.7 h or more of 1-minute windows
+#define WINDOW_LOG_SEG_MAGIC 0x574C4731UL   // "WLG1"
+#define WINDOW_LOG_BATCH 8        // Stored window summaries replayed per multi-path update
+#define LIVE_SAMPLE_SIZE 768      // Serialized sample document next to the queue, four probes fit
+// -DUPLOAD_PACKED_BATCHES: backlog replays and queued batches go out as one base64 delta
+// batch under packed/<first ts> instead of lastReadings/<ts> JSON (sampleCodec.h)
+
+// Acquisition task -> upload task
+typedef SpscQueue<SampleRecord, SAMPLE_QUEUE_DEPTH> SampleQueue;
+typedef LiveSampleSlot<LIVE_SAMPLE_SIZE> LiveSample;   // full documents for the live nodes
+// Closed window summaries that missed their upload, on flash until acknowledged
+typedef RecordLog<WindowSummary, WINDOW_LOG_SEGMENTS, WINDOW_LOG_SEG_RECORDS, WINDOW_LOG_SEG_MAGIC> WindowLog;
+
+// Fan-out documents are built here and reset every cycle
+extern ArenaAllocator uploadArena;
+extern uint32_t windowsDropped;   // summaries lost to a full pending queue, without a window log
+extern uint32_t liveMisses;       // live nodes rebuilt from a record because its document was gone
+
+// Scalar nodes next to lastReadings, each behind a deadband and heartbeat (nodeConfig.h).
+// Every upload path hands the filter the same clock, millis(): sample keys are epoch time.
+enum ScalarNode {
+  SCALAR_TEMPERATURE,
+  SCALAR_HUMIDITY,
+  SCALAR_HEAT_INDEX,
+  SCALAR_SOIL_TEMPERATURE,
+  SCALAR_SOIL_MOISTURE,
+  SCALAR_COUNT
+};
+typedef DeadbandFilter<SCALAR_COUNT> ScalarFilter;
+extern const char* const scalarNodes[SCALAR_COUNT];
+extern ScalarFilter scalarFilter;
+
+// Same nodes as one request per node, written with a single multi-location update at PATH_BASE
+bool uploadSensorDataFanout(Uplink& uplink, JsonDocument& doc, uint32_t now);
+// Replay up to SAMPLE_LOG_BATCH stored samples as lastReadings/<ts> (or one packed batch) in one update
+bool uploadBacklog(Uplink& uplink, SampleLog& log);
+// One upload tick: drain a backlog batch, then send doc if fresh. Without an uplink, or if
+// the upload fails, a fresh sample goes to log. Returns true when doc reached the cloud.
+bool uploadCycle(Uplink* uplink, SampleLog* log, JsonDocument& doc, bool fresh, uint32_t now);
+// Upload-task side of the queue: drain a backlog batch, then everything queued. Without an
+// uplink, or for anything the uplink rejects, samples go to log. Returns samples delivered.
+size_t uploadQueue(Uplink* uplink, SampleLog* log, SampleQueue& queue, uint32_t now, LiveSample* live = nullptr);
+// n buffered samples, oldest first: all but the newest as one lastReadings update, the newest
+// with the full fan-out, as its document in live when that still holds it. What fails goes
+// to log when there is one. Returns samples delivered.
+size_t uploadBatch(Uplink* uplink, SampleLog* log, const SampleRecord* recs, size_t n, uint32_t now,
+                   LiveSample* live = nullptr);
+// Aggregated mode: recs are folded into agg and every closed window becomes one summary
+// under windows/<start>. A batch of stored summaries is replayed first, then the new ones
+// go out in one update together with 'latest' and the scalar nodes from the newest sample,
+// split into smaller updates (the live nodes with the newest) while too large for the upload
+// buffers. What the uplink does not take goes to winLog; without one up to
+// AGG_PENDING_WINDOWS wait in memory, oldest dropped first. Returns summaries delivered.
+size_t uploadWindows(Uplink* uplink, WindowLog* winLog, WindowAggregator& agg, const SampleRecord* recs, size_t n,
+                     uint32_t now, LiveSample* live = nullptr);
+// uploadQueue for aggregated mode; with raw set every sample also goes out (and to the
+// log) as in uploadQueue. The log's backlog is replayed either way. Returns summaries delivered.
+size_t uploadQueueWindows(Uplink* uplink, SampleLog* log, WindowLog* winLog, SampleQueue& queue,
+                          WindowAggregator& agg, bool raw, uint32_t now, LiveSample* live = nullptr);
+// Cheap liveness check for an open circuit: one tiny write of PATH_BASE/status/seen_ms
+bool uploadProbe(Uplink& uplink, uint32_t now);
+// Uplink for this tick under the health state machine: the guarded uplink while uploads are
+// allowed, nullptr (samples go to the log) while backing off. An open circuit probes when due.
+Uplink* uploadGate(GuardedUplink& guarded, uint32_t now);
+#ifdef ENABLE_METRICS
+// Publish the instrumentation window as PATH_BASE/metrics, next to lastReadings, with the
+// sampling clock's jitter report as metrics/sampleClock when there is one. The window is
+// only reset once the backend has it; a failed publish folds it into the next one.
+bool uploadMetrics(Uplink& uplink, uint32_t now, const SampleClock* clock = nullptr);
+#endif
+
+#endif
@@ -0,0 +1,180 @@
+#ifdef ARDUINO
+#include "wifiLink.h"
+#include <Preferences.h>
+#include <esp_attr.h>
+#include <string.h>
+
+#define LINK_UP_BIT BIT0
+#define LINK_FAIL_BIT BIT1
+
+RTC_DATA_ATTR static WifiCache rtcWifiCache;
+
+static uint32_t ssidHash(const char* s) {
+  uint32_t h = 2166136261UL;      // FNV-1a
+  while (*s) h = (h ^ (uint8_t)*s++) * 16777619UL;
+  return h;
+}
+
+WifiLink::WifiLink()
+  : ssid_(""), password_(""), reuseLease_(false), events_(nullptr), up_(false),
+    connecting_(false), wanted_(false), usedCache_(false), dropRetries_(0), connectMs_(0),
+    reconnects_(0), lastReason_(0) {
+  memset(&cache_, 0, sizeof(cache_));
+}
+
+void WifiLink::begin(const char* ssid, const char* password, bool reuseLease) {
+  ssid_ = ssid;
+  password_ = password;
+  reuseLease_ = reuseLease;
+  if (!events_) {
+    events_ = xEventGroupCreate();
+    WiFi.onEvent([this](arduino_event_id_t event, arduino_event_info_t info) { onEvent(event, info); });
+  }
+  // The cache below replaces the SDK's own copy (a flash write on every begin) and its
+  // blind reconnect loop
+  WiFi.persistent(false);
+  WiFi.setAutoReconnect(false);
+  loadCache();
+}
+
+// RTC copy after a deep-sleep wake, NVS otherwise
+void WifiLink::loadCache() {
+  uint32_t hash = ssidHash(ssid_);
+  if (rtcWifiCache.magic == WIFI_CACHE_MAGIC && rtcWifiCache.ssidHash == hash) {
+    cache_ = rtcWifiCache;
+    return;
+  }
+  Preferences prefs;
+  memset(&cache_, 0, sizeof(cache_));
+  if (prefs.begin("wifi", true)) {
+    prefs.getBytes("cache", &cache_, sizeof(cache_));
+    prefs.end();
+  }
+  if (cache_.magic != WIFI_CACHE_MAGIC || cache_.ssidHash != hash) {
+    memset(&cache_, 0, sizeof(cache_));
+  }
+  rtcWifiCache = cache_;
+}
+
+// NVS is only written when the association actually changed, to spare the flash
+void WifiLink::saveCache() {
+  WifiCache fresh;
+  memset(&fresh, 0, sizeof(fresh));
+  fresh.magic = WIFI_CACHE_MAGIC;
+  fresh.ssidHash = ssidHash(ssid_);
+  memcpy(fresh.bssid, WiFi.BSSID(), sizeof(fresh.bssid));
+  fresh.channel = WiFi.channel();
+  fresh.hasLease = true;
+  fresh.ip = WiFi.localIP();
+  fresh.gateway = WiFi.gatewayIP();
+  fresh.subnet = WiFi.subnetMask();
+  fresh.dns = WiFi.dnsIP();
+
+  rtcWifiCache = fresh;
+  if (memcmp(&fresh, &cache_, sizeof(fresh)) == 0) return;
+  cache_ = fresh;
+  Preferences prefs;
+  if (prefs.begin("wifi", false)) {
+    prefs.putBytes("cache", &cache_, sizeof(cache_));
+    prefs.end();
+  }
+}
+
+void WifiLink::forgetCache() {
+  cache_.magic = 0;
+  rtcWifiCache.magic = 0;
+}
+
+// One association attempt, cached or with a full scan, returning on the first event
+bool WifiLink::join(bool cached, uint32_t timeoutMs) {
+  xEventGroupClearBits(events_, LINK_UP_BIT | LINK_FAIL_BIT);
+  if (cached && reuseLease_ && cache_.hasLease) {
+    WiFi.config(IPAddress(cache_.ip), IPAddress(cache_.gateway), IPAddress(cache_.subnet),
+                IPAddress(cache_.dns));
+  } else {
+    WiFi.config(IPAddress((uint32_t)0), IPAddress((uint32_t)0), IPAddress((uint32_t)0));  // DHCP
+  }
+  if (cached) {
+    WiFi.begin(ssid_, password_, cache_.channel, cache_.bssid);
+  } else {
+    WiFi.begin(ssid_, password_);
+  }
+  EventBits_t bits = xEventGroupWaitBits(events_, LINK_UP_BIT | LINK_FAIL_BIT, pdTRUE, pdFALSE,
+                                         pdMS_TO_TICKS(timeoutMs));
+  return bits & LINK_UP_BIT;
+}
+
+bool WifiLink::connect(uint32_t timeoutMs) {
+  if (!events_) return false;
+  uint32_t start = millis();
+  connecting_ = true;
+  wanted_ = true;
+  WiFi.mode(WIFI_STA);
+
+  usedCache_ = cache_.magic == WIFI_CACHE_MAGIC;
+  bool ok = false;
+  if (usedCache_) {
+    ok = join(true, timeoutMs < WIFI_FAST_TIMEOUT ? timeoutMs : WIFI_FAST_TIMEOUT);
+    if (!ok) {
+      // AP moved channel, was replaced, or the lease is gone: scan from scratch
+      usedCache_ = false;
+      forgetCache();
+      WiFi.disconnect();
+      // Absorb the disconnect event so it cannot fail the scan below
+      xEventGroupWaitBits(events_, LINK_FAIL_BIT, pdTRUE, pdFALSE, pdMS_TO_TICKS(100));
+    }
+  }
+  uint32_t spent = millis() - start;
+  if (!ok && spent < timeoutMs) ok = join(false, timeoutMs - spent);
+
+  if (ok) {
+    saveCache();
+    dropRetries_ = 0;
+  } else {
+    WiFi.disconnect();
+  }
+  connectMs_ = millis() - start;
+  connecting_ = false;
+  return ok;
+}
+
+void WifiLink::end() {
+  wanted_ = false;
+  WiFi.disconnect(true);
+}
+
+// Runs in the Arduino event task
+void WifiLink::onEvent(arduino_event_id_t event, arduino_event_info_t info) {
+  switch (event) {
+    case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+      up_ = true;
+      xEventGroupSetBits(events_, LINK_UP_BIT);
+      if (!connecting_) {
+        // A background reconnect landed; remember where
+        dropRetries_ = 0;
+        saveCache();
+      }
+      break;
+
+    case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+      up_ = false;
+      lastReason_ = info.wifi_sta_disconnected.reason;
+      xEventGroupSetBits(events_, LINK_FAIL_BIT);
+      if (connecting_ || !wanted_) break;
+      // Each failed attempt comes back here, so this is the retry loop
+      reconnects_++;
+      if (cache_.magic == WIFI_CACHE_MAGIC && dropRetries_ < WIFI_FAST_RETRIES) {
+        dropRetries_++;
+        WiFi.begin(ssid_, password_, cache_.channel, cache_.bssid);
+      } else {
+        forgetCache();
+        if (reuseLease_) WiFi.config(IPAddress((uint32_t)0), IPAddress((uint32_t)0), IPAddress((uint32_t)0));
+        WiFi.begin(ssid_, password_);
+      }
+      break;
+
+    default:
+      break;
+  }
+}
+#endif
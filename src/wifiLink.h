@@ -0,0 +1,68 @@
+#ifndef WIFI_LINK_H
+#define WIFI_LINK_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <freertos/event_groups.h>
+
+#define WIFI_FAST_TIMEOUT 3000    // Direct join to the cached BSSID; usually ~300 ms
+#define WIFI_FAST_RETRIES 2       // Link drops retried on the cached BSSID before a full scan
+#define WIFI_CACHE_MAGIC 0x57464331   // "WFC1"; bump when the layout changes
+
+// Last good association, in RTC memory for deep-sleep wakes and in NVS for cold boots
+struct WifiCache {
+  uint32_t magic;
+  uint32_t ssidHash;              // A changed SSID in secrets.h invalidates the cache
+  uint8_t bssid[6];
+  uint8_t channel;
+  bool hasLease;
+  uint32_t ip;                    // DHCP lease at the time, for reuseLease
+  uint32_t gateway;
+  uint32_t subnet;
+  uint32_t dns;
+};
+
+// Connection manager for the station interface. connect() joins the cached BSSID on
+// its channel, skipping the scan; only when that fails does it fall back to a full
+// scan-and-associate. Waits on WiFi events rather than polling WiFi.status(), and once
+// up, reconnects on its own from the disconnect event, again trying the cache first.
+class WifiLink {
+public:
+  WifiLink();
+
+  // reuseLease: configure the last DHCP lease as a static IP, skipping DHCP too.
+  // Only safe with a reservation for this node on the router.
+  void begin(const char* ssid, const char* password, bool reuseLease = false);
+  bool connect(uint32_t timeoutMs);
+  // Drop the link and stop reconnecting, e.g. before powering the radio down
+  void end();
+
+  bool connected() const { return up_; }
+  bool usedCache() const { return usedCache_; }     // Last connect went through the cache
+  uint32_t connectMs() const { return connectMs_; } // Duration of the last connect()
+  uint32_t reconnects() const { return reconnects_; }
+  uint8_t lastReason() const { return lastReason_; } // wifi_err_reason_t of the last drop
+
+private:
+  void onEvent(arduino_event_id_t event, arduino_event_info_t info);
+  bool join(bool cached, uint32_t timeoutMs);
+  void loadCache();
+  void saveCache();
+  void forgetCache();
+
+  const char* ssid_;
+  const char* password_;
+  bool reuseLease_;
+  EventGroupHandle_t events_;
+  WifiCache cache_;
+  volatile bool up_;
+  volatile bool connecting_;      // connect() owns the radio; the event handler stays out
+  volatile bool wanted_;          // Reconnect on drops
+  bool usedCache_;
+  uint8_t dropRetries_;
+  uint32_t connectMs_;
+  uint32_t reconnects_;
+  uint8_t lastReason_;
+};
+
+#endif
@@ -0,0 +1,95 @@
+#include "windowStats.h"
+#include <math.h>
+#include <string.h>
+
+void WindowAggregator::begin(const SampleRecord& rec) {
+  memset(&current_, 0, sizeof(current_));
+  uint64_t boundary = rec.timestamp - rec.timestamp % windowMs_;
+  sampleFlags_ = rec.flags & SAMPLE_UNSYNCED;
+  if (sampleFlags_ || (lastBoundary_ && boundary <= lastBoundary_)) {
+    current_.start = rec.timestamp;
+    current_.flags = SAMPLE_UNSYNCED;
+  } else {
+    current_.start = boundary;
+    lastBoundary_ = boundary;
+  }
+  current_.end = boundary + windowMs_;
+  open_ = true;
+}
+
+bool WindowAggregator::add(const SampleRecord& rec) {
+  bool closed = false;
+  if (open_ && (rec.timestamp >= current_.end || rec.timestamp < current_.start ||
+                (rec.flags & SAMPLE_UNSYNCED) != sampleFlags_)) {
+    closed = flush();
+  }
+  if (!open_) begin(rec);
+
+  WindowSummary& w = current_;
+  FieldStats* f = w.fields;
+  if (rec.flags & SAMPLE_HAS_DHT11) {
+    f[AGG_AIR_TEMP].add(rec.airTemp / 100.0f);
+    f[AGG_AIR_HUMIDITY].add(rec.airHumidity / 100.0f);
+    f[AGG_HEAT_INDEX].add(rec.heatIndex / 100.0f);
+  }
+  if (rec.flags & SAMPLE_HAS_SOIL_TEMP) f[AGG_SOIL_TEMP].add(rec.soilTemp / 100.0f);
+  if (rec.flags & SAMPLE_HAS_SOIL_MOISTURE) f[AGG_SOIL_MOISTURE].add(rec.soilMoisture / 100.0f);
+  if (rec.flags & SAMPLE_HAS_BME280) {
+    f[AGG_BME_TEMP].add(rec.bmeTemp / 100.0f);
+    f[AGG_BME_HUMIDITY].add(rec.bmeHumidity / 100.0f);
+    f[AGG_PRESSURE].add(rec.pressure / 100.0f);   // hPa, as in the sample document
+  }
+  w.count++;
+  w.last = rec;
+  return closed;
+}
+
+bool WindowAggregator::flush() {
+  if (!open_) return false;
+  open_ = false;
+  if (current_.count == 0) return false;
+  closed_ = current_;
+  return true;
+}
+
+static float round2(float v) {
+  return roundf(v * 100.0f) / 100.0f;
+}
+
+static void statsToJson(const FieldStats& s, JsonObject parent, const char* key) {
+  if (s.count == 0) return;
+  JsonObject o = parent[key].to<JsonObject>();
+  o["n"] = s.count;
+  o["mean"] = round2(s.mean);
+  o["sd"] = round2(sqrtf(s.variance()));
+  o["min"] = s.min;
+  o["max"] = s.max;
+  o["last"] = s.last;
+}
+
+void windowToJson(const WindowSummary& w, JsonObject out) {
+  out["start"] = w.start;
+  out["end"] = w.end;
+  out["n"] = w.count;
+  if (w.flags & SAMPLE_UNSYNCED) out["unsynced"] = true;
+  const FieldStats* f = w.fields;
+
+  if (f[AGG_AIR_TEMP].count) {
+    JsonObject dht = out["dht11"].to<JsonObject>();
+    statsToJson(f[AGG_AIR_TEMP], dht, "temperature");
+    statsToJson(f[AGG_AIR_HUMIDITY], dht, "humidity");
+    statsToJson(f[AGG_HEAT_INDEX], dht, "heatIndex");
+  }
+  if (f[AGG_SOIL_TEMP].count) {
+    statsToJson(f[AGG_SOIL_TEMP], out["soilTemperature"].to<JsonObject>(), "celsius");
+  }
+  if (f[AGG_SOIL_MOISTURE].count) {
+    statsToJson(f[AGG_SOIL_MOISTURE], out["soilMoisture"].to<JsonObject>(), "percentage");
+  }
+  if (f[AGG_BME_TEMP].count) {
+    JsonObject bme = out["bme280"].to<JsonObject>();
+    statsToJson(f[AGG_BME_TEMP], bme, "temperature");
+    statsToJson(f[AGG_PRESSURE], bme, "pressure");
+    statsToJson(f[AGG_BME_HUMIDITY], bme, "humidity");
+  }
+}
@@ -0,0 +1,89 @@
+#ifndef WINDOW_STATS_H
+#define WINDOW_STATS_H
+
+#include <stdint.h>
+#include <ArduinoJson.h>
+#include "sampleRecord.h"
+
+// Tumbling-window aggregation of samples: per field count, mean and variance (Welford),
+// min, max and last value, in constant memory however many samples a window sees.
+// Windows are aligned to multiples of their length on the sample clock. Samples with
+// provisional keys (SAMPLE_UNSYNCED) never share a window with synced ones; a window of
+// them, or one whose boundary an earlier window already used (the clock stepped back),
+// starts at its first sample's key instead, so it cannot overwrite a synced window's
+// path, and is flagged unsynced.
+
+#define AGG_WINDOW_MS 60000
+
+enum AggField {
+  AGG_AIR_TEMP,
+  AGG_AIR_HUMIDITY,
+  AGG_HEAT_INDEX,
+  AGG_SOIL_TEMP,
+  AGG_SOIL_MOISTURE,
+  AGG_BME_TEMP,
+  AGG_BME_HUMIDITY,
+  AGG_PRESSURE,
+  AGG_FIELD_COUNT
+};
+
+struct FieldStats {
+  uint32_t count;
+  float mean;
+  float m2;               // sum of squared deviations from the running mean
+  float min;
+  float max;
+  float last;
+
+  void reset() { count = 0; mean = m2 = min = max = last = 0.0f; }
+  // Welford's update: numerically stable in float, unlike sum and sum of squares
+  void add(float x) {
+    count++;
+    float delta = x - mean;
+    mean += delta / count;
+    m2 += delta * (x - mean);
+    if (count == 1 || x < min) min = x;
+    if (count == 1 || x > max) max = x;
+    last = x;
+  }
+  float variance() const { return count > 1 ? m2 / (count - 1) : 0.0f; }   // sample variance
+};
+
+struct WindowSummary {
+  uint64_t start;         // epoch ms, window boundary, or the first key of an unsynced window
+  uint64_t end;           // epoch ms, exclusive
+  uint32_t count;         // samples folded in
+  uint16_t flags;         // SAMPLE_UNSYNCED
+  FieldStats fields[AGG_FIELD_COUNT];
+  SampleRecord last;      // newest sample, for the live nodes
+};
+
+class WindowAggregator {
+public:
+  explicit WindowAggregator(uint32_t windowMs = AGG_WINDOW_MS)
+      : windowMs_(windowMs), open_(false), sampleFlags_(0), lastBoundary_(0) {}
+
+  // Fold rec in. A sample outside the current window, before it after a step back, or
+  // synced where the window holds provisional keys (or the other way round) first closes
+  // it: returns true and closed() holds that window's summary until the next close.
+  bool add(const SampleRecord& rec);
+  // Close the current window early, e.g. before deep sleep; false if it is empty
+  bool flush();
+  const WindowSummary& closed() const { return closed_; }
+  uint32_t windowMs() const { return windowMs_; }
+
+private:
+  void begin(const SampleRecord& rec);
+
+  uint32_t windowMs_;
+  bool open_;
+  uint16_t sampleFlags_;    // SAMPLE_UNSYNCED of the samples the current window takes
+  uint64_t lastBoundary_;   // newest boundary a synced window started on
+  WindowSummary current_;
+  WindowSummary closed_;
+};
+
+// Same nesting as a sample document (dht11/temperature, ...), each leaf a stats object
+void windowToJson(const WindowSummary& w, JsonObject out);
+
+#endif
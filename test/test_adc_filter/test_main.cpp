@@ -0,0 +1,81 @@
+#include <math.h>
+#include <stdio.h>
+#include <unity.h>
+#include "adcFilter.h"
+
+// Capacitive probe: ~2.8 V in dry soil, ~1.2 V saturated
+static const MoistureCalPoint moisturePoints[] = { { 1200, 10000 }, { 1700, 6500 }, { 2800, 0 } };
+static const MoistureCal moistureCal = { moisturePoints, 3 };
+
+void setUp() {}
+void tearDown() {}
+
+static void test_trimmed_mean_rejects_spikes() {
+  uint16_t burst[ADC_OVERSAMPLE];
+  for (size_t i = 0; i < ADC_OVERSAMPLE; i++) burst[i] = 2000 + (i % 5) - 2;
+  burst[3] = 4095;
+  burst[17] = 0;
+  burst[40] = 4095;
+  TEST_ASSERT_UINT32_WITHIN(1, 2000, trimmedMean(burst, ADC_OVERSAMPLE, ADC_TRIM_PERCENT));
+}
+
+static void test_median_and_single_sample() {
+  uint16_t odd[] = { 9, 1, 5, 7, 3 };
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(5, trimmedMean(odd, 5, 50), "median of 5");
+  uint16_t even[] = { 4, 1, 3, 2 };
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(3, trimmedMean(even, 4, 50), "median of 4");
+  uint16_t one[] = { 1234 };
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(1234, trimmedMean(one, 1, ADC_TRIM_PERCENT), "single sample");
+}
+
+// Interpolation between points, clamping past either end, falling and rising curves
+static void test_calibration_curve() {
+  TEST_ASSERT_EQUAL_INT32_MESSAGE(10000, moistureCentiPercent(moistureCal, 1200), "wet end");
+  TEST_ASSERT_EQUAL_INT32_MESSAGE(10000, moistureCentiPercent(moistureCal, 900), "below wet end");
+  TEST_ASSERT_EQUAL_INT32_MESSAGE(0, moistureCentiPercent(moistureCal, 3100), "above dry end");
+  TEST_ASSERT_EQUAL_INT32_MESSAGE(6500, moistureCentiPercent(moistureCal, 1700), "knee");
+  TEST_ASSERT_EQUAL_INT32_MESSAGE(8250, moistureCentiPercent(moistureCal, 1450), "first segment");
+  TEST_ASSERT_EQUAL_INT32_MESSAGE(3250, moistureCentiPercent(moistureCal, 2250), "second segment");
+  static const MoistureCalPoint rising[] = { { 100, 0 }, { 2100, 10000 } };
+  TEST_ASSERT_EQUAL_INT32_MESSAGE(2500, moistureCentiPercent(MoistureCal{ rising, 2 }, 600), "rising curve");
+}
+
+// 1000 bursts: +-8 count noise, 1 in 16 conversions a spike to the rails. The trimmed
+// mean must stay within 2 counts rms and beat the plain mean tenfold.
+static void test_trimmed_mean_beats_plain_mean_on_noise() {
+  uint16_t burst[ADC_OVERSAMPLE];
+  uint32_t rng = 99;
+  double sqPlain = 0, sqTrim = 0;
+  const int bursts = 1000;
+  for (int b = 0; b < bursts; b++) {
+    uint32_t sum = 0;
+    for (size_t i = 0; i < ADC_OVERSAMPLE; i++) {
+      rng ^= rng << 13;
+      rng ^= rng >> 17;
+      rng ^= rng << 5;
+      uint16_t v = (uint16_t)(2000 + (int)(rng % 17) - 8);
+      if ((rng >> 8) % 16 == 0) v = (rng >> 12) & 1 ? 4095 : 0;
+      burst[i] = v;
+      sum += v;
+    }
+    double plain = (double)sum / ADC_OVERSAMPLE - 2000;
+    double trim = (double)trimmedMean(burst, ADC_OVERSAMPLE, ADC_TRIM_PERCENT) - 2000;
+    sqPlain += plain * plain;
+    sqTrim += trim * trim;
+  }
+  double rmsPlain = sqrt(sqPlain / bursts), rmsTrim = sqrt(sqTrim / bursts);
+  char msg[80];
+  snprintf(msg, sizeof(msg), "burst error rms: plain mean %.1f counts, trimmed mean %.1f counts", rmsPlain, rmsTrim);
+  TEST_MESSAGE(msg);
+  TEST_ASSERT_TRUE_MESSAGE(rmsTrim < 2.0, msg);
+  TEST_ASSERT_TRUE_MESSAGE(rmsTrim * 10 < rmsPlain, msg);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_trimmed_mean_rejects_spikes);
+  RUN_TEST(test_median_and_single_sample);
+  RUN_TEST(test_calibration_curve);
+  RUN_TEST(test_trimmed_mean_beats_plain_mean_on_noise);
+  return UNITY_END();
+}
@@ -0,0 +1,113 @@
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <unity.h>
+#include "bme280Compensation.h"
+
+static const Bme280Calib calib = { 27504, 26435, -1000, 36477, -10685, 3024, 2855, 140, -7, 15500, -14600, 6000,
+                                   75, 362, 0, 309, -50, 30 };
+static Bme280Calib parsed;
+
+// Register images of a calibration, laid out as the chip stores them (H4/H5 share 0xE5)
+static void calibRegs(const Bme280Calib& c, uint8_t* tp, uint8_t* h) {
+  const uint16_t words[] = { c.T1, (uint16_t)c.T2, (uint16_t)c.T3, c.P1, (uint16_t)c.P2, (uint16_t)c.P3,
+                             (uint16_t)c.P4, (uint16_t)c.P5, (uint16_t)c.P6, (uint16_t)c.P7, (uint16_t)c.P8,
+                             (uint16_t)c.P9 };
+  for (size_t i = 0; i < 12; i++) {
+    tp[i * 2] = words[i] & 0xFF;
+    tp[i * 2 + 1] = words[i] >> 8;
+  }
+  tp[24] = 0;
+  tp[25] = c.H1;
+  h[0] = (uint16_t)c.H2 & 0xFF;
+  h[1] = (uint16_t)c.H2 >> 8;
+  h[2] = c.H3;
+  h[3] = (uint8_t)(c.H4 >> 4);
+  h[4] = (uint8_t)((c.H4 & 0x0F) | (c.H5 & 0x0F) << 4);
+  h[5] = (uint8_t)(c.H5 >> 4);
+  h[6] = (uint8_t)c.H6;
+}
+
+// Floating-point compensation from the datasheet (section 8.1), the reference for humidity
+static double humidityRef(const Bme280Calib& c, double tFine, int32_t adcH) {
+  double v = tFine - 76800.0;
+  v = (adcH - (c.H4 * 64.0 + c.H5 / 16384.0 * v)) *
+      (c.H2 / 65536.0 * (1.0 + c.H6 / 67108864.0 * v * (1.0 + c.H3 / 67108864.0 * v)));
+  v = v * (1.0 - c.H1 * v / 524288.0);
+  return v < 0 ? 0 : v > 100 ? 100 : v;
+}
+
+void setUp() {
+  uint8_t tp[BME280_CALIB_TP_LEN], h[BME280_CALIB_H_LEN];
+  calibRegs(calib, tp, h);
+  bme280ParseCalib(tp, h, parsed);
+}
+
+void tearDown() {}
+
+// Including the packed H4/H5 nibbles
+static void test_calibration_parsed_from_registers() {
+  const Bme280Calib& c = parsed;
+  TEST_ASSERT_TRUE_MESSAGE(c.T1 == calib.T1 && c.T2 == calib.T2 && c.T3 == calib.T3, "T1..T3");
+  TEST_ASSERT_TRUE_MESSAGE(c.P1 == calib.P1 && c.P2 == calib.P2 && c.P3 == calib.P3 && c.P4 == calib.P4 &&
+                           c.P5 == calib.P5 && c.P6 == calib.P6 && c.P7 == calib.P7 && c.P8 == calib.P8 &&
+                           c.P9 == calib.P9, "P1..P9");
+  TEST_ASSERT_TRUE_MESSAGE(c.H1 == calib.H1 && c.H2 == calib.H2 && c.H3 == calib.H3 && c.H6 == calib.H6,
+                           "H1..H3, H6");
+  TEST_ASSERT_EQUAL_INT_MESSAGE(309, c.H4, "H4");
+  TEST_ASSERT_EQUAL_INT_MESSAGE(-50, c.H5, "H5");
+}
+
+// The datasheet's worked example: adc_T 519888, adc_P 415148 -> t_fine 128422, 25.08 degC,
+// 100653.27 Pa
+static void test_datasheet_vector() {
+  // adc_T 519888, adc_P 415148, adc_H 30000 as 0xF7..0xFE
+  const uint8_t data[BME280_DATA_LEN] = { 0x65, 0x5A, 0xC0, 0x7E, 0xED, 0x00, 0x75, 0x30 };
+  Bme280Raw raw;
+  bme280ParseRaw(data, raw);
+  TEST_ASSERT_EQUAL_INT32_MESSAGE(415148, raw.press, "adc_P");
+  TEST_ASSERT_EQUAL_INT32_MESSAGE(519888, raw.temp, "adc_T");
+  TEST_ASSERT_EQUAL_INT32_MESSAGE(30000, raw.hum, "adc_H");
+  TEST_ASSERT_EQUAL_INT32_MESSAGE(128422, bme280TFine(parsed, raw.temp), "t_fine");
+  Bme280Reading r;
+  bme280Compensate(parsed, raw, r);
+  TEST_ASSERT_EQUAL_INT32_MESSAGE(2508, r.centiCelsius, "temperature 0.01 degC");
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(25767233, r.pressureQ8, "pressure Q24.8");
+  // The datasheet's 100653.27 Pa is from its rounded floating-point walk-through
+  TEST_ASSERT_INT32_WITHIN_MESSAGE(5, 10065327, lround(r.pressureQ8 * 100.0 / 256), "pressure, 0.01 Pa");
+}
+
+// Integer humidity against the floating-point formula over the sensor's range
+static void test_humidity_matches_float_formula() {
+  double worst = 0;
+  for (int32_t adcT = 400000; adcT <= 600000; adcT += 5000) {
+    int32_t tFine = bme280TFine(parsed, adcT);
+    for (int32_t adcH = 15000; adcH <= 45000; adcH += 250) {
+      double err = fabs(bme280CompensateH(parsed, tFine, adcH) / 1024.0 - humidityRef(parsed, tFine, adcH));
+      if (err > worst) worst = err;
+    }
+  }
+  char msg[48];
+  snprintf(msg, sizeof(msg), "humidity max error %.3f %%RH", worst);
+  TEST_MESSAGE(msg);
+  TEST_ASSERT_TRUE_MESSAGE(worst < 0.01, msg);
+  TEST_ASSERT_EQUAL_INT32_MESSAGE(0, bme280CompensateH(parsed, 128422, 0), "clamped low");
+  TEST_ASSERT_EQUAL_INT32_MESSAGE(100 * 1024, bme280CompensateH(parsed, 128422, 65535), "clamped high");
+}
+
+static void test_altitude_at_sea_level() {
+  Bme280Reading sea;
+  sea.centiCelsius = 1500;
+  sea.pressureQ8 = 101325 * 256;
+  sea.humidityQ10 = 0;
+  TEST_ASSERT_EQUAL_INT32(0, lroundf(sea.altitude(1013.25f) * 100));
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_calibration_parsed_from_registers);
+  RUN_TEST(test_datasheet_vector);
+  RUN_TEST(test_humidity_matches_float_formula);
+  RUN_TEST(test_altitude_at_sea_level);
+  return UNITY_END();
+}
@@ -0,0 +1,79 @@
+#include <math.h>
+#include <stdio.h>
+#include <chrono>
+#include <unity.h>
+#include "heatIndex.h"
+#include "sampleRecord.h"
+
+typedef std::chrono::steady_clock HostClock;
+
+void setUp() {}
+void tearDown() {}
+
+static double elapsedUs(HostClock::time_point start) {
+  return std::chrono::duration<double, std::micro>(HostClock::now() - start).count();
+}
+
+// Table against the float regression over the DHT11 range at 0.1 step
+static void test_table_matches_regression() {
+  int32_t worst = 0;
+  int16_t worstT = 0, worstH = 0;
+  for (int16_t t = HEAT_INDEX_T_MIN * 100; t <= HEAT_INDEX_T_MAX * 100; t += 10) {
+    for (int16_t h = 0; h <= 10000; h += 10) {
+      int32_t ref = lroundf(heatIndexRothfusz(t / 100.0f, h / 100.0f) * 100.0f);
+      int32_t err = heatIndexCenti(t, h) - ref;
+      if (err < 0) err = -err;
+      if (err > worst) {
+        worst = err;
+        worstT = t;
+        worstH = h;
+      }
+    }
+  }
+  char msg[96];
+  snprintf(msg, sizeof(msg), "table %u bytes, max error %.2f degC at %.1f degC %.1f %%RH",
+           (unsigned)(HEAT_INDEX_T_POINTS * HEAT_INDEX_RH_POINTS * sizeof(int16_t)), worst / 100.0,
+           worstT / 100.0, worstH / 100.0);
+  TEST_MESSAGE(msg);
+  TEST_ASSERT_LESS_OR_EQUAL_MESSAGE(15, worst, msg);
+}
+
+static void test_outside_table_falls_back() {
+  int32_t below = lroundf(heatIndexRothfusz(-10.0f, 50.0f) * 100.0f);
+  int32_t above = lroundf(heatIndexRothfusz(55.0f, 40.0f) * 100.0f);
+  TEST_ASSERT_EQUAL_INT32_MESSAGE(below, heatIndexCenti(-1000, 5000), "below table");
+  TEST_ASSERT_EQUAL_INT32_MESSAGE(above, heatIndexCenti(5500, 4000), "above table");
+}
+
+// Reported, not checked: host timings say little about the ESP32
+static void test_cost_per_call() {
+  const int rounds = 200;
+  volatile int32_t sink = 0;
+  HostClock::time_point start = HostClock::now();
+  for (int r = 0; r < rounds; r++) {
+    for (int16_t t = 0; t <= 5000; t += 50) {
+      for (int16_t h = 2000; h <= 9000; h += 100) sink = sink + lroundf(heatIndexRothfusz(t / 100.0f, h / 100.0f) * 100.0f);
+    }
+  }
+  double floatUs = elapsedUs(start);
+  start = HostClock::now();
+  for (int r = 0; r < rounds; r++) {
+    for (int16_t t = 0; t <= 5000; t += 50) {
+      for (int16_t h = 2000; h <= 9000; h += 100) sink = sink + heatIndexCenti(t, h);
+    }
+  }
+  double tableUs = elapsedUs(start);
+  double calls = rounds * 101.0 * 71.0;
+  char msg[96];
+  snprintf(msg, sizeof(msg), "per call: float regression %.1f ns, table %.1f ns; SampleRecord %u bytes",
+           floatUs * 1000 / calls, tableUs * 1000 / calls, (unsigned)sizeof(SampleRecord));
+  TEST_MESSAGE(msg);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_table_matches_regression);
+  RUN_TEST(test_outside_table_falls_back);
+  RUN_TEST(test_cost_per_call);
+  return UNITY_END();
+}
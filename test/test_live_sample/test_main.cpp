@@ -0,0 +1,105 @@
+#include <stdio.h>
+#include <string>
+#include <unity.h>
+#include "acquisition.h"
+#include "halSim.h"
+#include "liveSample.h"
+#include "nodeConfig.h"
+#include "upload.h"
+
+static SimDht dht;
+static SimSoilTemp soilTemp(2);
+static SimBaro baro;
+static SimAnalog moisture;
+static const MoistureCalPoint moisturePoints[] = { { 1200, 10000 }, { 1700, 6500 }, { 2800, 0 } };
+static const MoistureCal moistureCal = { moisturePoints, 3 };
+static SensorHal hal = { &dht, &soilTemp, &baro, &moisture, &moistureCal, FakeClock::read };
+
+void setUp() {
+  simLogEnabled = false;
+  liveMisses = 0;
+}
+
+void tearDown() {}
+
+// One round of samples through both upload paths: the single-core fan-out of the newest
+// document, and the dual-core queue with its live slot. 'latest' and lastReadings/<ts>
+// must come out the same, probes, altitude, millivolts and sensor errors included.
+static std::string liveRound(const SensorHal& sensors, uint32_t queuedSamples) {
+  static SampleQueue queue;
+  static LiveSample live;
+  CaptureUplink single, dual;
+  JsonDocument doc;
+  SampleRecord rec;
+  for (uint32_t i = 0; i < queuedSamples; i++) {
+    sensors.soilTemp->start(FakeClock::read());
+    FakeClock::advance(SAMPLE_INTERVAL);
+    doc.clear();
+    readSensorData(sensors, 1760000000000ULL + FakeClock::read(), doc, rec);
+    live.publish(rec.timestamp, doc);
+    queue.push(rec);
+  }
+  uint32_t now = FakeClock::read();
+  uploadCycle(&single, nullptr, doc, true, now);
+  uploadQueue(&dual, nullptr, queue, now, &live);
+
+  char key[40];
+  snprintf(key, sizeof(key), "lastReadings/%llu", (unsigned long long)rec.timestamp);
+  TEST_ASSERT_EQUAL_STRING_MESSAGE(single.nodes["lastReadings/latest"].c_str(),
+                                   dual.nodes["lastReadings/latest"].c_str(), "latest");
+  TEST_ASSERT_EQUAL_STRING_MESSAGE(single.nodes[key].c_str(), dual.nodes[key].c_str(), "entry");
+  return single.nodes["lastReadings/latest"];
+}
+
+static void test_dual_core_live_nodes_match_single_core() {
+  std::string latest = liveRound(hal, 1);
+  TEST_ASSERT_TRUE_MESSAGE(latest.find("\"probes\"") != std::string::npos, latest.c_str());
+  TEST_ASSERT_TRUE_MESSAGE(latest.find("\"altitude\"") != std::string::npos, latest.c_str());
+  TEST_ASSERT_TRUE_MESSAGE(latest.find("\"mv\"") != std::string::npos, latest.c_str());
+  liveRound(hal, 3);
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, liveMisses, "fallbacks to the record");
+}
+
+static void test_sensor_errors_reach_live_nodes() {
+  SimDht failingDht(1);
+  SensorHal dhtDown = hal;
+  dhtDown.dht = &failingDht;
+  liveRound(dhtDown, 2);
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, liveMisses, "fallbacks to the record");
+}
+
+// A document two samples old is gone and the record fields go out instead
+static void test_slot_keeps_the_last_two_documents() {
+  LiveSample slot;
+  JsonDocument doc, out;
+  doc["timestamp"] = 1;
+  slot.publish(1, doc);
+  doc["timestamp"] = 2;
+  slot.publish(2, doc);
+  doc["timestamp"] = 3;
+  slot.publish(3, doc);
+  TEST_ASSERT_FALSE_MESSAGE(slot.take(1, out), "overwritten document");
+  TEST_ASSERT_TRUE_MESSAGE(slot.take(2, out), "previous document");
+  TEST_ASSERT_EQUAL_INT(2, out["timestamp"].as<int>());
+  TEST_ASSERT_TRUE_MESSAGE(slot.take(3, out), "newest document");
+  TEST_ASSERT_EQUAL_INT(3, out["timestamp"].as<int>());
+}
+
+static void test_slot_refuses_oversized_documents() {
+  LiveSample slot;
+  JsonDocument doc, out;
+  JsonArray big = doc["big"].to<JsonArray>();
+  for (int i = 0; i < LIVE_SAMPLE_SIZE; i++) big.add(i);
+  TEST_ASSERT_FALSE(slot.publish(4, doc));
+  TEST_ASSERT_EQUAL_UINT32(1, slot.tooLarge());
+  TEST_ASSERT_FALSE(slot.take(4, out));
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_dual_core_live_nodes_match_single_core);
+  RUN_TEST(test_sensor_errors_reach_live_nodes);
+  RUN_TEST(test_slot_keeps_the_last_two_documents);
+  RUN_TEST(test_slot_refuses_oversized_documents);
+  return UNITY_END();
+}
@@ -0,0 +1,117 @@
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <unity.h>
+#include "logRing.h"
+#include "logger.h"
+
+#define LOG_TEST_WRITERS 4
+#define LOG_TEST_LINES 200000
+
+void setUp() {}
+void tearDown() {}
+
+// Lines in and out on one thread: order across the wrap, a full ring rejecting whole
+// lines, and a line longer than the ring cut to fit
+static void test_lines_come_out_whole_and_in_order() {
+  static LogRing<256> ring;
+  char line[LOG_LINE_MAX + 1], text[32];
+  TEST_ASSERT_TRUE(ring.empty());
+  for (unsigned i = 0; i < 40; i++) {
+    int len = snprintf(text, sizeof(text), "line %u\n", i);
+    TEST_ASSERT_TRUE(ring.push(text, len));
+    size_t n = ring.pop(line, LOG_LINE_MAX);
+    line[n] = 0;
+    TEST_ASSERT_EQUAL_STRING(text, line);
+  }
+  unsigned pushed = 0;
+  while (ring.push(text, snprintf(text, sizeof(text), "full %u\n", pushed))) pushed++;
+  TEST_ASSERT_EQUAL_UINT32(1, ring.dropped());
+  for (unsigned i = 0; i < pushed; i++) {
+    size_t n = ring.pop(line, LOG_LINE_MAX);
+    line[n] = 0;
+    snprintf(text, sizeof(text), "full %u\n", i);
+    TEST_ASSERT_EQUAL_STRING(text, line);
+  }
+  TEST_ASSERT_TRUE(ring.empty());
+  char big[300];
+  memset(big, 'x', sizeof(big));
+  TEST_ASSERT_TRUE(ring.push(big, sizeof(big)));
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(ring.capacity() - 2, ring.pop(line, LOG_LINE_MAX), "cut to the ring");
+}
+
+// Several writer threads and one reader, as on the device (two cores writing, the drain
+// task reading). The reader stalls now and then so lines get dropped. Every line read must
+// be whole and each writer's lines in order without repeats, and read + dropped must equal
+// written.
+static void test_writer_threads_against_one_reader() {
+  static LogRing<4096> ring;
+  std::atomic<bool> done(false);
+  uint32_t read = 0, errors = 0;
+  uint32_t next[LOG_TEST_WRITERS] = {};
+
+  std::thread reader([&]() {
+    char line[LOG_LINE_MAX + 1];
+    for (;;) {
+      size_t n = ring.pop(line, LOG_LINE_MAX);
+      if (n == 0) {
+        if (done.load()) return;
+        std::this_thread::yield();
+        continue;
+      }
+      line[n] = 0;
+      unsigned w, seq, len;
+      int head = 0;
+      // "w<writer> <seq> <len>|xxx...\n": len is the whole line, so a torn copy shows
+      if (sscanf(line, "w%u %u %u|%n", &w, &seq, &len, &head) != 3 || w >= LOG_TEST_WRITERS ||
+          len != n || seq < next[w] || line[n - 1] != '\n' ||
+          strspn(line + head, "x") != n - 1 - head) {
+        errors++;
+      } else {
+        next[w] = seq + 1;
+      }
+      read++;
+      if ((read & 0x3FF) == 0) std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+  });
+
+  std::thread writers[LOG_TEST_WRITERS];
+  for (unsigned w = 0; w < LOG_TEST_WRITERS; w++) {
+    writers[w] = std::thread([w]() {
+      char line[LOG_LINE_MAX];
+      for (uint32_t i = 0; i < LOG_TEST_LINES; i++) {
+        unsigned pad = (i * 7 + w * 13) % 200;
+        // Fixed-width length field, filled in once the line length is known
+        int head = snprintf(line, sizeof(line), "w%u %u %05u|", w, (unsigned)i, 0u);
+        unsigned len = head + pad + 1;
+        snprintf(line, sizeof(line), "w%u %u %05u|", w, (unsigned)i, len);
+        memset(line + head, 'x', pad);
+        line[head + pad] = '\n';
+        ring.push(line, len);
+        if ((i & 0x3F) == 0) std::this_thread::sleep_for(std::chrono::microseconds(50));
+      }
+    });
+  }
+  for (unsigned w = 0; w < LOG_TEST_WRITERS; w++) writers[w].join();
+  done.store(true);
+  reader.join();
+
+  uint32_t written = LOG_TEST_LINES * LOG_TEST_WRITERS;
+  char msg[112];
+  snprintf(msg, sizeof(msg), "written %u, read %u, dropped %u, high water %u of %u bytes", (unsigned)written,
+           (unsigned)read, (unsigned)ring.dropped(), (unsigned)ring.highWater(), (unsigned)ring.capacity());
+  TEST_MESSAGE(msg);
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, errors, "torn or reordered lines");
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(written, read + ring.dropped(), "read + dropped");
+  TEST_ASSERT_GREATER_THAN_MESSAGE(0, ring.dropped(), "the stalls dropped nothing");
+  TEST_ASSERT_TRUE(ring.empty());
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_lines_come_out_whole_and_in_order);
+  RUN_TEST(test_writer_threads_against_one_reader);
+  return UNITY_END();
+}
@@ -0,0 +1,55 @@
+#include <string>
+#include <unity.h>
+#include "halSim.h"
+#include "metrics.h"
+#include "upload.h"
+
+static CaptureUplink* cap;
+
+void setUp() {
+  simLogEnabled = false;
+  cap = new CaptureUplink();
+}
+
+void tearDown() {
+  delete cap;
+}
+
+#ifdef ENABLE_METRICS
+static JsonDocument published() {
+  JsonDocument doc;
+  TEST_ASSERT_FALSE_MESSAGE(deserializeJson(doc, cap->nodes["metrics"]), "metrics node");
+  return doc;
+}
+
+// A publish that fails keeps its counts: the next one reports both intervals, then the
+// window starts over
+static void test_failed_publish_folds_into_the_next() {
+  uploadMetrics(*cap, 0);   // start from an empty window
+  for (uint32_t i = 0; i < 10; i++) metricsRecord(M_RTDB_NODE, 100 + i);
+  cap->online = false;
+  TEST_ASSERT_FALSE_MESSAGE(uploadMetrics(*cap, 600000), "failed publish");
+  for (uint32_t i = 0; i < 5; i++) metricsRecord(M_RTDB_NODE, 5000);
+  cap->online = true;
+  TEST_ASSERT_TRUE_MESSAGE(uploadMetrics(*cap, 1200000), "retried publish");
+  JsonDocument doc = published();
+  JsonObject node = doc["stages"]["rtdbNode"];
+  TEST_ASSERT_EQUAL_INT_MESSAGE(15, node["n"].as<int>(), "counts kept");
+  TEST_ASSERT_EQUAL_INT_MESSAGE(100, node["min"].as<int>(), "min kept");
+  TEST_ASSERT_EQUAL_INT_MESSAGE(5000, node["max"].as<int>(), "max kept");
+  TEST_ASSERT_EQUAL_INT_MESSAGE(1200, doc["window_s"].as<int>(), "window covers both");
+
+  TEST_ASSERT_TRUE(uploadMetrics(*cap, 1800000));
+  doc = published();
+  TEST_ASSERT_TRUE_MESSAGE(doc["stages"]["rtdbNode"].isNull(), "next window empty");
+  TEST_ASSERT_EQUAL_INT_MESSAGE(600, doc["window_s"].as<int>(), "next window length");
+}
+#endif
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+#ifdef ENABLE_METRICS
+  RUN_TEST(test_failed_publish_folds_into_the_next);
+#endif
+  return UNITY_END();
+}
@@ -0,0 +1,197 @@
+#include <math.h>
+#include <stdio.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <unity.h>
+#include "nodeConfig.h"
+#include "sampleClock.h"
+
+#define CLOCK_TEST_HOURS 24
+#define CLOCK_SETTLE_HOURS 3
+#define CLOCK_FIX_EVERY_US 3600000000ULL
+#define CLOCK_SWING_PPM 30.0
+
+static const uint64_t bootUs = 3000000;
+// The last key a previous run handed out, on the grid
+static const uint64_t lastKey = 1760000000000ULL / SAMPLE_INTERVAL * SAMPLE_INTERVAL;
+
+void setUp() {}
+void tearDown() {}
+
+// Counter of a crystal that is off by ppm, which can change (temperature) at any point
+struct SimOscillator {
+  uint64_t anchorUs;      // counter value ...
+  double anchorEpochUs;   // ... and the true epoch time there
+  double ppm;
+
+  double epochUs(uint64_t us) const { return anchorEpochUs + (us - anchorUs) / (1 + ppm * 1e-6); }
+  void setPpm(uint64_t us, double p) {
+    anchorEpochUs = epochUs(us);
+    anchorUs = us;
+    ppm = p;
+  }
+};
+
+static uint32_t xorshift(uint32_t& s) {
+  s ^= s << 13;
+  s ^= s >> 17;
+  s ^= s << 5;
+  return s;
+}
+
+static uint32_t percentile(std::vector<uint32_t>& v, double q) {
+  std::sort(v.begin(), v.end());
+  return v.empty() ? 0 : v[(size_t)(q * (v.size() - 1))];
+}
+
+// A simulated crystal, 37 ppm fast, then 30 ppm after a temperature swing at 12 h. A power
+// cycle: the RTC counts from 1970, the last key is 3 h old. SNTP answers 8 s after boot and
+// hourly after that, each fix off by up to 10 ms of network delay, and the loop starts each
+// sample up to 400 us after its alarm, 25 ms when a DHT11 read is in the way. Keys must be
+// strictly increasing and, from the first fix on, on the grid, and once the drift is learned
+// alarms must fall within 50 ms of their true boundary and be spaced by the period to
+// within 1 ms.
+static void test_drifting_crystal_for_a_day() {
+  const uint64_t hourUs = 3600000000ULL;
+  SimOscillator osc = { 0, 1760000000123456.0, 37.0 };
+  uint64_t lastRunKey = (uint64_t)(osc.epochUs(bootUs) / 1000) - 3 * 3600000ULL;
+  SampleClock clock(SAMPLE_INTERVAL);
+  clock.begin(bootUs, 0, lastRunKey);
+
+  uint32_t rng = 7;
+  uint64_t now = bootUs, nextFix = bootUs + 8000000, prevKey = lastRunKey;
+  double prevAlarmEpochUs = 0;
+  uint32_t offGrid = 0, backwards = 0, settled = 0, unsynced = 0;
+  double worstErrUs = 0, worstSpacingUs = 0;
+  std::vector<uint32_t> jitters;
+  bool swung = false;
+  while (now < bootUs + CLOCK_TEST_HOURS * hourUs) {
+    uint64_t alarm;
+    uint64_t key = clock.next(now, alarm);
+    // A fix before the alarm re-places it, as SampleTimer::due() does
+    while (nextFix <= alarm) {
+      int32_t delayUs = (int32_t)(xorshift(rng) % 20001) - 10000;
+      clock.sync(nextFix, (uint64_t)((osc.epochUs(nextFix) + delayUs) / 1000));
+      key = clock.next(nextFix, alarm);
+      nextFix += CLOCK_FIX_EVERY_US;
+    }
+    if (!swung && alarm >= bootUs + 12 * hourUs) {
+      osc.setPpm(alarm, CLOCK_SWING_PPM);
+      swung = true;
+    }
+    uint32_t latency = 20 + xorshift(rng) % 400;
+    if (xorshift(rng) % 50 == 0) latency += 25000;
+    jitters.push_back(clock.taken(key, alarm, alarm + latency));
+
+    if (clock.provisional(key)) unsynced += clock.syncs() == 0;
+    if (key % SAMPLE_INTERVAL && clock.syncs()) offGrid++;
+    if (key <= prevKey) backwards++;
+    double alarmEpochUs = osc.epochUs(alarm);
+    if (alarm >= bootUs + CLOCK_SETTLE_HOURS * hourUs) {
+      settled++;
+      double err = fabs(alarmEpochUs - key * 1000.0);
+      if (err > worstErrUs) worstErrUs = err;
+      double spacing = fabs(alarmEpochUs - prevAlarmEpochUs - SAMPLE_INTERVAL * 1000.0);
+      if (key == prevKey + SAMPLE_INTERVAL && spacing > worstSpacingUs) worstSpacingUs = spacing;
+    }
+    prevKey = key;
+    prevAlarmEpochUs = alarmEpochUs;
+    now = alarm + latency;
+  }
+
+  JsonDocument report;
+  clock.report(report.to<JsonObject>());
+  std::string out;
+  serializeJson(report, out);
+  uint32_t p50 = percentile(jitters, 0.50), p99 = percentile(jitters, 0.99), worst = percentile(jitters, 1.0);
+  char msg[160];
+  snprintf(msg, sizeof(msg), "%u samples in %u h, %u after %u h: boundary error max %.1f ms, spacing error max %.0f us",
+           (unsigned)jitters.size(), CLOCK_TEST_HOURS, (unsigned)settled, CLOCK_SETTLE_HOURS,
+           worstErrUs / 1000, worstSpacingUs);
+  TEST_MESSAGE(msg);
+  snprintf(msg, sizeof(msg), "start jitter p50 %u us, p99 %u us, max %u us; drift estimate %.1f ppm (true %.1f)",
+           (unsigned)p50, (unsigned)p99, (unsigned)worst, -clock.driftPpb() / 1000.0, osc.ppm);
+  TEST_MESSAGE(msg);
+  TEST_MESSAGE(out.c_str());
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, offGrid, "keys off the grid");
+  TEST_ASSERT_GREATER_OR_EQUAL_UINT32_MESSAGE(1, unsynced, "provisional keys before the fix");
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32_MESSAGE(4, unsynced, "provisional keys before the fix");
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(unsynced, clock.provisionals(), "provisional keys");
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, backwards, "keys not increasing");
+  TEST_ASSERT_UINT32_WITHIN_MESSAGE(1, CLOCK_TEST_HOURS * 1800, jitters.size(), "samples");
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, clock.missed(), "missed boundaries");
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(1, clock.steps(), "steps");
+  TEST_ASSERT_LESS_OR_EQUAL_MESSAGE(50000, (int32_t)worstErrUs, "boundary error us");
+  TEST_ASSERT_LESS_OR_EQUAL_MESSAGE(1000, (int32_t)worstSpacingUs, "spacing error us");
+  TEST_ASSERT_INT32_WITHIN_MESSAGE(4000, -CLOCK_SWING_PPM * 1000, clock.driftPpb(), "drift estimate ppb");
+}
+
+// Soft reset, no network: continues above the last key, provisional
+static void test_restart_without_sntp() {
+  uint64_t alarm;
+  SampleClock restarted(SAMPLE_INTERVAL);
+  restarted.begin(bootUs, 0, lastKey);
+  uint64_t key = restarted.next(bootUs, alarm);
+  TEST_ASSERT_TRUE_MESSAGE(key > lastKey, "restart key above the last");
+  TEST_ASSERT_TRUE_MESSAGE(restarted.provisional(key), "restart key provisional");
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(1, key % SAMPLE_INTERVAL, "restart key past its boundary, ms");
+}
+
+// Short power cycle: keys resume 600 s (SAMPLE_CLOCK_SAVE_MS) above the one in NVS, so
+// SNTP steps the clock back. Sampling carries on from the stepped grid, and a later step
+// back brings boundaries round again as provisional keys instead of a stall.
+static void test_power_cycle_steps_back() {
+  uint64_t trueMs = lastKey + 10000, alarm, key;
+  SampleClock restarted(SAMPLE_INTERVAL);
+  restarted.begin(bootUs, 0, lastKey + 600000);
+  std::vector<uint64_t> keys, alarms;
+  uint64_t now = bootUs, secondStepUs = 0;
+  while (now < bootUs + 300000000ULL) {
+    key = restarted.next(now, alarm);
+    if (restarted.syncs() == 0 && alarm > bootUs + 5000000) {
+      restarted.sync(bootUs + 5000000, trueMs + 5000);
+      key = restarted.next(bootUs + 5000000, alarm);
+    } else if (!secondStepUs && alarm > bootUs + 120000000) {
+      secondStepUs = alarm - 1000000;
+      restarted.sync(secondStepUs, trueMs + (secondStepUs - bootUs) / 1000 - 30000);
+      key = restarted.next(secondStepUs, alarm);
+    }
+    restarted.taken(key, alarm, alarm + 100);
+    keys.push_back(key);
+    alarms.push_back(alarm);
+    now = alarm + 100;
+  }
+  uint32_t early = 0, repeats = 0, gaps = 0, duplicates = 0;
+  for (size_t i = 0; i < keys.size(); i++) {
+    if (restarted.provisional(keys[i])) (alarms[i] < bootUs + 5000000 ? early : repeats)++;
+    if (i && (int64_t)(alarms[i] - alarms[i - 1]) > SAMPLE_INTERVAL * 1000 + 1000) gaps++;
+    for (size_t j = 0; j < i; j++) duplicates += keys[j] == keys[i];
+  }
+  size_t firstSynced = 0;
+  while (firstSynced < keys.size() && alarms[firstSynced] < bootUs + 5000000) firstSynced++;
+  TEST_ASSERT_LESS_THAN(keys.size(), firstSynced);
+  int32_t firstOffset = (int32_t)(keys[firstSynced] - (trueMs + 5000));
+  char msg[128];
+  snprintf(msg, sizeof(msg), "%u samples, %u provisional before SNTP, %u after the second step, first synced key %+d ms from the fix",
+           (unsigned)keys.size(), (unsigned)early, (unsigned)repeats, (int)firstOffset);
+  TEST_MESSAGE(msg);
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(2, restarted.steps(), "steps after the power cycle");
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, gaps, "gaps after a step back");
+  TEST_ASSERT_UINT32_WITHIN_MESSAGE(1, 150, keys.size(), "samples in 300 s");
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, duplicates, "duplicate keys");
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(2, early, "provisional keys before SNTP");
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, keys[firstSynced] % SAMPLE_INTERVAL, "first key after the fix on the grid");
+  TEST_ASSERT_GREATER_OR_EQUAL_MESSAGE(1, firstOffset, "first key after the fix, ms");
+  TEST_ASSERT_LESS_OR_EQUAL_MESSAGE(SAMPLE_INTERVAL, firstOffset, "first key after the fix, ms");
+  TEST_ASSERT_UINT32_WITHIN_MESSAGE(1, 15, repeats, "provisional keys after a 30 s step back");
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, restarted.missed(), "missed boundaries after the power cycle");
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_drifting_crystal_for_a_day);
+  RUN_TEST(test_restart_without_sntp);
+  RUN_TEST(test_power_cycle_steps_back);
+  return UNITY_END();
+}
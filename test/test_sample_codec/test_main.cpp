@@ -0,0 +1,168 @@
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <unity.h>
+#include "acquisition.h"
+#include "halSim.h"
+#include "nodeConfig.h"
+#include "sampleCodec.h"
+#include "upload.h"
+
+#define CODEC_SAMPLES (SAMPLE_LOG_BATCH * 8)
+
+static SimDht dht;
+static SimSoilTemp soilTemp(2);
+static SimBaro baro;
+static SimAnalog moisture;
+static const MoistureCalPoint moisturePoints[] = { { 1200, 10000 }, { 1700, 6500 }, { 2800, 0 } };
+static const MoistureCal moistureCal = { moisturePoints, 3 };
+static SensorHal hal = { &dht, &soilTemp, &baro, &moisture, &moistureCal, FakeClock::read };
+
+static SampleRecord recs[CODEC_SAMPLES];
+static char b64[SAMPLE_BATCH_CHARS(SAMPLE_LOG_BATCH)];
+
+// The samples readSensorData produces on the simulated HAL, with sensors dropping out now
+// and then, a late sample, a boot's provisional keys and edge values mixed in. Fields of
+// missing sensors are meaningless and no format keeps them, so they are cleared.
+void setUp() {
+  simLogEnabled = false;
+  FakeClock::set(0);
+  JsonDocument doc;
+  for (uint32_t i = 0; i < CODEC_SAMPLES; i++) {
+    soilTemp.start(FakeClock::read());
+    FakeClock::advance(SAMPLE_INTERVAL + (i % 50 == 17 ? 130 : 0));
+    doc.clear();
+    readSensorData(hal, FakeClock::read() + 1760000000000ULL, doc, recs[i]);
+    if (i % 7 == 3) recs[i].flags &= ~SAMPLE_HAS_BME280;
+    if (i % 11 == 5) recs[i].flags &= ~(SAMPLE_HAS_DHT11 | SAMPLE_HAS_SOIL_TEMP);
+  }
+  for (uint32_t i = 3; i < 6; i++) {
+    recs[i].flags |= SAMPLE_UNSYNCED;
+    recs[i].timestamp += 1;
+  }
+  // Frost, extreme values, nothing but a timestamp, 32-bit timestamps from before epoch keys
+  recs[0].flags = SAMPLE_HAS_DHT11 | SAMPLE_HAS_SOIL_TEMP | SAMPLE_HAS_SOIL_MOISTURE | SAMPLE_HAS_BME280 | SAMPLE_UNSYNCED;
+  recs[0].airTemp = -1250;
+  recs[0].heatIndex = -31;
+  recs[0].soilTemp = -32768;
+  recs[0].soilMoisture = 0;
+  recs[0].soilRaw = 4095;
+  recs[0].bmeTemp = 32767;
+  recs[0].pressure = 0xFFFFFFFFu;
+  recs[1].flags = 0;
+  recs[1].timestamp = 0;
+  recs[2].timestamp = 0xFFFFFFF0u;
+  for (uint32_t i = 0; i < CODEC_SAMPLES; i++) {
+    SampleRecord& r = recs[i];
+    if (!(r.flags & SAMPLE_HAS_DHT11)) r.airTemp = r.airHumidity = r.heatIndex = 0;
+    if (!(r.flags & SAMPLE_HAS_SOIL_TEMP)) r.soilTemp = 0;
+    if (!(r.flags & SAMPLE_HAS_SOIL_MOISTURE)) r.soilMoisture = r.soilRaw = 0;
+    if (!(r.flags & SAMPLE_HAS_BME280)) r.bmeTemp = r.bmeHumidity = r.pressure = 0;
+  }
+}
+
+void tearDown() {}
+
+static void assertSameRecord(const SampleRecord& want, const SampleRecord& got) {
+  TEST_ASSERT_EQUAL_UINT64(want.timestamp, got.timestamp);
+  TEST_ASSERT_EQUAL_HEX16(want.flags, got.flags);
+  TEST_ASSERT_TRUE_MESSAGE(want.airTemp == got.airTemp && want.airHumidity == got.airHumidity &&
+                           want.heatIndex == got.heatIndex, "DHT11 fields");
+  TEST_ASSERT_TRUE_MESSAGE(want.soilTemp == got.soilTemp && want.soilMoisture == got.soilMoisture &&
+                           want.soilRaw == got.soilRaw, "soil fields");
+  TEST_ASSERT_TRUE_MESSAGE(want.bmeTemp == got.bmeTemp && want.bmeHumidity == got.bmeHumidity &&
+                           want.pressure == got.pressure, "BME280 fields");
+}
+
+// The update uploadRecords sends for a batch as lastReadings/<ts> JSON; returns its length
+static size_t jsonBatchSize(const SampleRecord* batch, size_t n) {
+  JsonDocument update;
+  char key[32];
+  for (size_t i = 0; i < n; i++) {
+    snprintf(key, sizeof(key), "lastReadings/%llu", (unsigned long long)batch[i].timestamp);
+    sampleToJson(batch[i], update[key].to<JsonObject>());
+  }
+  return measureJson(update);
+}
+
+// What the exporter must reproduce: the lastReadings entries of the JSON path
+static std::string directJson(const SampleRecord* batch, size_t n) {
+  JsonDocument direct;
+  char key[21];
+  for (size_t i = 0; i < n; i++) {
+    snprintf(key, sizeof(key), "%llu", (unsigned long long)batch[i].timestamp);
+    sampleToJson(batch[i], direct[key].to<JsonObject>());
+  }
+  std::string out;
+  serializeJson(direct, out);
+  return out;
+}
+
+static void test_single_samples_round_trip() {
+  for (uint32_t i = 0; i < CODEC_SAMPLES; i++) {
+    uint8_t buf[SAMPLE_PACKED_MAX];
+    SampleRecord back;
+    size_t len = encodeSample(recs[i], buf, sizeof(buf));
+    TEST_ASSERT_GREATER_THAN(0, len);
+    TEST_ASSERT_EQUAL_UINT32(len, decodeSample(buf, len, back));
+    assertSameRecord(recs[i], back);
+  }
+}
+
+// Every batch must decode to the same records, export to the same JSON as the direct path,
+// and be at least 3x smaller than the JSON update as the packed/<ts> value it goes up as
+static size_t checkBatches(size_t (*encode)(const SampleRecord*, size_t, char*, size_t), uint32_t minRatio10) {
+  size_t jsonBytes = 0, bytes = 0;
+  for (uint32_t b = 0; b < CODEC_SAMPLES / SAMPLE_LOG_BATCH; b++) {
+    const SampleRecord* batch = recs + b * SAMPLE_LOG_BATCH;
+    size_t len = encode(batch, SAMPLE_LOG_BATCH, b64, sizeof(b64));
+    TEST_ASSERT_GREATER_THAN(0, len);
+    SampleRecord back[SAMPLE_LOG_BATCH];
+    TEST_ASSERT_EQUAL_UINT32(SAMPLE_LOG_BATCH, decodeBatch(b64, back, SAMPLE_LOG_BATCH));
+    for (uint32_t k = 0; k < SAMPLE_LOG_BATCH; k++) assertSameRecord(batch[k], back[k]);
+    JsonDocument exported;
+    TEST_ASSERT_TRUE(packedBatchToJson(b64, exported.to<JsonObject>()));
+    std::string je;
+    serializeJson(exported, je);
+    TEST_ASSERT_EQUAL_STRING(directJson(batch, SAMPLE_LOG_BATCH).c_str(), je.c_str());
+    jsonBytes += jsonBatchSize(batch, SAMPLE_LOG_BATCH);
+    JsonDocument update;
+    char key[32];
+    snprintf(key, sizeof(key), "packed/%llu", (unsigned long long)batch[0].timestamp);
+    update[key] = (const char*)b64;
+    bytes += measureJson(update);
+  }
+  char msg[64];
+  snprintf(msg, sizeof(msg), "JSON %u bytes, batches %u bytes", (unsigned)jsonBytes, (unsigned)bytes);
+  TEST_MESSAGE(msg);
+  TEST_ASSERT_GREATER_OR_EQUAL_UINT32_MESSAGE(minRatio10, jsonBytes * 10 / bytes, msg);
+  return bytes;
+}
+
+static void test_packed_batches_round_trip() {
+  checkBatches(encodeBatch, 30);
+}
+
+// Timestamps that step back, wrap to 0 or jump by 2^32 and pressures at both rails all
+// sit in the first batch, so the deltas wrap both ways
+static void test_delta_batches_round_trip() {
+  size_t delta = checkBatches(encodeDeltaBatch, 30);
+  size_t packed = checkBatches(encodeBatch, 30);
+  TEST_ASSERT_LESS_THAN_MESSAGE(packed, delta, "delta batches smaller than packed");
+}
+
+static void test_exporter_rejects_what_is_not_a_batch() {
+  JsonDocument out;
+  TEST_ASSERT_FALSE(packedBatchToJson("not base64!", out.to<JsonObject>()));
+  TEST_ASSERT_FALSE(packedBatchToJson("", out.to<JsonObject>()));
+  TEST_ASSERT_EQUAL_UINT32(0, decodeBatch("AAAA", recs, 1));
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_single_samples_round_trip);
+  RUN_TEST(test_packed_batches_round_trip);
+  RUN_TEST(test_delta_batches_round_trip);
+  RUN_TEST(test_exporter_rejects_what_is_not_a_batch);
+  return UNITY_END();
+}
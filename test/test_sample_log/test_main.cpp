@@ -0,0 +1,130 @@
+#include <string.h>
+#include <unity.h>
+#include "posixBlockStore.h"
+#include "sampleLog.h"
+
+// Refuses appends on demand, like a full or failing flash partition
+class FlakyStore : public TempBlockStore {
+public:
+  FlakyStore() : TempBlockStore("/tmp/samplelog") {}
+  bool append(uint8_t seg, const void* buf, size_t len) override {
+    return !failAppends && TempBlockStore::append(seg, buf, len);
+  }
+
+  bool failAppends = false;
+};
+
+static FlakyStore* store;
+
+void setUp() {
+  store = new FlakyStore();
+}
+
+void tearDown() {
+  delete store;
+}
+
+static SampleRecord record(uint32_t i) {
+  SampleRecord rec;
+  memset(&rec, 0, sizeof(rec));
+  rec.timestamp = 1760000000000ULL + i * 2000ULL;
+  rec.soilRaw = (uint16_t)i;
+  return rec;
+}
+
+static void appendRange(SampleLog& log, uint32_t from, uint32_t to) {
+  for (uint32_t i = from; i < to; i++) TEST_ASSERT_TRUE(log.append(record(i)));
+}
+
+// Drains the log, checking the records come back in order starting at first
+static uint32_t drain(SampleLog& log, uint32_t first) {
+  SampleRecord batch[32];
+  uint32_t n = 0;
+  while (size_t got = log.peek(batch, 32)) {
+    for (size_t i = 0; i < got; i++) TEST_ASSERT_EQUAL_UINT32(first + n + i, batch[i].soilRaw);
+    n += got;
+    TEST_ASSERT_TRUE(log.commit());
+  }
+  return n;
+}
+
+static void test_pending_counts_appended_records() {
+  TEST_ASSERT_TRUE(store->ok());
+  SampleLog log(*store);
+  TEST_ASSERT_TRUE(log.begin());
+  TEST_ASSERT_EQUAL_UINT32(0, log.pending());
+  appendRange(log, 0, SAMPLE_LOG_SEG_RECORDS + 10);
+  TEST_ASSERT_EQUAL_UINT32(SAMPLE_LOG_SEG_RECORDS + 10, log.pending());
+  SampleRecord batch[32];
+  TEST_ASSERT_EQUAL_UINT32(32, log.peek(batch, 32));
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(SAMPLE_LOG_SEG_RECORDS + 10, log.pending(), "peek consumes nothing");
+  log.commit();
+  TEST_ASSERT_EQUAL_UINT32(SAMPLE_LOG_SEG_RECORDS - 22, log.pending());
+  TEST_ASSERT_EQUAL_UINT32(SAMPLE_LOG_SEG_RECORDS - 22, drain(log, 32));
+  TEST_ASSERT_EQUAL_UINT32(0, log.pending());
+}
+
+// A failed append seals the head early; the records it holds are all that count, before
+// and after a restart, and a drained log reports nothing pending
+static void test_pending_exact_after_early_seal() {
+  SampleLog log(*store);
+  log.begin();
+  appendRange(log, 0, 10);
+  store->failAppends = true;
+  TEST_ASSERT_FALSE(log.append(record(10)));
+  store->failAppends = false;
+  appendRange(log, 10, 15);
+  TEST_ASSERT_EQUAL_UINT32(15, log.pending());
+
+  SampleLog restarted(*store);
+  restarted.begin();
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(15, restarted.pending(), "after restart");
+  TEST_ASSERT_EQUAL_UINT32(15, drain(restarted, 0));
+  TEST_ASSERT_EQUAL_UINT32(0, restarted.pending());
+}
+
+// A torn frame at the tail of the head: begin() keeps the whole frames and seals it
+static void test_pending_exact_after_torn_tail() {
+  SampleLog log(*store);
+  log.begin();
+  appendRange(log, 0, 20);
+  const uint8_t torn[5] = { 0x5A, 0xA5, 1, 2, 3 };
+  store->append(0, torn, sizeof(torn));
+
+  SampleLog restarted(*store);
+  restarted.begin();
+  TEST_ASSERT_EQUAL_UINT32(20, restarted.pending());
+  appendRange(restarted, 20, 30);
+  TEST_ASSERT_EQUAL_UINT32(30, restarted.pending());
+  SampleLog again(*store);
+  again.begin();
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(30, again.pending(), "sealed segment counted by its size");
+  TEST_ASSERT_EQUAL_UINT32(30, drain(again, 0));
+}
+
+// Wrapping over an unread early-sealed segment drops only the records it held
+static void test_wrap_drops_what_was_there() {
+  SampleLog log(*store);
+  log.begin();
+  appendRange(log, 0, 10);
+  store->failAppends = true;
+  log.append(record(10));
+  store->failAppends = false;
+  uint32_t total = 10 + (SAMPLE_LOG_SEGMENTS - 1) * SAMPLE_LOG_SEG_RECORDS;
+  appendRange(log, 10, total);
+  TEST_ASSERT_EQUAL_UINT32(total, log.pending());
+  TEST_ASSERT_EQUAL_UINT32(0, log.dropped());
+  appendRange(log, total, total + 1);
+  TEST_ASSERT_EQUAL_UINT32(10, log.dropped());
+  TEST_ASSERT_EQUAL_UINT32(total + 1 - 10, log.pending());
+  TEST_ASSERT_EQUAL_UINT32(total + 1 - 10, drain(log, 10));
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_pending_counts_appended_records);
+  RUN_TEST(test_pending_exact_after_early_seal);
+  RUN_TEST(test_pending_exact_after_torn_tail);
+  RUN_TEST(test_wrap_drops_what_was_there);
+  return UNITY_END();
+}
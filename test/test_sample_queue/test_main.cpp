@@ -0,0 +1,77 @@
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <thread>
+#include <unity.h>
+#include "upload.h"
+
+#define QUEUE_TEST_ITEMS 200000
+
+void setUp() {}
+void tearDown() {}
+
+// Producer and consumer threads on SampleQueue. Lossless mode retries every full push, so
+// all items must arrive; in stall mode the consumer sleeps like a TLS handshake while the
+// producer keeps a fixed rate, so the drop policy kicks in. Either way items must arrive
+// in order without repeats, and received + dropped must equal pushed.
+static void stress(uint32_t items, bool stall) {
+  static SampleQueue queue;
+  uint32_t received = 0, errors = 0, retries = 0;
+  uint32_t droppedBefore = queue.dropped();
+
+  std::thread consumer([&]() {
+    SampleRecord batch[SAMPLE_QUEUE_DEPTH];
+    uint32_t expectMin = 0;
+    for (;;) {
+      size_t n = queue.popMany(batch, SAMPLE_QUEUE_DEPTH);
+      for (size_t i = 0; i < n; i++) {
+        // Drops leave gaps, but never reorder or repeat; soilRaw catches torn copies
+        if (batch[i].timestamp < expectMin || batch[i].soilRaw != (uint16_t)batch[i].timestamp) errors++;
+        expectMin = batch[i].timestamp + 1;
+        received++;
+        if (batch[i].flags == 0xFFFF) return;
+      }
+      if (stall && n > 0 && (expectMin & 0xFFF) < n) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+      else if (n == 0) std::this_thread::yield();
+    }
+  });
+
+  SampleRecord rec;
+  memset(&rec, 0, sizeof(rec));
+  for (uint32_t i = 0; i < items; i++) {
+    rec.timestamp = i;
+    rec.soilRaw = (uint16_t)i;
+    rec.flags = i + 1 == items ? 0xFFFF : 0;
+    // The end marker always gets through, so it is retried in both modes
+    while (!queue.push(rec) && (!stall || rec.flags == 0xFFFF)) {
+      retries++;
+      std::this_thread::yield();
+    }
+    if (stall && (i & 0xFF) == 0) std::this_thread::sleep_for(std::chrono::microseconds(50));
+  }
+  consumer.join();
+
+  uint32_t dropped = queue.dropped() - droppedBefore - retries;
+  char msg[128];
+  snprintf(msg, sizeof(msg), "pushed %u, received %u, dropped %u, full retries %u, high water %u",
+           (unsigned)items, (unsigned)received, (unsigned)dropped, (unsigned)retries, (unsigned)queue.highWater());
+  TEST_MESSAGE(msg);
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, errors, "order errors");
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(items, received + dropped, "received + dropped");
+  if (!stall) TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, dropped, "lossless drops");
+}
+
+static void test_lossless_producer_consumer() {
+  stress(QUEUE_TEST_ITEMS, false);
+}
+
+static void test_stalling_consumer_drops_in_order() {
+  stress(QUEUE_TEST_ITEMS / 10, true);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_lossless_producer_consumer);
+  RUN_TEST(test_stalling_consumer_drops_in_order);
+  return UNITY_END();
+}
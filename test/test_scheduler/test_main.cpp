@@ -0,0 +1,88 @@
+#include <stdint.h>
+#include <unity.h>
+#include "nodeConfig.h"
+#include "scheduler.h"
+
+// Stages that take fake time to run: sampling, serial output and an upload that now and
+// then blocks for several sample periods like a TLS handshake on a bad link
+#define SCHED_TEST_MS 600000
+#define SCHED_SAMPLE_MS 30
+#define SCHED_PRINT_MS 5
+#define SCHED_UPLOAD_MS 400
+#define SCHED_BLOCK_MS 7300
+#define SCHED_BLOCK_EVERY 5
+
+static Scheduler<3> sched(FakeClock::read);
+static uint32_t uploads, blocks, offGrid, catchUps, maxOnTime, lastSample, minGap;
+
+void setUp() {
+  FakeClock::set(0);
+  sched = Scheduler<3>(FakeClock::read);
+  uploads = blocks = offGrid = catchUps = maxOnTime = lastSample = 0;
+  minGap = UINT32_MAX;
+}
+
+void tearDown() {}
+
+static void sampleStage() {
+  const SchedTask& t = *sched.task(0);
+  uint32_t now = FakeClock::read();
+  if ((now - t.lastLate) % SAMPLE_INTERVAL != 0) offGrid++;
+  if (t.lastLate >= SAMPLE_INTERVAL) catchUps++;   // first run after a blocked upload
+  else if (t.lastLate > maxOnTime) maxOnTime = t.lastLate;
+  if (t.runs > 1 && now - lastSample < minGap) minGap = now - lastSample;
+  lastSample = now;
+  FakeClock::advance(SCHED_SAMPLE_MS);
+}
+
+static void printStage() {
+  FakeClock::advance(SCHED_PRINT_MS);
+}
+
+static void uploadStage() {
+  bool block = ++uploads % SCHED_BLOCK_EVERY == 0;
+  if (block) blocks++;
+  FakeClock::advance(block ? SCHED_BLOCK_MS : SCHED_UPLOAD_MS);
+}
+
+// Sampling stays on its grid however long the other stages take, is late by at most one
+// upload while nothing blocks, and after a blocked upload runs once and skips the slots
+// it missed instead of replaying them back to back
+static void test_sampling_holds_its_grid() {
+  sched.addTask("sample", sampleStage, SAMPLE_INTERVAL);
+  sched.addTask("print", printStage, SAMPLE_INTERVAL, 5);
+  // Starts shortly before each sample deadline, so every normal upload delays one
+  sched.addTask("upload", uploadStage, UPLOAD_INTERVAL, SAMPLE_INTERVAL - SCHED_UPLOAD_MS / 2);
+  const SchedTask& s = *sched.task(0);
+  uint32_t blocksSeen = 0;
+  // Ends on a sample run, so a block at the end has had its catch-up run
+  while (FakeClock::read() < SCHED_TEST_MS || blocks > blocksSeen) {
+    uint32_t runs = s.runs;
+    uint32_t wait = sched.tick();
+    if (s.runs != runs) blocksSeen = blocks;
+    FakeClock::advance(wait ? wait : 1);
+  }
+
+  TEST_ASSERT_GREATER_THAN(0, blocks);
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, offGrid, "samples off the grid");
+  TEST_ASSERT_GREATER_OR_EQUAL_UINT32_MESSAGE(SCHED_UPLOAD_MS / 2, maxOnTime, "on-time lateness");
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32_MESSAGE(SCHED_UPLOAD_MS + SCHED_PRINT_MS, maxOnTime, "on-time lateness");
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(blocks, catchUps, "catch-up runs");
+  // Every slot up to the next deadline was either run or skipped: no drift
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(s.next / SAMPLE_INTERVAL, s.runs + s.skipped, "slots run or skipped");
+  TEST_ASSERT_GREATER_OR_EQUAL_UINT32_MESSAGE(blocks * (SCHED_BLOCK_MS / SAMPLE_INTERVAL - 1), s.skipped,
+                                              "slots skipped");
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32_MESSAGE(blocks * (SCHED_BLOCK_MS / SAMPLE_INTERVAL), s.skipped, "slots skipped");
+  // A burst would run the missed slots back to back, one sample time apart
+  TEST_ASSERT_GREATER_OR_EQUAL_UINT32_MESSAGE(SAMPLE_INTERVAL / 4, minGap, "closest samples");
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32_MESSAGE(SAMPLE_INTERVAL, minGap, "closest samples");
+  const SchedTask& u = *sched.task(2);
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE((u.next - (SAMPLE_INTERVAL - SCHED_UPLOAD_MS / 2)) / UPLOAD_INTERVAL,
+                                   u.runs + u.skipped, "upload slots");
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_sampling_holds_its_grid);
+  return UNITY_END();
+}
@@ -0,0 +1,143 @@
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+#include "halSim.h"
+#include "nodeConfig.h"
+#include "sensors.h"
+
+#define REGISTRY_RUN_MS 60000
+
+static const MoistureCalPoint moisturePoints[] = { { 1200, 10000 }, { 1700, 6500 }, { 2800, 0 } };
+static const MoistureCal moistureCal = { moisturePoints, 3 };
+
+static SimDht simDht;
+static SimSoilTemp simSoil(2);
+static SimBaro simBaro;
+static SimAnalog simMoisture;
+static DhtSensor<SimDht> dhtSensor(simDht);
+static SoilTempSensor<SimSoilTemp> soilSensor(simSoil, 12);
+static BaroSensor<SimBaro> baroSensor(simBaro);
+static SoilMoistureSensor<SimAnalog> moistureSensor(simMoisture, &moistureCal);
+static auto sensors = makeSensorRegistry(baroSensor, dhtSensor, soilSensor, moistureSensor);
+typedef decltype(sensors) Registry;
+static_assert(Registry::FIELDS == (SAMPLE_HAS_BME280 | SAMPLE_HAS_DHT11 | SAMPLE_HAS_SOIL_TEMP |
+                                   SAMPLE_HAS_SOIL_MOISTURE), "registry fields");
+
+static JsonDocument doc;
+static SampleRecord rec;
+
+void setUp() {
+  simLogEnabled = false;
+  FakeClock::set(0);
+  sensors.begin(FakeClock::read());
+  doc.clear();
+}
+
+void tearDown() {}
+
+// Each sensor at its own period from a free-running poll loop, with a sample published
+// every SAMPLE_INTERVAL; returns how many of them carried every sensor's section
+static uint32_t freeRun(uint32_t& samples) {
+  uint32_t nextSample = FakeClock::read() + SAMPLE_INTERVAL, complete = 0;
+  uint32_t endMs = FakeClock::read() + REGISTRY_RUN_MS;
+  samples = 0;
+  while (FakeClock::read() < endMs) {
+    uint32_t wait = sensors.poll(FakeClock::read());
+    if (FakeClock::read() >= nextSample) {
+      doc.clear();
+      sensors.publish(FakeClock::read(), doc, rec);
+      samples++;
+      if (rec.flags == Registry::FIELDS) complete++;
+      nextSample += SAMPLE_INTERVAL;
+    }
+    uint32_t untilSample = nextSample - FakeClock::read();
+    FakeClock::advance(wait < untilSample ? wait : untilSample);
+  }
+  return complete;
+}
+
+static void test_nothing_read_in_warm_up() {
+  sensors.publish(0, doc, rec);
+  TEST_ASSERT_EQUAL_HEX16_MESSAGE(0, rec.flags, "fields before any read");
+  const char* dht11 = doc["dht11"].as<const char*>();
+  TEST_ASSERT_NOT_NULL(dht11);
+  TEST_ASSERT_EQUAL_STRING("pending", dht11);
+}
+
+// Each sensor at its own period, conversions collected after their time, and every
+// published sample on the grid carrying every sensor's section
+static void test_sensors_keep_their_periods() {
+  uint32_t samples;
+  uint32_t complete = freeRun(samples);
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(samples, complete, "complete samples");
+  SensorStats stats[Registry::COUNT];
+  sensors.stats(stats);
+  for (size_t i = 0; i < Registry::COUNT; i++) {
+    const SensorStats& st = stats[i];
+    TEST_ASSERT_UINT32_WITHIN_MESSAGE(1, REGISTRY_RUN_MS / st.periodMs, st.reads, st.name);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, st.skipped, st.name);
+  }
+  TEST_ASSERT_TRUE_MESSAGE(doc["soilMoisture"]["raw"].is<int>(), "soil moisture mean published");
+}
+
+// Aligned to sample boundaries off its own grid, the spacing a millisecond off now and then
+// as millis() sees SampleClock alarms: from the second boundary on, no sensor's newest read
+// in a sample may have started more than 1 ms before its boundary, and no sensor may run
+// faster than its period to get there
+static void test_reads_aligned_to_sample_boundaries() {
+  uint32_t samples;
+  freeRun(samples);
+  SensorStats stats[Registry::COUNT];
+  uint32_t boundary = FakeClock::read() + 1337, alignedAt = 0, stale = 0, incomplete = 0;
+  uint32_t maxDelay = 0, aligned = 0, lastDht = 0;
+  uint32_t dhtMinGap = UINT32_MAX;
+  bool pendingSample = false;
+  uint32_t endMs = FakeClock::read() + REGISTRY_RUN_MS;
+  while (FakeClock::read() < endMs) {
+    uint32_t now = FakeClock::read();
+    if (now >= boundary) {
+      sensors.align(now);
+      alignedAt = now;
+      pendingSample = true;
+      aligned++;
+      boundary += SAMPLE_INTERVAL + (aligned % 3 == 0 ? -1 : aligned % 3 == 1 ? 1 : 0);
+    }
+    uint32_t wait = sensors.poll(now);
+    if (pendingSample && !sensors.pending()) {
+      doc.clear();
+      sensors.publish(now, doc, rec);
+      pendingSample = false;
+      if (rec.flags != Registry::FIELDS) incomplete++;
+      if (now - alignedAt > maxDelay) maxDelay = now - alignedAt;
+      sensors.stats(stats);
+      for (size_t i = 0; i < Registry::COUNT; i++) {
+        if (aligned > 1 && stats[i].lastStart + 1 < alignedAt) stale++;
+      }
+      if (lastDht && stats[1].lastStart - lastDht < dhtMinGap) dhtMinGap = stats[1].lastStart - lastDht;
+      lastDht = stats[1].lastStart;
+      wait = 0;
+    }
+    uint32_t untilBoundary = boundary - FakeClock::read();
+    FakeClock::advance(wait < untilBoundary ? wait : untilBoundary);
+  }
+  char msg[96];
+  snprintf(msg, sizeof(msg), "%u aligned samples, published at most %u ms after the boundary",
+           (unsigned)aligned, (unsigned)maxDelay);
+  TEST_MESSAGE(msg);
+  TEST_ASSERT_GREATER_OR_EQUAL_UINT32_MESSAGE(REGISTRY_RUN_MS / SAMPLE_INTERVAL - 1, aligned, "aligned samples");
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32_MESSAGE(REGISTRY_RUN_MS / SAMPLE_INTERVAL, aligned, "aligned samples");
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, stale, "reads from before the boundary");
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, incomplete, "incomplete aligned samples");
+  TEST_ASSERT_GREATER_OR_EQUAL_UINT32_MESSAGE(DhtSensor<SimDht>::MIN_PERIOD_MS, dhtMinGap, "DHT11 period kept");
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32_MESSAGE(SAMPLE_INTERVAL + 1, dhtMinGap, "DHT11 period kept");
+  TEST_ASSERT_GREATER_OR_EQUAL_UINT32_MESSAGE(1, maxDelay, "publish delay ms");
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32_MESSAGE(1000, maxDelay, "publish delay ms");
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_nothing_read_in_warm_up);
+  RUN_TEST(test_sensors_keep_their_periods);
+  RUN_TEST(test_reads_aligned_to_sample_boundaries);
+  return UNITY_END();
+}
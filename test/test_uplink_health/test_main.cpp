@@ -0,0 +1,170 @@
+#include <stdio.h>
+#include <unity.h>
+#include "acquisition.h"
+#include "halSim.h"
+#include "nodeConfig.h"
+#include "posixBlockStore.h"
+#include "scheduler.h"
+#include "upload.h"
+#include "uplinkHealth.h"
+
+#define SOIL_TEMP_MARGIN 20
+
+static SimDht dht;
+static SimSoilTemp soilTemp(2);
+static SimBaro baro;
+static SimAnalog moisture;
+static const MoistureCalPoint moisturePoints[] = { { 1200, 10000 }, { 1700, 6500 }, { 2800, 0 } };
+static const MoistureCal moistureCal = { moisturePoints, 3 };
+static SensorHal hal = { &dht, &soilTemp, &baro, &moisture, &moistureCal, FakeClock::read };
+
+static SimUplink uplink;
+static UplinkHealth health(7);
+static GuardedUplink guarded(uplink, health, FakeClock::read);
+static bool useHealth;
+static SampleLog* offlineLog;
+static JsonDocument sampleDoc;
+static SampleRecord sampleRec;
+static bool sampleUploaded;
+static uint32_t samples, reauths;
+
+void setUp() {
+  simLogEnabled = false;
+  useHealth = false;
+  health = UplinkHealth(7);
+  uplink = SimUplink();
+  offlineLog = nullptr;
+  sampleUploaded = true;
+  samples = reauths = 0;
+  FakeClock::set(0);
+}
+
+void tearDown() {}
+
+static void soilConvTask() {
+  soilTemp.start(FakeClock::read());
+}
+
+static void sampleTask() {
+  sampleDoc.clear();
+  readSensorData(hal, FakeClock::read(), sampleDoc, sampleRec);
+  samples++;
+  sampleUploaded = false;
+}
+
+static void uploadTask() {
+  Uplink* up = useHealth ? uploadGate(guarded, FakeClock::read()) : &uplink;
+  uploadCycle(up, offlineLog, sampleDoc, !sampleUploaded, FakeClock::read());
+  if (useHealth && health.takeReauth()) reauths++;   // the device refreshes its token here
+  sampleUploaded = true;
+}
+
+static void classifies(const char* reason, UplinkError want) {
+  TEST_ASSERT_EQUAL_INT_MESSAGE(want, classifyUplinkError(reason), reason);
+}
+
+static void test_errors_classified() {
+  classifies("connection refused", UPLINK_ERR_NETWORK);
+  classifies("response payload read timed out", UPLINK_ERR_NETWORK);
+  classifies("service unavailable", UPLINK_ERR_SERVER);
+  classifies("server error", UPLINK_ERR_SERVER);
+  classifies("Permission denied", UPLINK_ERR_AUTH);
+  classifies("token is not ready (revoked or expired)", UPLINK_ERR_AUTH);
+  classifies("too many requests", UPLINK_ERR_RATE);
+  classifies("bad request", UPLINK_ERR_REQUEST);
+  classifies("payload too large", UPLINK_ERR_REQUEST);
+}
+
+// One step of the outage script
+struct OutagePhase {
+  const char* name;
+  uint32_t ms;
+  bool online;
+  const char* reason;
+  uint32_t failDelayMs;     // what each failed request blocks the loop for
+};
+
+static const OutagePhase outageScript[] = {
+  { "online", 60000, true, "", 0 },
+  { "network down", 600000, false, "response payload read timed out", 5000 },
+  { "recovered", 180000, true, "", 0 },
+  { "token rejected", 20000, false, "permission denied", 300 },
+  { "recovered", 60000, true, "", 0 },
+  { "HTTP 503", 120000, false, "service unavailable", 300 },
+  { "rate limited", 60000, false, "too many requests", 300 },
+  { "recovered", 600000, true, "", 0 },
+};
+
+struct OutageResult {
+  uint32_t samples;
+  uint32_t expected;
+  uint32_t outageRequests;
+  uint32_t pending;
+};
+
+// The pipeline through the outage script on the fake clock, with the flash log behind it
+static OutageResult outageRun(bool gated) {
+  useHealth = gated;
+  TempBlockStore store("/tmp/outage");
+  SampleLog log(store);
+  TEST_ASSERT_TRUE(store.ok() && log.begin());
+  offlineLog = &log;
+
+  Scheduler<4> sched(FakeClock::read);
+  int sampleId = sched.addTask("sample", sampleTask, SAMPLE_INTERVAL);
+  sched.addTask("upload", uploadTask, UPLOAD_INTERVAL, 20);
+  sched.addTask("soilConv", soilConvTask, SAMPLE_INTERVAL,
+                SAMPLE_INTERVAL - soilTemp.conversionMs() - SOIL_TEMP_MARGIN);
+
+  OutageResult r = {};
+  uint32_t totalMs = 0;
+  for (const OutagePhase& p : outageScript) {
+    uplink.online = p.online;
+    uplink.reason = p.reason;
+    uplink.failDelayMs = p.failDelayMs;
+    uint32_t end = FakeClock::read() + p.ms;
+    uint32_t samples0 = samples, requests0 = uplink.requests, skipped0 = sched.task(sampleId)->skipped;
+    while ((int32_t)(FakeClock::read() - end) < 0) {
+      uint32_t wait = sched.tick();
+      FakeClock::advance(wait ? wait : 1);
+    }
+    totalMs += p.ms;
+    uint32_t requests = uplink.requests - requests0;
+    if (!p.online) r.outageRequests += requests;
+    printf("  %-15s %4u s: %4u samples, %3u skipped, %4u requests, %s, %u pending\n", p.name,
+           (unsigned)(p.ms / 1000), (unsigned)(samples - samples0),
+           (unsigned)(sched.task(sampleId)->skipped - skipped0), (unsigned)requests,
+           gated ? UplinkHealth::stateName(health.state()) : "-", (unsigned)log.pending());
+  }
+  r.samples = samples;
+  r.expected = totalMs / SAMPLE_INTERVAL;
+  r.pending = log.pending();
+  offlineLog = nullptr;
+  return r;
+}
+
+// Sampling must hold its rate through every outage, the dead backend must see a handful
+// of probes rather than a request per tick, and once it is back the log must drain
+static void test_outage_script_with_health_gate() {
+  OutageResult r = outageRun(true);
+  TEST_ASSERT_GREATER_OR_EQUAL_UINT32_MESSAGE(r.expected * 98 / 100, r.samples, "samples kept");
+  TEST_ASSERT_LESS_THAN_MESSAGE(60, r.outageRequests, "requests during outages");
+  TEST_ASSERT_GREATER_THAN_MESSAGE(0, reauths, "token refreshed");
+  TEST_ASSERT_GREATER_THAN_MESSAGE(0, health.opens, "circuit opened");
+  TEST_ASSERT_EQUAL_INT_MESSAGE(LINK_CONNECTED, health.state(), "state after recovery");
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, r.pending, "log drained");
+}
+
+// The same script retrying every tick: what the gate saves
+static void test_outage_script_without_gate() {
+  OutageResult r = outageRun(false);
+  TEST_ASSERT_GREATER_THAN_MESSAGE(60, r.outageRequests, "requests during outages");
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_errors_classified);
+  RUN_TEST(test_outage_script_with_health_gate);
+  RUN_TEST(test_outage_script_without_gate);
+  return UNITY_END();
+}
@@ -0,0 +1,175 @@
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+#include "halSim.h"
+#include "nodeConfig.h"
+#include "posixBlockStore.h"
+#include "upload.h"
+
+#define OUTAGE_WINDOWS (AGG_PENDING_WINDOWS * 3 / 2)
+#define WINDOW_SAMPLES (AGG_WINDOW_MS / SAMPLE_INTERVAL)
+
+static TempBlockStore* store;
+static TempBlockStore* windowStore;
+static SampleLog* sampleLog;
+static WindowLog* windowLog;
+static SampleQueue queue;
+static const uint64_t t0 = 1760000000000ULL / AGG_WINDOW_MS * AGG_WINDOW_MS;
+
+void setUp() {
+  simLogEnabled = false;
+  store = new TempBlockStore("/tmp/windows");
+  windowStore = new TempBlockStore("/tmp/winlog");
+  sampleLog = new SampleLog(*store);
+  windowLog = new WindowLog(*windowStore);
+  TEST_ASSERT_TRUE(store->ok() && sampleLog->begin());
+  TEST_ASSERT_TRUE(windowStore->ok() && windowLog->begin());
+  SampleRecord rec;
+  while (queue.pop(rec)) {
+  }
+}
+
+void tearDown() {
+  delete windowLog;
+  delete sampleLog;
+  delete windowStore;
+  delete store;
+}
+
+static SampleRecord record(uint64_t timestamp) {
+  SampleRecord rec;
+  memset(&rec, 0, sizeof(rec));
+  rec.timestamp = timestamp;
+  rec.flags = SAMPLE_HAS_SOIL_MOISTURE;
+  return rec;
+}
+
+static bool delivered(CaptureUplink& uplink, uint64_t start) {
+  char key[32];
+  snprintf(key, sizeof(key), "windows/%llu", (unsigned long long)start);
+  return uplink.written.count(key) > 0;
+}
+
+// One sample per upload tick from t, raw uploads off, for ticks ticks; returns the next timestamp
+static uint64_t run(CaptureUplink& uplink, WindowLog* winLog, WindowAggregator& agg, uint64_t t, uint32_t ticks) {
+  for (uint32_t i = 0; i < ticks; i++, t += SAMPLE_INTERVAL) {
+    queue.push(record(t));
+    uploadQueueWindows(&uplink, sampleLog, winLog, queue, agg, false, FakeClock::read());
+  }
+  return t;
+}
+
+// Aggregated mode with raw uploads off still replays what the log holds from before
+static void test_backlog_replayed_without_raw_uploads() {
+  uint64_t t = t0;
+  for (uint32_t i = 0; i < SAMPLE_LOG_BATCH * 3; i++, t += SAMPLE_INTERVAL) sampleLog->append(record(t));
+  SimUplink uplink;
+  WindowAggregator agg;
+  uint32_t ticks = 0;
+  for (; ticks < 10 && sampleLog->pending() > 0; ticks++, t += SAMPLE_INTERVAL) {
+    queue.push(record(t));
+    uploadQueueWindows(&uplink, sampleLog, windowLog, queue, agg, false, FakeClock::read());
+  }
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, sampleLog->pending(), "backlog left");
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(3, ticks);
+}
+
+// An outage half again as long as the memory queue: every summary closed meanwhile waits on
+// flash and goes up once the link is back, in batches, none dropped
+static void test_long_outage_kept_on_flash() {
+  CaptureUplink uplink;
+  WindowAggregator agg;
+  uint32_t dropped = windowsDropped;
+  uint64_t t = run(uplink, windowLog, agg, t0, WINDOW_SAMPLES);
+  uplink.online = false;
+  t = run(uplink, windowLog, agg, t, OUTAGE_WINDOWS * WINDOW_SAMPLES);
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(OUTAGE_WINDOWS, windowLog->pending(), "summaries on flash");
+  uplink.online = true;
+  run(uplink, windowLog, agg, t, OUTAGE_WINDOWS / WINDOW_LOG_BATCH + 2);
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, windowLog->pending(), "summaries left on flash");
+  uint32_t missing = 0;
+  for (uint32_t w = 0; w <= OUTAGE_WINDOWS; w++) missing += !delivered(uplink, t0 + w * AGG_WINDOW_MS);
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, missing, "summaries not delivered");
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(dropped, windowsDropped, "summaries dropped");
+  TEST_ASSERT_EQUAL_UINT32(0, windowLog->dropped());
+}
+
+// A reboot in the outage: the summaries stored before it still go up
+static void test_stored_summaries_survive_a_restart() {
+  CaptureUplink uplink;
+  WindowAggregator agg;
+  uplink.online = false;
+  uint64_t t = run(uplink, windowLog, agg, t0, 4 * WINDOW_SAMPLES);
+  TEST_ASSERT_EQUAL_UINT32(3, windowLog->pending());
+  delete windowLog;
+  windowLog = new WindowLog(*windowStore);
+  TEST_ASSERT_TRUE(windowLog->begin());
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(3, windowLog->pending(), "summaries after the restart");
+  WindowAggregator restarted;
+  uplink.online = true;
+  run(uplink, windowLog, restarted, t, 1);
+  TEST_ASSERT_EQUAL_UINT32(0, windowLog->pending());
+  for (uint32_t w = 0; w < 3; w++) TEST_ASSERT_TRUE(delivered(uplink, t0 + w * AGG_WINDOW_MS));
+}
+
+// Without a window log the same outage keeps the newest AGG_PENDING_WINDOWS in memory and
+// drops the older ones, each counted. The window open when the link comes back closes with
+// the next sample and is still pending.
+static void test_long_outage_without_window_log() {
+  CaptureUplink uplink;
+  WindowAggregator agg;
+  uint32_t dropped = windowsDropped;
+  uint64_t start = t0 + 1000 * AGG_WINDOW_MS;
+  uplink.online = false;
+  uint64_t t = run(uplink, nullptr, agg, start, OUTAGE_WINDOWS * WINDOW_SAMPLES);
+  uplink.online = true;
+  run(uplink, nullptr, agg, t, WINDOW_SAMPLES);
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(OUTAGE_WINDOWS - AGG_PENDING_WINDOWS, windowsDropped - dropped, "summaries dropped");
+  uint32_t got = 0;
+  for (uint32_t w = 0; w < OUTAGE_WINDOWS; w++) {
+    bool newest = w >= OUTAGE_WINDOWS - AGG_PENDING_WINDOWS;
+    bool d = delivered(uplink, start + w * AGG_WINDOW_MS);
+    got += d;
+    TEST_ASSERT_TRUE_MESSAGE(d == newest, newest ? "newer summary lost" : "dropped summary delivered");
+  }
+  TEST_ASSERT_EQUAL_UINT32(AGG_PENDING_WINDOWS, got);
+}
+
+// An update the uplink cannot take whole is split until it fits instead of being retried
+// as it is: the stored summaries in smaller batches, the pending ones in smaller updates
+// with the live nodes on the newest
+static void test_too_large_updates_split() {
+  CaptureUplink uplink;
+  WindowAggregator agg;
+  uplink.online = false;
+  uint64_t t = run(uplink, windowLog, agg, t0, (WINDOW_LOG_BATCH + 1) * WINDOW_SAMPLES);
+  TEST_ASSERT_EQUAL_UINT32(WINDOW_LOG_BATCH, windowLog->pending());
+  uplink.online = true;
+  uplink.maxNodes = 3;
+  run(uplink, windowLog, agg, t, WINDOW_LOG_BATCH);
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, windowLog->pending(), "stored summaries left");
+  TEST_ASSERT_GREATER_THAN_UINT32(0, uplink.tooLarge);
+  for (uint32_t w = 0; w < WINDOW_LOG_BATCH; w++) TEST_ASSERT_TRUE(delivered(uplink, t0 + w * AGG_WINDOW_MS));
+
+  // Three windows close in one tick: three summaries and the live nodes are too many
+  WindowAggregator burst;
+  uint64_t start = t0 + 2000 * AGG_WINDOW_MS;
+  for (uint32_t w = 0; w < 4; w++) queue.push(record(start + w * AGG_WINDOW_MS));
+  uplink.tooLarge = 0;
+  uplink.written.clear();
+  TEST_ASSERT_EQUAL_UINT32(3, uploadQueueWindows(&uplink, sampleLog, windowLog, queue, burst, false, 0));
+  TEST_ASSERT_GREATER_THAN_UINT32(0, uplink.tooLarge);
+  TEST_ASSERT_EQUAL_UINT32(0, windowLog->pending());
+  TEST_ASSERT_TRUE_MESSAGE(uplink.nodes.count("lastReadings/latest") > 0, "live nodes with the newest");
+  for (uint32_t w = 0; w < 3; w++) TEST_ASSERT_TRUE(delivered(uplink, start + w * AGG_WINDOW_MS));
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_backlog_replayed_without_raw_uploads);
+  RUN_TEST(test_long_outage_kept_on_flash);
+  RUN_TEST(test_stored_summaries_survive_a_restart);
+  RUN_TEST(test_long_outage_without_window_log);
+  RUN_TEST(test_too_large_updates_split);
+  return UNITY_END();
+}
@@ -0,0 +1,98 @@
+#include <string.h>
+#include <unity.h>
+#include "nodeConfig.h"
+#include "windowStats.h"
+
+static const uint64_t t0 = 1760000000000ULL / AGG_WINDOW_MS * AGG_WINDOW_MS;
+
+void setUp() {}
+void tearDown() {}
+
+static SampleRecord record(uint64_t timestamp, uint16_t flags = 0) {
+  SampleRecord rec;
+  memset(&rec, 0, sizeof(rec));
+  rec.timestamp = timestamp;
+  rec.flags = SAMPLE_HAS_SOIL_MOISTURE | flags;
+  rec.soilMoisture = 5000;
+  return rec;
+}
+
+static void test_windows_close_on_their_boundary() {
+  WindowAggregator agg;
+  uint32_t closed = 0;
+  for (uint64_t t = t0; t < t0 + 3 * AGG_WINDOW_MS; t += SAMPLE_INTERVAL) {
+    if (!agg.add(record(t))) continue;
+    closed++;
+    TEST_ASSERT_EQUAL_UINT64(t - AGG_WINDOW_MS, agg.closed().start);
+    TEST_ASSERT_EQUAL_UINT64(t, agg.closed().end);
+    TEST_ASSERT_EQUAL_UINT32(AGG_WINDOW_MS / SAMPLE_INTERVAL, agg.closed().count);
+    TEST_ASSERT_EQUAL_HEX16(0, agg.closed().flags);
+  }
+  TEST_ASSERT_EQUAL_UINT32(2, closed);
+  TEST_ASSERT_TRUE(agg.flush());
+  JsonDocument doc;
+  windowToJson(agg.closed(), doc.to<JsonObject>());
+  TEST_ASSERT_FALSE_MESSAGE(doc["unsynced"].is<bool>(), "synced window flagged");
+  TEST_ASSERT_EQUAL_UINT32(5000, doc["soilMoisture"]["percentage"]["mean"].as<float>() * 100);
+}
+
+// Provisional keys before the first fix get a window of their own, keyed by their first key
+// so it cannot land on a synced window's path, and flagged in the summary
+static void test_unsynced_samples_kept_apart() {
+  WindowAggregator agg;
+  uint64_t t = t0 + 20001;
+  for (int i = 0; i < 3; i++, t += SAMPLE_INTERVAL) TEST_ASSERT_FALSE(agg.add(record(t, SAMPLE_UNSYNCED)));
+  TEST_ASSERT_TRUE_MESSAGE(agg.add(record(t0 + 30000)), "first synced sample closes the window");
+  const WindowSummary& w = agg.closed();
+  TEST_ASSERT_EQUAL_UINT64(t0 + 20001, w.start);
+  TEST_ASSERT_EQUAL_UINT32(3, w.count);
+  TEST_ASSERT_EQUAL_HEX16(SAMPLE_UNSYNCED, w.flags);
+  JsonDocument doc;
+  windowToJson(w, doc.to<JsonObject>());
+  TEST_ASSERT_TRUE(doc["unsynced"].as<bool>());
+  TEST_ASSERT_TRUE(agg.flush());
+  TEST_ASSERT_EQUAL_UINT64(t0, agg.closed().start);
+  TEST_ASSERT_EQUAL_UINT32(1, agg.closed().count);
+  TEST_ASSERT_EQUAL_HEX16(0, agg.closed().flags);
+}
+
+// A key from before the window closes it rather than being folded in, and since its
+// boundary comes before one already used, its window is flagged. Then the clock steps back
+// 30 s: the boundaries that come round again (provisional) go to a window of their own, and
+// the synced samples after them, whose boundary the first window already used, start a
+// flagged window at their own key instead of overwriting it.
+static void test_step_back_closes_the_window() {
+  WindowAggregator agg;
+  for (uint64_t t = t0 + AGG_WINDOW_MS; t <= t0 + AGG_WINDOW_MS + 40000; t += SAMPLE_INTERVAL) {
+    TEST_ASSERT_FALSE(agg.add(record(t)));
+  }
+  TEST_ASSERT_TRUE_MESSAGE(agg.add(record(t0 + 59000)), "sample before the window closes it");
+  TEST_ASSERT_EQUAL_UINT64(t0 + AGG_WINDOW_MS, agg.closed().start);
+  TEST_ASSERT_EQUAL_UINT32(21, agg.closed().count);
+  TEST_ASSERT_TRUE(agg.flush());
+  TEST_ASSERT_EQUAL_UINT64(t0 + 59000, agg.closed().start);
+  TEST_ASSERT_EQUAL_HEX16(SAMPLE_UNSYNCED, agg.closed().flags);
+
+  uint64_t t = t0 + AGG_WINDOW_MS + 10001;
+  TEST_ASSERT_FALSE(agg.add(record(t, SAMPLE_UNSYNCED)));
+  TEST_ASSERT_TRUE(agg.add(record(t0 + AGG_WINDOW_MS + 42000)));
+  TEST_ASSERT_EQUAL_UINT64(t, agg.closed().start);
+  TEST_ASSERT_EQUAL_HEX16(SAMPLE_UNSYNCED, agg.closed().flags);
+
+  TEST_ASSERT_TRUE(agg.add(record(t0 + 2 * AGG_WINDOW_MS)));
+  const WindowSummary& reused = agg.closed();
+  TEST_ASSERT_EQUAL_UINT64_MESSAGE(t0 + AGG_WINDOW_MS + 42000, reused.start, "reused boundary keyed by its first sample");
+  TEST_ASSERT_EQUAL_UINT64(t0 + 2 * AGG_WINDOW_MS, reused.end);
+  TEST_ASSERT_EQUAL_HEX16(SAMPLE_UNSYNCED, reused.flags);
+  TEST_ASSERT_TRUE(agg.flush());
+  TEST_ASSERT_EQUAL_UINT64_MESSAGE(t0 + 2 * AGG_WINDOW_MS, agg.closed().start, "next boundary synced again");
+  TEST_ASSERT_EQUAL_HEX16(0, agg.closed().flags);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_windows_close_on_their_boundary);
+  RUN_TEST(test_unsynced_samples_kept_apart);
+  RUN_TEST(test_step_back_closes_the_window);
+  return UNITY_END();
+}